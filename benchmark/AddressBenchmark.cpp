@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+#include <coco/ip.hpp>
+
+
+/*
+    AddressBenchmark: Parsing and formatting of IPv4 and IPv6 addresses and endpoints, e.g. when reading a
+    configuration or logging the sender of each datagram.
+*/
+
+using namespace coco;
+
+namespace {
+
+const String V4_ADDRESSES[] = {"127.0.0.1", "192.168.100.200", "10.0.0.255", "255.255.255.255"};
+const String V6_ADDRESSES[] = {"::1", "fe80::1ff:fe23:4567:890a", "2001:db8:85a3:8d3:1319:8a2e:370:7348",
+    "::ffff:192.168.1.1"};
+
+} // namespace
+
+
+static void parseV4Address(benchmark::State &state) {
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ip::v4::Address::fromString(V4_ADDRESSES[i]));
+        i = (i + 1) & 3;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(parseV4Address);
+
+static void parseV4Endpoint(benchmark::State &state) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ip::v4::Endpoint::fromString("192.168.100.200:65535"));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(parseV4Endpoint);
+
+static void parseV6Address(benchmark::State &state) {
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ip::v6::Address::fromString(V6_ADDRESSES[i]));
+        i = (i + 1) & 3;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(parseV6Address);
+
+static void parseV6Endpoint(benchmark::State &state) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ip::v6::Endpoint::fromString("[fe80::1ff:fe23:4567:890a%2]:65535"));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(parseV6Endpoint);
+
+static void formatV4Endpoint(benchmark::State &state) {
+    auto endpoint = *ip::v4::Endpoint::fromString("192.168.100.200:65535");
+    char buffer[ip::v4::Endpoint::MAX_STRING_LENGTH];
+    for (auto _ : state)
+        benchmark::DoNotOptimize(endpoint.toString(buffer));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(formatV4Endpoint);
+
+static void formatV6Endpoint(benchmark::State &state) {
+    auto endpoint = *ip::v6::Endpoint::fromString("[2001:db8:85a3:8d3:1319:8a2e:370:7348]:65535");
+    char buffer[ip::v6::Endpoint::MAX_STRING_LENGTH];
+    for (auto _ : state)
+        benchmark::DoNotOptimize(endpoint.toString(buffer));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(formatV6Endpoint);
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include <coco/packet.hpp>
+#include <random>
+#include <vector>
+
+
+/*
+    ChecksumBenchmark: Internet checksum (RFC 1071) of an IPv4 header, small and MTU sized datagrams, a jumbo frame and
+    a maximum sized datagram, once with the textbook scalar loop over 16 bit words as reference and once with
+    coco::ip::checksum() that uses the SIMD kernel selected for the CPU (see checksumKernel()).
+*/
+
+using namespace coco;
+
+namespace {
+
+std::vector<uint8_t> &getData() {
+    static std::vector<uint8_t> data = [] {
+        std::vector<uint8_t> data(65536);
+        std::mt19937 random(1);
+        for (auto &x : data)
+            x = random();
+        return data;
+    }();
+    return data;
+}
+
+// reference implementation of RFC 1071
+uint16_t referenceChecksum(const uint8_t *data, int size) {
+    uint32_t sum = 0;
+    while (size > 1) {
+        sum += data[0] << 8 | data[1];
+        data += 2;
+        size -= 2;
+    }
+    if (size > 0)
+        sum += data[0] << 8;
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum;
+}
+
+} // namespace
+
+
+static void checksumReference(benchmark::State &state) {
+    auto &data = getData();
+    int size = state.range(0);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(referenceChecksum(data.data(), size));
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(checksumReference)->Arg(20)->Arg(64)->Arg(576)->Arg(1500)->Arg(9000)->Arg(65535);
+
+static void checksum(benchmark::State &state) {
+    auto &data = getData();
+    int size = state.range(0);
+    state.SetLabel(ip::checksumKernel());
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ip::checksum(data.data(), size));
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(checksum)->Arg(20)->Arg(64)->Arg(576)->Arg(1500)->Arg(9000)->Arg(65535);
+
+static void checksumUpdate(benchmark::State &state) {
+    // decrement the time to live of an IPv4 header as a router does
+    uint16_t checksum = 0x1234;
+    uint16_t word = 0x4011;
+    for (auto _ : state) {
+        uint16_t next = word - 0x100;
+        checksum = ip::checksumUpdate(checksum, word, next);
+        word = next;
+        benchmark::DoNotOptimize(checksum);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(checksumUpdate);
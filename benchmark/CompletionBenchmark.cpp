@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include <coco/platform/UdpSocket_native.hpp>
+#include <memory>
+#include <vector>
+
+
+/*
+    CompletionBenchmark: Cost per completion depending on the number of receive buffers that are in flight on one
+    socket. A sender keeps sending datagrams to itself on the loopback interface and the time per received datagram
+    is measured. The cost should stay flat from 1 to 4096 buffers.
+*/
+
+using namespace coco;
+
+namespace {
+
+constexpr int DATAGRAM_COUNT = 10000;
+
+Coroutine sender(Buffer &buffer) {
+    const uint8_t data[] = {1, 2, 3, 4};
+    while (true) {
+        co_await buffer.writeArray(data);
+        if (!buffer.ready())
+            co_return;
+    }
+}
+
+Coroutine receiver(Loop &loop, Buffer &buffer, int &remaining) {
+    while (true) {
+        co_await buffer.read();
+        if (!buffer.ready())
+            co_return;
+        if (--remaining == 0)
+            loop.exit();
+    }
+}
+
+// socket and buffers, the coroutines return when the socket gets closed
+struct Fixture {
+    Loop_native loop;
+    UdpSocket_native socket{loop};
+    std::vector<std::unique_ptr<UdpSocket_native::Buffer>> buffers;
+    int remaining = 0;
+
+    Fixture(int bufferCount, uint16_t port) {
+        socket.open(ip::v4::PROTOCOL_ID, port);
+
+        // send buffer, sends to itself
+        auto &sendBuffer = *buffers.emplace_back(std::make_unique<UdpSocket_native::Buffer>(socket, 64));
+        sendBuffer.header<ip::v4::Endpoint>() = {.port = port, .address = *ip::v4::Address::fromString("127.0.0.1")};
+        sender(sendBuffer);
+
+        // receive buffers
+        for (int i = 0; i < bufferCount; ++i) {
+            auto &buffer = *buffers.emplace_back(std::make_unique<UdpSocket_native::Buffer>(socket, 64));
+            receiver(loop, buffer, remaining);
+        }
+    }
+
+    // close the socket first so that the coroutines waiting on the buffers return
+    ~Fixture() {
+        socket.close();
+    }
+};
+
+} // namespace
+
+
+static void completion(benchmark::State &state) {
+    int bufferCount = state.range(0);
+
+    // each run uses a new port
+    static uint16_t port = 21000;
+    Fixture fixture(bufferCount, ++port);
+
+    for (auto _ : state) {
+        fixture.remaining = DATAGRAM_COUNT;
+        fixture.loop.run();
+    }
+    state.SetItemsProcessed(state.iterations() * DATAGRAM_COUNT);
+    state.counters["buffers"] = bufferCount;
+}
+BENCHMARK(completion)->RangeMultiplier(4)->Range(1, 4096)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+#include <coco/EndpointMap.hpp>
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+
+/*
+    EndpointMapBenchmark: Cost of a per-packet peer lookup in EndpointMap compared to std::unordered_map with the
+    same hash function, from 1K up to 10M peers. Half of the peers are IPv4, half are IPv6. The lookups are random,
+    therefore the large sizes measure mostly cache misses where EndpointMap needs one miss for the control bytes and
+    one for the entry.
+*/
+
+using namespace coco;
+
+namespace {
+
+struct Hash {
+    size_t operator ()(const ip::Endpoint &endpoint) const {return endpoint.hash();}
+};
+
+// peers in random order
+std::vector<ip::Endpoint> makeEndpoints(int count) {
+    std::mt19937_64 random(count);
+    std::vector<ip::Endpoint> endpoints;
+    endpoints.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        uint64_t r = random();
+        if (i % 2 == 0) {
+            endpoints.push_back({.v4 = {.port = uint16_t(r), .address = {.u32 = {uint32_t(r >> 16)}}}});
+        } else {
+            endpoints.push_back({.v6 = {.port = uint16_t(r),
+                .address = {.u32 = {0x20010db8, 0, uint32_t(i), uint32_t(r >> 16)}}}});
+        }
+    }
+    return endpoints;
+}
+
+// lookup order that differs from the insertion order
+std::vector<ip::Endpoint> shuffle(std::vector<ip::Endpoint> endpoints) {
+    std::shuffle(endpoints.begin(), endpoints.end(), std::mt19937_64(1));
+    return endpoints;
+}
+
+} // namespace
+
+
+static void endpointHash(benchmark::State &state) {
+    auto endpoints = makeEndpoints(1024);
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (auto &endpoint : endpoints)
+            sum += endpoint.hash();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * endpoints.size());
+}
+BENCHMARK(endpointHash);
+
+static void endpointMapFind(benchmark::State &state) {
+    int count = state.range(0);
+    auto endpoints = makeEndpoints(count);
+    EndpointMap<uint64_t> map(count);
+    for (auto &endpoint : endpoints)
+        map.emplace(endpoint, 0);
+    endpoints = shuffle(std::move(endpoints));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        ++*map.find(endpoints[i]);
+        if (++i == endpoints.size())
+            i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(endpointMapFind)->RangeMultiplier(10)->Range(1000, 10000000);
+
+static void unorderedMapFind(benchmark::State &state) {
+    int count = state.range(0);
+    auto endpoints = makeEndpoints(count);
+    std::unordered_map<ip::Endpoint, uint64_t, Hash> map(count);
+    for (auto &endpoint : endpoints)
+        map.emplace(endpoint, 0);
+    endpoints = shuffle(std::move(endpoints));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        ++map.find(endpoints[i])->second;
+        if (++i == endpoints.size())
+            i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(unorderedMapFind)->RangeMultiplier(10)->Range(1000, 10000000);
+
+static void endpointMapInsertErase(benchmark::State &state) {
+    int count = state.range(0);
+    auto endpoints = makeEndpoints(count * 2);
+    EndpointMap<uint64_t> map(count);
+    for (int i = 0; i < count; ++i)
+        map.emplace(endpoints[i], 0);
+
+    // sliding window of peers: insert a new one, erase the oldest one
+    size_t i = 0;
+    for (auto _ : state) {
+        map.emplace(endpoints[(i + count) % endpoints.size()], 0);
+        map.erase(endpoints[i]);
+        if (++i == endpoints.size())
+            i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(endpointMapInsertErase)->RangeMultiplier(10)->Range(1000, 10000000);
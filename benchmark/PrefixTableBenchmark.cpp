@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+#include <coco/AccessList.hpp>
+#include <random>
+#include <vector>
+
+
+/*
+    PrefixTableBenchmark: Cost of a longest prefix match in tables of 500k IPv4 or IPv6 prefixes, for single lookups
+    and for batched lookups of 64 addresses (the batch size of a recvmmsg() call). The IPv6 prefixes are /32 and /48
+    below 2000 allocations in 2001::/16, the IPv4 prefixes have random lengths from /8 to /32.
+*/
+
+using namespace coco;
+
+namespace {
+
+constexpr int PREFIX_COUNT = 500000;
+constexpr int ADDRESS_COUNT = 1 << 20;
+constexpr int BATCH = 64;
+
+struct Tables {
+    ip::v4::PrefixTable table4;
+    ip::v6::PrefixTable table6;
+    std::vector<ip::v4::Address> addresses4;
+    std::vector<ip::v6::Address> addresses6;
+
+    Tables() {
+        std::mt19937_64 random(1);
+        std::vector<ip::v4::PrefixTable::Entry> entries4;
+        std::vector<ip::v6::PrefixTable::Entry> entries6;
+        for (int i = 0; i < PREFIX_COUNT; ++i) {
+            ip::PrefixValue value = 1 + i % 2;
+
+            ip::v4::Prefix prefix4 = {.address = {.u32 = {uint32_t(random())}}, .length = 8 + int(random() % 25)};
+            entries4.push_back({prefix4, value});
+
+            ip::v6::Prefix prefix6 = {.address = {.u32 = {0x20010000 | uint32_t(random() % 2000) << 4,
+                uint32_t(random()), 0, 0}}, .length = i % 10 == 0 ? 32 : 48};
+            entries6.push_back({prefix6, value});
+        }
+        this->table4.build(entries4);
+        this->table6.build(entries6);
+
+        // addresses that fall into the prefixes, the IPv4 prefixes cover most of the address space anyway
+        for (int i = 0; i < ADDRESS_COUNT; ++i) {
+            this->addresses4.push_back({.u32 = {uint32_t(random())}});
+            auto address6 = entries6[random() % PREFIX_COUNT].prefix.address;
+            address6.u32[3] = uint32_t(random());
+            this->addresses6.push_back(address6);
+        }
+    }
+};
+
+Tables &getTables() {
+    static Tables tables;
+    return tables;
+}
+
+} // namespace
+
+
+static void prefixTable4(benchmark::State &state) {
+    auto &tables = getTables();
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tables.table4.lookup(tables.addresses4[i]));
+        i = (i + 1) & (ADDRESS_COUNT - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(prefixTable4);
+
+static void prefixTable4Batch(benchmark::State &state) {
+    auto &tables = getTables();
+    ip::PrefixValue values[BATCH];
+    int i = 0;
+    for (auto _ : state) {
+        tables.table4.lookup({&tables.addresses4[i], BATCH}, values);
+        benchmark::DoNotOptimize(values);
+        i = (i + BATCH) & (ADDRESS_COUNT - 1);
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH);
+}
+BENCHMARK(prefixTable4Batch);
+
+static void prefixTable6(benchmark::State &state) {
+    auto &tables = getTables();
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tables.table6.lookup(tables.addresses6[i]));
+        i = (i + 1) & (ADDRESS_COUNT - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(prefixTable6);
+
+static void prefixTable6Batch(benchmark::State &state) {
+    auto &tables = getTables();
+    ip::PrefixValue values[BATCH];
+    int i = 0;
+    for (auto _ : state) {
+        tables.table6.lookup({&tables.addresses6[i], BATCH}, values);
+        benchmark::DoNotOptimize(values);
+        i = (i + BATCH) & (ADDRESS_COUNT - 1);
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH);
+}
+BENCHMARK(prefixTable6Batch);
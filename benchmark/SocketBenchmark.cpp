@@ -0,0 +1,321 @@
+#include <benchmark/benchmark.h>
+#include <coco/platform/IpSocket_native.hpp>
+#include <coco/platform/UdpSocket_native.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#ifndef _WIN32
+#include <thread>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <coco/platform/LowLatency_Linux.hpp>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#endif
+
+
+/*
+    SocketBenchmark: Throughput and latency of the native sockets on the loopback interface.
+    udp: Datagrams per second and bytes per second of an unconnected UdpSocket that sends to itself, for several
+    payload sizes and numbers of buffers in flight (one half sends, the other half receives).
+    udpConnected: The same with an IpSocket that is connected to itself, to compare connected and unconnected sockets.
+    tcpRoundTrip: Request/response round trip time of a TCP IpSocket to an echo server in a separate thread.
+    udpLatency: p50/p99 time in microseconds from receiving a datagram (kernel timestamp) until the waiting coroutine
+    gets resumed, in sleeping mode and in spinning mode with a pinned loop thread (Linux).
+*/
+
+using namespace coco;
+
+namespace {
+
+constexpr int DATAGRAM_COUNT = 10000;
+constexpr int ROUND_TRIP_COUNT = 1000;
+
+Coroutine sender(Buffer &buffer, int size) {
+    std::fill(buffer.data(), buffer.data() + size, 0x55);
+    while (true) {
+        co_await buffer.write(size);
+        if (!buffer.ready())
+            co_return;
+    }
+}
+
+Coroutine receiver(Loop &loop, Buffer &buffer, int &remaining) {
+    while (true) {
+        co_await buffer.read();
+        if (!buffer.ready())
+            co_return;
+        if (--remaining == 0)
+            loop.exit();
+    }
+}
+
+// socket, buffers and coroutines that keep sending to itself, the coroutines return when the socket gets closed
+template <typename Socket>
+struct Fixture {
+    Loop_native loop;
+    Socket socket;
+    std::vector<std::unique_ptr<typename Socket::Buffer>> buffers;
+    int remaining = 0;
+
+    template <typename... Args>
+    Fixture(Args &&...args) : socket(loop, args...) {}
+
+    // close the socket first so that the coroutines waiting on the buffers return
+    ~Fixture() {
+        this->socket.close();
+    }
+
+    // add buffers, the first half sends and the other half receives
+    void add(int size, int bufferCount) {
+        for (int i = 0; i < bufferCount; ++i)
+            this->buffers.emplace_back(std::make_unique<typename Socket::Buffer>(this->socket, size));
+    }
+
+    void start(int size) {
+        int sendCount = int(this->buffers.size()) / 2;
+        for (int i = 0; i < int(this->buffers.size()); ++i) {
+            if (i < sendCount)
+                sender(*this->buffers[i], size);
+            else
+                receiver(this->loop, *this->buffers[i], this->remaining);
+        }
+    }
+};
+
+template <typename Socket>
+void run(benchmark::State &state, Fixture<Socket> &fixture) {
+    int size = state.range(0);
+    int bufferCount = state.range(1);
+    for (auto _ : state) {
+        fixture.remaining = DATAGRAM_COUNT;
+        fixture.loop.run();
+    }
+    state.SetItemsProcessed(state.iterations() * DATAGRAM_COUNT);
+    state.SetBytesProcessed(state.iterations() * DATAGRAM_COUNT * size);
+    state.counters["size"] = size;
+    state.counters["buffers"] = bufferCount;
+}
+
+void udpArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgNames({"size", "buffers"});
+    for (int size : {16, 512, 1472}) {
+        for (int bufferCount : {2, 16, 128})
+            benchmark->Args({size, bufferCount});
+    }
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+// each benchmark run uses a new port
+uint16_t port = 22000;
+
+} // namespace
+
+
+static void udp(benchmark::State &state) {
+    Fixture<UdpSocket_native> fixture;
+    uint16_t port = ++::port;
+    fixture.socket.open(ip::v4::PROTOCOL_ID, port);
+    fixture.add(state.range(0), state.range(1));
+
+    // all send buffers send to the socket itself
+    ip::v4::Endpoint endpoint = {.port = port, .address = *ip::v4::Address::fromString("127.0.0.1")};
+    for (int i = 0; i < state.range(1) / 2; ++i)
+        fixture.buffers[i]->header<ip::v4::Endpoint>() = endpoint;
+    fixture.start(state.range(0));
+
+    run(state, fixture);
+}
+BENCHMARK(udp)->Apply(udpArguments);
+
+static void udpConnected(benchmark::State &state) {
+    Fixture<IpSocket_native> fixture(SOCK_DGRAM, IPPROTO_UDP);
+    uint16_t port = ++::port;
+    ip::v4::Endpoint endpoint = {.port = port, .address = *ip::v4::Address::fromString("127.0.0.1")};
+    fixture.socket.connect(endpoint, port);
+    fixture.add(state.range(0), state.range(1));
+    fixture.start(state.range(0));
+
+    run(state, fixture);
+}
+BENCHMARK(udpConnected)->Apply(udpArguments);
+
+#ifndef _WIN32
+
+namespace {
+
+// blocking echo server for one connection, the thread ends when the client closes the connection
+std::thread listenEcho(uint16_t port) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr = {htonl(INADDR_LOOPBACK)}};
+    if (bind(listener, (sockaddr *)&address, sizeof(address)) == -1 || listen(listener, 1) == -1) {
+        close(listener);
+        return {};
+    }
+
+    return std::thread([listener] {
+        int connection = accept(listener, nullptr, nullptr);
+        close(listener);
+        int noDelay = 1;
+        setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        uint8_t data[65536];
+        ssize_t size;
+        while ((size = recv(connection, data, sizeof(data), 0)) > 0)
+            send(connection, data, size, 0);
+        close(connection);
+    });
+}
+
+// send a request and wait until the complete response has arrived
+Coroutine client(Loop &loop, Buffer &request, Buffer &response, int size, int &remaining) {
+    std::fill(request.data(), request.data() + size, 0x55);
+    while (true) {
+        co_await request.write(size);
+        int received = 0;
+        while (received < size) {
+            co_await response.read();
+            if (!response.ready() || response.size() == 0)
+                co_return;
+            received += response.size();
+        }
+        if (--remaining == 0)
+            loop.exit();
+    }
+}
+
+} // namespace
+
+static void tcpRoundTrip(benchmark::State &state) {
+    int size = state.range(0);
+    uint16_t port = ++::port;
+    auto echo = listenEcho(port);
+    if (!echo.joinable()) {
+        state.SkipWithError("listen failed");
+        return;
+    }
+
+    // the client starts sending when the connection is established
+    Fixture<IpSocket_native> fixture(SOCK_STREAM, IPPROTO_TCP);
+    ip::v4::Endpoint endpoint = {.port = port, .address = *ip::v4::Address::fromString("127.0.0.1")};
+    fixture.socket.connect(endpoint, 0, {.flags = IpSocket::Options::Flags::NO_DELAY});
+    auto &request = *fixture.buffers.emplace_back(std::make_unique<IpSocket_native::Buffer>(fixture.socket, size));
+    auto &response = *fixture.buffers.emplace_back(std::make_unique<IpSocket_native::Buffer>(fixture.socket, size));
+    client(fixture.loop, request, response, size, fixture.remaining);
+
+    for (auto _ : state) {
+        fixture.remaining = ROUND_TRIP_COUNT;
+        fixture.loop.run();
+    }
+    state.SetItemsProcessed(state.iterations() * ROUND_TRIP_COUNT);
+
+    // average round trip time
+    state.counters["rtt"] = benchmark::Counter(ROUND_TRIP_COUNT,
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+
+    // closing the connection ends the echo server
+    fixture.socket.close();
+    echo.join();
+}
+BENCHMARK(tcpRoundTrip)->ArgName("size")->Arg(64)->Arg(1024)->Arg(16384)->Unit(benchmark::kMillisecond);
+
+#endif
+
+#ifdef __linux__
+
+namespace {
+
+constexpr int LATENCY_COUNT = 2000;
+
+// current time in nanoseconds since the epoch, the clock of the receive timestamps
+uint64_t now() {
+    timespec time;
+    clock_gettime(CLOCK_REALTIME, &time);
+    return uint64_t(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+// record the time from receiving a datagram until the coroutine gets resumed
+Coroutine latencyReceiver(Loop &loop, Buffer &buffer, SocketStatistics::Histogram &histogram, int &remaining) {
+    while (true) {
+        co_await buffer.read();
+        if (!buffer.ready())
+            co_return;
+        uint64_t timestamp = buffer.header<UdpSocket::Header>().timestamp;
+        if (timestamp != 0)
+            histogram.record(now() - timestamp);
+        if (--remaining == 0)
+            loop.exit();
+    }
+}
+
+// send a datagram about every 50 microseconds until stopped, the gaps let a sleeping loop go to sleep
+std::thread startSender(uint16_t port, std::atomic<bool> &stop, int cpu) {
+    return std::thread([port, &stop, cpu] {
+        if (cpu >= 0)
+            lowLatency::pinThread(cpu);
+        int sender = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr = {htonl(INADDR_LOOPBACK)}};
+        uint8_t data[64] = {};
+        while (!stop.load(std::memory_order_relaxed)) {
+            sendto(sender, data, sizeof(data), 0, (sockaddr *)&address, sizeof(address));
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        close(sender);
+    });
+}
+
+} // namespace
+
+static void udpLatency(benchmark::State &state) {
+    bool spinning = state.range(0) != 0;
+    SocketStatistics::Histogram histogram;
+    Fixture<UdpSocket_native> fixture;
+    uint16_t port = ++::port;
+    fixture.socket.setBusyPoll(spinning ? 50 : 0);
+    fixture.socket.open(ip::v4::PROTOCOL_ID, port, UdpSocket::Flags::TIMESTAMPS);
+    fixture.add(64, 4);
+    for (auto &buffer : fixture.buffers)
+        latencyReceiver(fixture.loop, *buffer, histogram, fixture.remaining);
+
+    // in spinning mode, pin the loop thread to the last CPU and the sender to the one before
+    cpu_set_t affinity;
+    pthread_getaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+    int cpuCount = int(std::thread::hardware_concurrency());
+    bool pinned = spinning && cpuCount >= 2 && lowLatency::pinThread(cpuCount - 1);
+    if (spinning) {
+        lowLatency::setBusyPoll(fixture.loop, 50);
+        lowLatency::spin(fixture.loop, spinning);
+    }
+    std::atomic<bool> stop = false;
+    auto sender = startSender(port, stop, pinned ? cpuCount - 2 : -1);
+
+    for (auto _ : state) {
+        fixture.remaining = LATENCY_COUNT;
+        fixture.loop.run();
+    }
+    state.counters["p50"] = double(histogram.percentile(50)) / 1000.0;
+    state.counters["p99"] = double(histogram.percentile(99)) / 1000.0;
+
+    // let the spinning coroutine return in one more run that ends with the next datagram
+    if (spinning) {
+        spinning = false;
+        fixture.remaining = 1;
+        fixture.loop.run();
+    }
+    stop = true;
+    sender.join();
+    if (pinned)
+        pthread_setaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+
+    state.SetItemsProcessed(state.iterations() * LATENCY_COUNT);
+}
+BENCHMARK(udpLatency)->ArgName("spinning")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+#endif
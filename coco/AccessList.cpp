@@ -0,0 +1,68 @@
+#include "AccessList.hpp"
+#include <algorithm>
+
+
+namespace coco {
+namespace ip {
+
+// number of senders that get checked with one batched lookup per protocol
+constexpr int BATCH = 64;
+
+void AccessList::clear() {
+    this->entries4_.clear();
+    this->entries6_.clear();
+}
+
+void AccessList::build() {
+    this->table4_.build(this->entries4_);
+    this->table6_.build(this->entries6_);
+}
+
+void AccessList::allowed(std::span<const Endpoint * const> senders, bool *results) const {
+    int count = senders.size();
+    for (int i = 0; i < count; i += BATCH) {
+        int n = std::min(BATCH, count - i);
+
+        // split the senders by protocol
+        v4::Address addresses4[BATCH];
+        v6::Address addresses6[BATCH];
+        int indices4[BATCH];
+        int indices6[BATCH];
+        int count4 = 0;
+        int count6 = 0;
+        for (int j = 0; j < n; ++j) {
+            auto &sender = *senders[i + j];
+            if (sender.protocolId == v4::PROTOCOL_ID) {
+                indices4[count4] = j;
+                addresses4[count4++] = sender.v4.address;
+            } else if (sender.protocolId == v6::PROTOCOL_ID) {
+                auto &a = sender.v6.address;
+                if (mapped(a)) {
+                    indices4[count4] = j;
+                    addresses4[count4++] = v4::Address{.u32 = {a.u32[3]}};
+                } else {
+                    indices6[count6] = j;
+                    addresses6[count6++] = a;
+                }
+            } else {
+                results[i + j] = this->defaultAction_ == Action::ALLOW;
+            }
+        }
+
+        // look up all addresses of a protocol at once
+        PrefixValue values[BATCH];
+        this->table4_.lookup({addresses4, size_t(count4)}, values);
+        for (int k = 0; k < count4; ++k) {
+            PrefixValue value = values[k] == 0 ? PrefixValue(this->defaultAction_) : values[k];
+            results[i + indices4[k]] = Action(value) == Action::ALLOW;
+        }
+        this->table6_.lookup({addresses6, size_t(count6)}, values);
+        for (int k = 0; k < count6; ++k) {
+            PrefixValue value = values[k] == 0 ? PrefixValue(this->defaultAction_) : values[k];
+            results[i + indices6[k]] = Action(value) == Action::ALLOW;
+        }
+    }
+}
+
+} // namespace ip
+} // namespace coco
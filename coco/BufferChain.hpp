@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+
+namespace coco {
+
+/// @brief Chain of memory spans that a socket buffer transfers together with its own data in one vectored send or
+/// receive (scatter/gather), e.g. to send a protocol header from the buffer and a payload that is held elsewhere
+/// without copying both into one contiguous buffer. The buffer and its chain complete together.
+/// When writing, the chain is sent after the size() bytes of the buffer. When reading, the received data fills the
+/// buffer up to its capacity and continues in the chain, size() is then the number of bytes in the buffer and
+/// chainSize() the number of bytes in the chain.
+/// The buffers of the native UdpSocket and IpSocket implementations inherit from this class.
+class BufferChain {
+public:
+    /// @brief Maximum number of spans in a chain
+    static constexpr int MAX_COUNT = 7;
+
+    /// @brief Set the chain, used by all following transfers of the buffer until it is set again.
+    /// @param chain Memory spans, the array and the memory have to stay valid while the buffer is busy, empty for no
+    /// chain
+    void setChain(std::span<const std::span<uint8_t>> chain) {
+        assert(chain.size() <= MAX_COUNT);
+        this->chain_ = chain;
+    }
+
+    /// @brief Get the chain.
+    /// @return Memory spans
+    std::span<const std::span<uint8_t>> chain() const {return this->chain_;}
+
+    /// @brief Get the number of bytes that the last transfer has transferred in the chain.
+    /// @return Number of bytes
+    int chainSize() const {return this->chainSize_;}
+
+protected:
+    // total size of the spans in the chain
+    int getChainCapacity() const {
+        int capacity = 0;
+        for (auto &span : this->chain_)
+            capacity += int(span.size());
+        return capacity;
+    }
+
+    // get the vectors for transferring the given data of the buffer followed by the chain, starting at an offset,
+    // vector(data, size) creates a platform vector (e.g. iovec or WSABUF), returns the number of vectors
+    template <typename V, typename F>
+    int getVectors(V *vectors, uint8_t *data, int size, int offset, F vector) const {
+        int count = 0;
+        if (offset < size)
+            vectors[count++] = vector(data + offset, size - offset);
+        offset = std::max(offset - size, 0);
+        for (auto &span : this->chain_) {
+            int spanSize = int(span.size());
+            if (offset < spanSize)
+                vectors[count++] = vector(span.data() + offset, spanSize - offset);
+            offset = std::max(offset - spanSize, 0);
+        }
+        return count;
+    }
+
+    // split the number of transferred bytes into the bytes in the buffer (returned) and the bytes in the chain
+    int split(int transferred, int size) {
+        this->chainSize_ = std::max(transferred - size, 0);
+        return transferred - this->chainSize_;
+    }
+
+    std::span<const std::span<uint8_t>> chain_;
+    int chainSize_ = 0;
+};
+
+} // namespace coco
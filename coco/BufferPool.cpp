@@ -0,0 +1,102 @@
+#include "BufferPool.hpp"
+#include <new>
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+namespace coco {
+
+// size of huge pages on common platforms
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+BufferPool::BufferPool(int blockSize, int blockCount, int alignment, Flags flags) : alignment_(alignment) {
+    blockSize = (blockSize + alignment - 1) & ~(alignment - 1);
+    size_t size = size_t(blockSize) * blockCount;
+    if (size == 0)
+        return;
+
+#if defined(_WIN32)
+    if ((flags & Flags::HUGE_PAGES) != 0) {
+        // large pages need the SeLockMemoryPrivilege
+        size_t pageSize = GetLargePageMinimum();
+        if (pageSize > 0) {
+            arenaSize_ = (size + pageSize - 1) & ~(pageSize - 1);
+            arena_ = VirtualAlloc(nullptr, arenaSize_, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            hugePages_ = arena_ != nullptr;
+        }
+    }
+    if (arena_ == nullptr) {
+        arenaSize_ = size;
+        arena_ = VirtualAlloc(nullptr, arenaSize_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+#elif defined(__linux__)
+    if ((flags & Flags::HUGE_PAGES) != 0) {
+        // explicit huge pages need to be reserved (/proc/sys/vm/nr_hugepages)
+        arenaSize_ = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        arena_ = mmap(nullptr, arenaSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (arena_ == MAP_FAILED) {
+            // fall back to transparent huge pages
+            arena_ = mmap(nullptr, arenaSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (arena_ != MAP_FAILED)
+                hugePages_ = madvise(arena_, arenaSize_, MADV_HUGEPAGE) == 0;
+        } else {
+            hugePages_ = true;
+        }
+    } else {
+        arenaSize_ = size;
+        arena_ = mmap(nullptr, arenaSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (arena_ == MAP_FAILED)
+        arena_ = nullptr;
+#else
+    arenaSize_ = size;
+    arena_ = ::operator new(arenaSize_, std::align_val_t(alignment), std::nothrow);
+#endif
+    if (arena_ == nullptr)
+        return;
+    ownArena_ = true;
+
+    auto begin = (uint8_t *)arena_;
+    init(begin, begin + size, blockSize);
+}
+
+BufferPool::BufferPool(void *memory, size_t size, int blockSize, int alignment) : alignment_(alignment) {
+    arena_ = memory;
+    arenaSize_ = size;
+
+    // align start of first block
+    auto begin = (uint8_t *)((uintptr_t(memory) + alignment - 1) & ~uintptr_t(alignment - 1));
+    init(begin, (uint8_t *)memory + size, (blockSize + alignment - 1) & ~(alignment - 1));
+}
+
+BufferPool::~BufferPool() {
+    if (!ownArena_)
+        return;
+#if defined(_WIN32)
+    VirtualFree(arena_, 0, MEM_RELEASE);
+#elif defined(__linux__)
+    munmap(arena_, arenaSize_);
+#else
+    ::operator delete(arena_, std::align_val_t(alignment_));
+#endif
+}
+
+void BufferPool::init(uint8_t *begin, uint8_t *end, int blockSize) {
+    blockSize_ = blockSize;
+    if (blockSize < int(sizeof(Block)))
+        return;
+
+    // the blocks are handed out from the start of the arena, no block gets written until it is allocated
+    if (end > begin)
+        blockCount_ = int(size_t(end - begin) / blockSize);
+    next_ = begin;
+    end_ = begin + size_t(blockCount_) * blockSize;
+    freeCount_ = blockCount_;
+}
+
+} // namespace coco
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <coco/enum.hpp>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace coco {
+
+/// @brief Pool of equally sized memory blocks for socket buffers.
+/// All blocks are allocated at once in one arena and are aligned to cache lines, therefore creating and destroying
+/// buffers needs no memory allocation. Blocks that were never allocated are handed out in ascending order, therefore
+/// the pages of the arena get touched only when their blocks are used for the first time. The pool is not thread safe,
+/// use one pool per event loop.
+class BufferPool {
+public:
+    /// @brief Size of a cache line
+    static constexpr int CACHE_LINE_SIZE = 64;
+
+    enum class Flags {
+        NONE = 0,
+
+        /// @brief Back the arena by huge pages to reduce TLB misses. Falls back to normal pages if huge pages are not
+        /// available (only supported on native platforms)
+        HUGE_PAGES = 1,
+    };
+
+    /// @brief Constructor that allocates an arena for the blocks.
+    /// @param blockSize size of one block, gets rounded up to a multiple of the alignment
+    /// @param blockCount number of blocks
+    /// @param alignment alignment of the blocks (power of two, at most the page size)
+    /// @param flags flags such as Flags::HUGE_PAGES
+    BufferPool(int blockSize, int blockCount, int alignment = CACHE_LINE_SIZE, Flags flags = Flags::NONE);
+
+    /// @brief Constructor that uses caller-provided memory as arena, e.g. a mmap'd region.
+    /// @param memory memory, has to stay valid until the pool is destroyed
+    /// @param size size of memory in bytes
+    /// @param blockSize size of one block, gets rounded up to a multiple of the alignment
+    /// @param alignment alignment of the blocks (power of two)
+    BufferPool(void *memory, size_t size, int blockSize, int alignment = CACHE_LINE_SIZE);
+
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator =(const BufferPool &) = delete;
+
+    /// @brief Get the size of the blocks.
+    /// @return size of one block in bytes
+    int blockSize() const {return blockSize_;}
+
+    /// @brief Get the number of blocks.
+    /// @return total number of blocks
+    int blockCount() const {return blockCount_;}
+
+    /// @brief Get the number of free blocks.
+    /// @return number of blocks that can be allocated
+    int freeCount() const {return freeCount_;}
+
+    /// @brief Check if the arena is backed by huge pages.
+    /// @return true if huge pages are used
+    bool hugePages() const {return hugePages_;}
+
+    /// @brief Allocate a block.
+    /// @return block or nullptr if the pool is exhausted
+    uint8_t *allocate() {
+        auto block = free_;
+        if (block == nullptr) {
+            // take the next block that was never allocated
+            if (next_ == end_)
+                return nullptr;
+            auto data = next_;
+            next_ += blockSize_;
+            --freeCount_;
+            return data;
+        }
+        free_ = block->next;
+        --freeCount_;
+        return reinterpret_cast<uint8_t *>(block);
+    }
+
+    /// @brief Return a block to the pool.
+    /// @param data block obtained by allocate()
+    void free(uint8_t *data) {
+        auto block = reinterpret_cast<Block *>(data);
+        block->next = free_;
+        free_ = block;
+        ++freeCount_;
+    }
+
+protected:
+    void init(uint8_t *begin, uint8_t *end, int blockSize);
+
+    // free block, the link to the next free block is stored in the block itself
+    struct Block {
+        Block *next;
+    };
+
+    // arena
+    void *arena_ = nullptr;
+    size_t arenaSize_ = 0;
+    bool hugePages_ = false;
+    bool ownArena_ = false;
+    int alignment_;
+
+    int blockSize_ = 0;
+    int blockCount_ = 0;
+
+    // blocks that were never allocated
+    uint8_t *next_ = nullptr;
+    uint8_t *end_ = nullptr;
+
+    // list of blocks that were returned by free()
+    Block *free_ = nullptr;
+    int freeCount_ = 0;
+};
+COCO_ENUM(BufferPool::Flags)
+
+} // namespace coco
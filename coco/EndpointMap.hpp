@@ -0,0 +1,332 @@
+#pragma once
+
+#include "ip.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COCO_ENDPOINTMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace coco {
+
+/// @brief Hash map from ip::Endpoint to a value, e.g. per-peer state for the senders reported by a UdpSocket.
+/// Open addressing with keys and values stored inline in one array. A separate array holds one control byte per slot
+/// with 7 bits of the hash, a group of 16 slots is probed with a few SIMD instructions (SSE2 on x86, scalar loop on
+/// other platforms) and keys are only compared when the control byte matches. Growth doubles the capacity at a load
+/// of 7/8. Pointers to values are invalidated when the map grows. The map is not thread safe.
+/// @tparam V value type
+template <typename V>
+class EndpointMap {
+public:
+    struct Entry {
+        ip::Endpoint key;
+        V value;
+    };
+
+    class Iterator {
+    public:
+        Entry &operator *() const {return map->entries_[index];}
+        Entry *operator ->() const {return &map->entries_[index];}
+        Iterator &operator ++() {++index; skip(); return *this;}
+        bool operator ==(const Iterator &it) const {return index == it.index;}
+
+        void skip() {
+            while (index < map->capacity() && map->control(index) < 0)
+                ++index;
+        }
+
+        EndpointMap *map;
+        int index;
+    };
+
+    EndpointMap() = default;
+
+    /// @brief Constructor.
+    /// @param count number of entries that can be inserted without growing
+    explicit EndpointMap(int count) {reserve(count);}
+
+    ~EndpointMap() {
+        destroy();
+    }
+
+    EndpointMap(const EndpointMap &) = delete;
+    EndpointMap &operator =(const EndpointMap &) = delete;
+
+    /// @brief Get the number of entries.
+    /// @return number of entries
+    int size() const {return this->size_;}
+
+    /// @brief Check if the map is empty.
+    /// @return true if the map contains no entries
+    bool empty() const {return this->size_ == 0;}
+
+    /// @brief Get the number of slots.
+    /// @return number of slots, at most 7/8 of them can be used
+    int capacity() const {return (this->groupMask_ + 1) * GROUP_SIZE;}
+
+    /// @brief Make sure that a number of entries can be stored without growing.
+    /// @param count number of entries
+    void reserve(int count) {
+        int capacity = capacityFor(count);
+        if (capacity > this->capacity() || this->groups_ == emptyGroup())
+            rehash(capacity);
+    }
+
+    /// @brief Find the entry of an endpoint.
+    /// @param key endpoint, e.g. buffer.header<ip::Endpoint>() of a buffer that was received by a UdpSocket
+    /// @return value or nullptr if the endpoint is not in the map
+    V *find(const ip::Endpoint &key) {
+        int index = findIndex(key, key.hash());
+        return index >= 0 ? &this->entries_[index].value : nullptr;
+    }
+    const V *find(const ip::Endpoint &key) const {
+        return const_cast<EndpointMap *>(this)->find(key);
+    }
+
+    /// @brief Check if the map contains an endpoint.
+    /// @param key endpoint
+    /// @return true if the endpoint is in the map
+    bool contains(const ip::Endpoint &key) const {
+        return find(key) != nullptr;
+    }
+
+    /// @brief Insert an entry if the endpoint is not in the map yet.
+    /// @param key endpoint
+    /// @param args arguments for constructing the value, not used if the endpoint is already in the map
+    /// @return value and true if it was inserted or the existing value and false
+    template <typename... Args>
+    std::pair<V *, bool> emplace(const ip::Endpoint &key, Args &&...args) {
+        uint64_t hash = key.hash();
+        int index = findIndex(key, hash);
+        if (index >= 0)
+            return {&this->entries_[index].value, false};
+
+        // grow or drop deleted slots if the load limit is reached
+        index = findFree(hash);
+        if (this->growthLeft_ == 0 && control(index) == EMPTY) {
+            rehash(this->size_ + 1 <= this->capacity() * 7 / 16 ? this->capacity() : capacityFor(this->size_ + 1));
+            index = findFree(hash);
+        }
+
+        if (control(index) == EMPTY)
+            --this->growthLeft_;
+        control(index) = int8_t(hash & 0x7f);
+        auto entry = ::new (&this->entries_[index]) Entry{key, V(std::forward<Args>(args)...)};
+        ++this->size_;
+        return {&entry->value, true};
+    }
+
+    /// @brief Get the value of an endpoint, a default constructed value gets inserted if the endpoint is not in the
+    /// map yet.
+    /// @param key endpoint
+    /// @return value
+    V &operator [](const ip::Endpoint &key) {
+        return *emplace(key).first;
+    }
+
+    /// @brief Erase the entry of an endpoint.
+    /// @param key endpoint
+    /// @return true if the endpoint was in the map
+    bool erase(const ip::Endpoint &key) {
+        int index = findIndex(key, key.hash());
+        if (index < 0)
+            return false;
+        eraseIndex(index);
+        return true;
+    }
+
+    /// @brief Erase an entry while iterating, e.g. to remove expired peers.
+    /// @param it iterator of the entry
+    /// @return iterator of the next entry
+    Iterator erase(Iterator it) {
+        eraseIndex(it.index);
+        ++it;
+        return it;
+    }
+
+    /// @brief Erase all entries, the capacity stays the same.
+    ///
+    void clear() {
+        if (this->groups_ == emptyGroup())
+            return;
+        int capacity = this->capacity();
+        for (int i = 0; i < capacity; ++i) {
+            if (control(i) >= 0)
+                std::destroy_at(&this->entries_[i]);
+            control(i) = EMPTY;
+        }
+        this->size_ = 0;
+        this->growthLeft_ = capacity - capacity / 8;
+    }
+
+    Iterator begin() {
+        Iterator it{this, 0};
+        it.skip();
+        return it;
+    }
+    Iterator end() {return {this, capacity()};}
+
+protected:
+    static constexpr int GROUP_SIZE = 16;
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    // group of control bytes, full slots contain the lower 7 bits of the hash, free slots are negative
+    struct alignas(GROUP_SIZE) Group {
+        int8_t control[GROUP_SIZE];
+
+        // bit mask of the slots whose control byte equals the given value
+        uint32_t match(int8_t value) const {
+#ifdef COCO_ENDPOINTMAP_SSE2
+            auto g = _mm_load_si128(reinterpret_cast<const __m128i *>(this->control));
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(value)));
+#else
+            uint32_t mask = 0;
+            for (int i = 0; i < GROUP_SIZE; ++i)
+                mask |= uint32_t(this->control[i] == value) << i;
+            return mask;
+#endif
+        }
+
+        // bit mask of the slots that are empty or deleted
+        uint32_t matchFree() const {
+#ifdef COCO_ENDPOINTMAP_SSE2
+            return _mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(this->control)));
+#else
+            uint32_t mask = 0;
+            for (int i = 0; i < GROUP_SIZE; ++i)
+                mask |= uint32_t(this->control[i] < 0) << i;
+            return mask;
+#endif
+        }
+    };
+
+    // a map without slots points to this group so that lookups need no extra check
+    static Group *emptyGroup() {
+        alignas(GROUP_SIZE) static const Group group = {
+            EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
+            EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY};
+        return const_cast<Group *>(&group);
+    }
+
+    // smallest capacity (power of two) for the given number of entries
+    static int capacityFor(int count) {
+        int capacity = std::bit_ceil(unsigned(count + count / 7 + 1));
+        return capacity < GROUP_SIZE ? GROUP_SIZE : capacity;
+    }
+
+    int8_t &control(int index) {
+        return this->groups_[index / GROUP_SIZE].control[index % GROUP_SIZE];
+    }
+
+    // probe the groups in triangular order (visits all groups if the number of groups is a power of two), the first
+    // group is selected by the upper bits of the hash
+    int findIndex(const ip::Endpoint &key, uint64_t hash) {
+        int8_t tag = int8_t(hash & 0x7f);
+        unsigned g = unsigned(hash >> 7) & this->groupMask_;
+        for (unsigned step = 1; ; ++step) {
+            auto &group = this->groups_[g];
+            for (uint32_t mask = group.match(tag); mask != 0; mask &= mask - 1) {
+                int index = g * GROUP_SIZE + std::countr_zero(mask);
+                if (this->entries_[index].key == key)
+                    return index;
+            }
+
+            // stop at the first group that has an empty slot
+            if (group.match(EMPTY) != 0)
+                return -1;
+            g = (g + step) & this->groupMask_;
+        }
+    }
+
+    // find the first empty or deleted slot in probe order
+    int findFree(uint64_t hash) {
+        unsigned g = unsigned(hash >> 7) & this->groupMask_;
+        for (unsigned step = 1; ; ++step) {
+            uint32_t mask = this->groups_[g].matchFree();
+            if (mask != 0)
+                return g * GROUP_SIZE + std::countr_zero(mask);
+            g = (g + step) & this->groupMask_;
+        }
+    }
+
+    void eraseIndex(int index) {
+        std::destroy_at(&this->entries_[index]);
+
+        // a slot can become empty again if its group has an empty slot because then no probe sequence continues
+        // beyond this group
+        if (this->groups_[index / GROUP_SIZE].match(EMPTY) != 0) {
+            control(index) = EMPTY;
+            ++this->growthLeft_;
+        } else {
+            control(index) = DELETED;
+        }
+        --this->size_;
+    }
+
+    // move all entries into new arrays of the given capacity, drops the deleted slots
+    void rehash(int capacity) {
+        auto groups = this->groups_;
+        auto entries = this->entries_;
+        int oldCapacity = this->capacity();
+
+        int groupCount = capacity / GROUP_SIZE;
+        this->groups_ = new Group[groupCount];
+        this->entries_ = std::allocator<Entry>().allocate(capacity);
+        this->groupMask_ = groupCount - 1;
+        this->growthLeft_ = capacity - capacity / 8 - this->size_;
+        for (int i = 0; i < capacity; ++i)
+            control(i) = EMPTY;
+
+        if (groups == emptyGroup())
+            return;
+        for (int i = 0; i < oldCapacity; ++i) {
+            auto &group = groups[i / GROUP_SIZE];
+            if (group.control[i % GROUP_SIZE] >= 0) {
+                auto &entry = entries[i];
+                uint64_t hash = entry.key.hash();
+                int index = findFree(hash);
+                control(index) = int8_t(hash & 0x7f);
+                ::new (&this->entries_[index]) Entry(std::move(entry));
+                std::destroy_at(&entry);
+            }
+        }
+        delete [] groups;
+        std::allocator<Entry>().deallocate(entries, oldCapacity);
+    }
+
+    void destroy() {
+        if (this->groups_ == emptyGroup())
+            return;
+        int capacity = this->capacity();
+        for (int i = 0; i < capacity; ++i) {
+            if (control(i) >= 0)
+                std::destroy_at(&this->entries_[i]);
+        }
+        delete [] this->groups_;
+        std::allocator<Entry>().deallocate(this->entries_, capacity);
+    }
+
+
+    // control bytes, one per slot
+    Group *groups_ = emptyGroup();
+
+    // keys and values, one per slot
+    Entry *entries_ = nullptr;
+
+    // number of groups minus one
+    unsigned groupMask_ = 0;
+
+    // number of entries
+    int size_ = 0;
+
+    // number of empty slots that can be used until the map has to grow
+    int growthLeft_ = 0;
+};
+
+} // namespace coco
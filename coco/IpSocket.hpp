@@ -1,15 +1,80 @@
 #pragma once
 
+#include <coco/BufferChain.hpp>
 #include <coco/ip.hpp>
+#include <coco/SocketStatistics.hpp>
 #include <coco/BufferDevice.hpp>
+#include <coco/enum.hpp>
 
 
 namespace coco {
 
+/// @brief Options for connecting an IpSocket, options that the platform does not support are ignored.
+/// Defined outside of IpSocket so that the default member initializers can be used in default arguments of IpSocket
+struct IpSocketOptions {
+    enum class Flags {
+        NONE = 0,
+
+        /// @brief Send small writes immediately instead of combining them (disable Nagle's algorithm, TCP_NODELAY)
+        NO_DELAY = 1,
+
+        /// @brief Acknowledge received data immediately instead of delaying the ACK (TCP_QUICKACK). The kernel may
+        /// return to delayed ACKs later, therefore mainly useful for short request/response exchanges
+        QUICK_ACK = 2,
+
+        /// @brief TCP Fast Open: The connection is established together with the first write, the data is sent
+        /// with the SYN if the server supports Fast Open and has issued a cookie to this client before, which
+        /// saves a round trip. Otherwise the data follows the normal handshake. Read buffers wait until the first
+        /// write was started. The socket may transition to ready state before the server has accepted the
+        /// connection, therefore a refused connection may be reported by the first transfer
+        FAST_OPEN = 4,
+    };
+
+    Flags flags = Flags::NONE;
+
+    // time in milliseconds that sent data may stay unacknowledged before the connection is closed
+    // (TCP_USER_TIMEOUT), 0 for the default of the platform
+    int userTimeout = 0;
+
+    // size of the receive and send buffers of the socket in bytes (SO_RCVBUF, SO_SNDBUF), 0 for the default
+    int receiveBufferSize = 0;
+    int sendBufferSize = 0;
+
+    // time in microseconds to busy poll the network device when receiving instead of waiting for an interrupt
+    // (SO_BUSY_POLL), trades CPU time for latency, 0 to disable
+    int busyPollTime = 0;
+};
+COCO_ENUM(IpSocketOptions::Flags)
+
+
 /// @brief Connection based IP socket.
 /// Used for UDP with fixed destination address or TCP client that connects to serever.
 class IpSocket : public BufferDevice {
 public:
+    /// @brief Statistics of zero-copy send.
+    ///
+    struct ZeroCopyStatistics {
+        // number of sends that were transmitted directly from the memory of the buffer
+        uint64_t zeroCopy = 0;
+
+        // number of sends that were copied (smaller than the threshold or copied by the kernel, e.g. on loopback)
+        uint64_t copied = 0;
+    };
+
+    /// @brief Header of the buffers of an IP socket
+    ///
+    struct Header {
+        /// @brief If timestamps are enabled (see enableTimestamps() of the platform socket), time in nanoseconds since
+        /// the epoch when the data was received by the host after reading, or when the (last byte of the) data was
+        /// handed to the network device after writing. Taken by the network device if it supports hardware
+        /// timestamps, else by the kernel. 0 if not available
+        uint64_t timestamp;
+    };
+
+    /// @brief Options for connecting, options that the platform does not support are ignored
+    ///
+    using Options = IpSocketOptions;
+
     IpSocket(State state) : BufferDevice(state) {}
 
     /// @brief Connect to a server.
@@ -18,10 +83,23 @@ public:
     /// @param endpoint Endpoint (address and port) of server
     /// @param size Size of endpoint structure
     /// @param localPort Local port to bind to (0 = any)
+    /// @param options Options of the connection, e.g. TCP Fast Open, TCP_NODELAY, buffer sizes or busy polling
     /// @return true if connect operation was started, false on error
-    virtual bool connect(const ip::Endpoint &endpoint, int size = sizeof(ip::Endpoint), int localPort = 0) = 0;
-    bool connect(const ip::v4::Endpoint &endpoint, int localPort = 0) {return connect((ip::Endpoint &)endpoint, sizeof(endpoint), localPort);}
-    bool connect(const ip::v6::Endpoint &endpoint, int localPort = 0) {return connect((ip::Endpoint &)endpoint, sizeof(endpoint), localPort);}
+    virtual bool connect(const ip::Endpoint &endpoint, int size = sizeof(ip::Endpoint), int localPort = 0,
+        const Options &options = {}) = 0;
+    bool connect(const ip::v4::Endpoint &endpoint, int localPort = 0, const Options &options = {}) {
+        return connect((ip::Endpoint &)endpoint, sizeof(endpoint), localPort, options);
+    }
+    bool connect(const ip::v6::Endpoint &endpoint, int localPort = 0, const Options &options = {}) {
+        return connect((ip::Endpoint &)endpoint, sizeof(endpoint), localPort, options);
+    }
+
+    /// @brief Collect statistics of the transfers. Set before connecting.
+    /// @param statistics Statistics, have to stay valid while they are set, nullptr to collect no statistics
+    void setStatistics(SocketStatistics *statistics) {this->statistics_ = statistics;}
+
+protected:
+    SocketStatistics *statistics_ = nullptr;
 };
 
 } // namespace coco
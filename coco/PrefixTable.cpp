@@ -0,0 +1,296 @@
+#include "PrefixTable.hpp"
+#include <algorithm>
+#include <bit>
+
+
+namespace coco {
+namespace ip {
+
+// number of addresses whose table entries get prefetched at once by the batched lookups
+constexpr int BATCH = 16;
+
+static inline void prefetch(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#endif
+}
+
+namespace v4 {
+
+void PrefixTable::build(std::span<const Entry> entries) {
+    this->table24_.reset();
+    this->table8_.clear();
+    if (entries.empty())
+        return;
+
+    // insert shorter prefixes first so that longer prefixes overwrite them, the last of equal prefixes wins
+    std::vector<const Entry *> sorted;
+    sorted.reserve(entries.size());
+    for (auto &entry : entries)
+        sorted.push_back(&entry);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Entry *a, const Entry *b) {
+        return a->prefix.length < b->prefix.length;
+    });
+
+    auto table24 = std::make_unique<uint32_t[]>(1 << 24);
+    for (auto entry : sorted) {
+        int length = entry->prefix.length;
+        uint32_t a = length == 0 ? 0 : uint32_t(entry->prefix.address.u32[0]) & (0xffffffffU << (32 - length));
+        uint16_t value = entry->value & MAX_PREFIX_VALUE;
+
+        if (length <= 24) {
+            // fill the entries of the 24 bit table, no group exists yet because longer prefixes come later
+            std::fill_n(&table24[a >> 8], 1 << (24 - length), value);
+        } else {
+            // fill the entries of the group of 256 entries, create the group if necessary
+            uint32_t &entry24 = table24[a >> 8];
+            if ((entry24 & GROUP) == 0) {
+                uint32_t group = this->table8_.size() / 256;
+                this->table8_.resize(this->table8_.size() + 256, entry24);
+                entry24 = GROUP | group;
+            }
+            size_t group = entry24 & ~GROUP;
+            std::fill_n(&this->table8_[group * 256 + (a & 0xff)], 1 << (32 - length), value);
+        }
+    }
+    this->table24_ = std::move(table24);
+}
+
+void PrefixTable::lookup(std::span<const Address> addresses, PrefixValue *values) const {
+    int count = addresses.size();
+    for (int i = 0; i < count; i += BATCH) {
+        int n = std::min(BATCH, count - i);
+        if (this->table24_ != nullptr) {
+            for (int j = 0; j < n; ++j)
+                prefetch(&this->table24_[uint32_t(addresses[i + j].u32[0]) >> 8]);
+        }
+        for (int j = 0; j < n; ++j)
+            values[i + j] = lookup(addresses[i + j]);
+    }
+}
+
+} // namespace v4
+
+namespace v6 {
+
+void PrefixTable::build(std::span<const Entry> entries) {
+    this->direct_.clear();
+    this->nodes_.clear();
+    this->leaves_.clear();
+    if (entries.empty())
+        return;
+
+    // prefix with the address as two 64 bit integers in host byte order
+    struct Item {
+        uint64_t hi;
+        uint64_t lo;
+        int length;
+        PrefixValue value;
+    };
+    std::vector<Item> items;
+    items.reserve(entries.size());
+    for (auto &entry : entries) {
+        auto &a = entry.prefix.address.u32;
+        int length = entry.prefix.length;
+        uint64_t hi = uint64_t(uint32_t(a[0])) << 32 | uint32_t(a[1]);
+        uint64_t lo = uint64_t(uint32_t(a[2])) << 32 | uint32_t(a[3]);
+
+        // clear the bits beyond the prefix length
+        if (length < 64) {
+            hi = length == 0 ? 0 : hi & (~uint64_t(0) << (64 - length));
+            lo = 0;
+        } else if (length < 128) {
+            lo = length == 64 ? 0 : lo & (~uint64_t(0) << (128 - length));
+        }
+        items.push_back({hi, lo, length, PrefixValue(entry.value & MAX_PREFIX_VALUE)});
+    }
+
+    // sort by the index into the direct table for prefixes that need a trie, then by length so that longer prefixes
+    // overwrite shorter ones, the last of equal prefixes wins
+    std::stable_sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+        int da = a.length <= DIRECT_BITS ? -1 : int(a.hi >> 48);
+        int db = b.length <= DIRECT_BITS ? -1 : int(b.hi >> 48);
+        return da != db ? da < db : a.length < b.length;
+    });
+
+    // fill the direct table with the prefixes of up to 16 bits
+    std::vector<PrefixValue> direct(1 << DIRECT_BITS);
+    auto it = items.begin();
+    for (; it != items.end() && it->length <= DIRECT_BITS; ++it)
+        std::fill_n(&direct[it->hi >> 48], 1 << (DIRECT_BITS - it->length), it->value);
+    this->direct_.assign(direct.begin(), direct.end());
+
+    // build a trie for each entry of the direct table that is covered by longer prefixes
+    std::vector<BuildNode> build;
+    while (it != items.end()) {
+        int index = it->hi >> 48;
+
+        // root node, inherits the value of the direct table entry
+        build.clear();
+        auto &root = build.emplace_back();
+        std::fill_n(root.leaves, 64, direct[index]);
+        std::fill_n(root.children, 64, -1);
+
+        for (; it != items.end() && int(it->hi >> 48) == index; ++it) {
+            // descend to the node that contains the end of the prefix, create missing nodes
+            int node = 0;
+            int offset = DIRECT_BITS;
+            while (it->length > offset + NODE_BITS) {
+                int slot = chunk(it->hi, it->lo, offset);
+                int child = build[node].children[slot];
+                if (child == -1) {
+                    // new node inherits the value of the slot, no longer prefixes were inserted into it yet
+                    child = build.size();
+                    PrefixValue value = build[node].leaves[slot];
+                    auto &n = build.emplace_back();
+                    std::fill_n(n.leaves, 64, value);
+                    std::fill_n(n.children, 64, -1);
+                    build[node].children[slot] = child;
+                }
+                node = child;
+                offset += NODE_BITS;
+            }
+
+            // fill the slots that are covered by the prefix
+            int count = 1 << (offset + NODE_BITS - it->length);
+            int slot = chunk(it->hi, it->lo, offset) & ~(count - 1);
+            std::fill_n(&build[node].leaves[slot], count, it->value);
+        }
+
+        // compress the trie
+        this->direct_[index] = NODE | this->nodes_.size();
+        this->nodes_.emplace_back();
+        emit(build, 0, this->nodes_.size() - 1);
+    }
+}
+
+void PrefixTable::lookup(std::span<const Address> addresses, PrefixValue *values) const {
+    int count = addresses.size();
+    if (this->direct_.empty()) {
+        std::fill_n(values, count, 0);
+        return;
+    }
+
+    // state of the lookups of one batch
+    struct State {
+        uint64_t hi;
+        uint64_t lo;
+        uint32_t index;
+        int offset;
+    };
+    State states[BATCH];
+    int active[BATCH];
+
+    for (int i = 0; i < count; i += BATCH) {
+        int n = std::min(BATCH, count - i);
+
+        // prefetch the entries of the direct table
+        for (int j = 0; j < n; ++j) {
+            auto &a = addresses[i + j].u32;
+            auto &state = states[j];
+            state.hi = uint64_t(uint32_t(a[0])) << 32 | uint32_t(a[1]);
+            state.lo = uint64_t(uint32_t(a[2])) << 32 | uint32_t(a[3]);
+            prefetch(&this->direct_[state.hi >> 48]);
+        }
+
+        // resolve the direct table, prefetch the first nodes
+        int activeCount = 0;
+        for (int j = 0; j < n; ++j) {
+            auto &state = states[j];
+            uint32_t entry = this->direct_[state.hi >> 48];
+            if ((entry & NODE) == 0) {
+                values[i + j] = entry;
+            } else {
+                state.index = entry & ~NODE;
+                state.offset = DIRECT_BITS;
+                prefetch(&this->nodes_[state.index]);
+                active[activeCount++] = j;
+            }
+        }
+
+        // descend one node per step for all active lookups, the leaves get read after the last step
+        int leafCount = 0;
+        int leaves[BATCH];
+        while (activeCount > 0) {
+            int remaining = 0;
+            for (int k = 0; k < activeCount; ++k) {
+                int j = active[k];
+                auto &state = states[j];
+                auto &node = this->nodes_[state.index];
+                int slot = chunk(state.hi, state.lo, state.offset);
+                uint64_t mask = (uint64_t(2) << slot) - 1;
+                if ((node.children >> slot) & 1) {
+                    state.index = node.childBase + std::popcount(node.children & mask) - 1;
+                    state.offset += NODE_BITS;
+                    prefetch(&this->nodes_[state.index]);
+                    active[remaining++] = j;
+                } else {
+                    state.index = node.leafBase + std::popcount(node.leaves & mask) - 1;
+                    prefetch(&this->leaves_[state.index]);
+                    leaves[leafCount++] = j;
+                }
+            }
+            activeCount = remaining;
+        }
+        for (int k = 0; k < leafCount; ++k) {
+            int j = leaves[k];
+            values[i + j] = this->leaves_[states[j].index];
+        }
+    }
+}
+
+PrefixValue PrefixTable::find(uint32_t index, uint64_t hi, uint64_t lo) const {
+    int offset = DIRECT_BITS;
+    while (true) {
+        auto &node = this->nodes_[index];
+        int slot = chunk(hi, lo, offset);
+        uint64_t mask = (uint64_t(2) << slot) - 1;
+        if ((node.children >> slot) & 1) {
+            // descend into child node
+            index = node.childBase + std::popcount(node.children & mask) - 1;
+            offset += NODE_BITS;
+        } else {
+            // leaf: count the runs of equal values up to the slot
+            return this->leaves_[node.leafBase + std::popcount(node.leaves & mask) - 1];
+        }
+    }
+}
+
+void PrefixTable::emit(const std::vector<BuildNode> &build, int buildIndex, int index) {
+    auto &b = build[buildIndex];
+    Node node = {};
+
+    // leaves, only the start of each run of equal values is stored
+    node.leafBase = this->leaves_.size();
+    bool first = true;
+    PrefixValue previous = 0;
+    int childCount = 0;
+    for (int slot = 0; slot < 64; ++slot) {
+        if (b.children[slot] != -1) {
+            node.children |= uint64_t(1) << slot;
+            ++childCount;
+            continue;
+        }
+        if (first || b.leaves[slot] != previous) {
+            node.leaves |= uint64_t(1) << slot;
+            this->leaves_.push_back(b.leaves[slot]);
+            previous = b.leaves[slot];
+            first = false;
+        }
+    }
+
+    // the children are stored contiguously
+    node.childBase = this->nodes_.size();
+    this->nodes_.resize(this->nodes_.size() + childCount);
+    this->nodes_[index] = node;
+    int i = node.childBase;
+    for (int slot = 0; slot < 64; ++slot) {
+        if (b.children[slot] != -1)
+            emit(build, b.children[slot], i++);
+    }
+}
+
+} // namespace v6
+
+} // namespace ip
+} // namespace coco
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "ip.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+
+namespace coco {
+namespace ip {
+
+/// @brief Value of a prefix in a prefix table
+/// 0 means that no prefix matches, therefore the values of the prefixes are in the range 1 to MAX_PREFIX_VALUE.
+using PrefixValue = uint16_t;
+constexpr PrefixValue MAX_PREFIX_VALUE = 0x7fff;
+
+namespace v4 {
+
+/// @brief Longest prefix match table for IPv4 (DIR-24-8).
+/// A table of 2^24 entries is indexed by the upper 24 bits of the address and contains the value directly. Only
+/// addresses that are covered by a prefix longer than /24 need a second access into a group of 256 entries that is
+/// indexed by the lower 8 bits. The table needs 64MB plus 512 bytes for each /24 that contains a longer prefix and
+/// gets built once from a list of prefixes.
+class PrefixTable {
+public:
+    struct Entry {
+        Prefix prefix;
+        PrefixValue value;
+    };
+
+    /// @brief Constructor, creates an empty table where lookup() always returns 0.
+    ///
+    PrefixTable() = default;
+
+    /// @brief Build the table from a list of prefixes, replaces the previous contents.
+    /// If the same prefix occurs multiple times, the last one wins.
+    /// @param entries prefixes and their values (1 to MAX_PREFIX_VALUE)
+    void build(std::span<const Entry> entries);
+
+    /// @brief Get the value of the longest prefix that contains an address.
+    /// @param address address
+    /// @return value or 0 if no prefix contains the address
+    PrefixValue lookup(const Address &address) const {
+        if (this->table24_ == nullptr)
+            return 0;
+        uint32_t a = address.u32[0];
+        uint32_t entry = this->table24_[a >> 8];
+        if ((entry & GROUP) == 0)
+            return entry;
+        return this->table8_[(entry & ~GROUP) * 256 + (a & 0xff)];
+    }
+
+    /// @brief Get the values of multiple addresses. The table entries of all addresses are prefetched first so that
+    /// the cache misses overlap.
+    /// @param addresses addresses
+    /// @param values values for the addresses, 0 for addresses that are not contained in any prefix
+    void lookup(std::span<const Address> addresses, PrefixValue *values) const;
+
+protected:
+    // flag for an entry of the 24 bit table that contains the index of a group of 256 entries
+    static constexpr uint32_t GROUP = 0x80000000;
+
+    std::unique_ptr<uint32_t[]> table24_;
+    std::vector<uint16_t> table8_;
+};
+
+} // namespace v4
+
+namespace v6 {
+
+/// @brief Longest prefix match table for IPv6 (poptrie).
+/// The upper 16 bits of the address index a direct table, then each trie node consumes 6 bits. A node stores a bit
+/// vector of the 64 slots that have a child node and a bit vector that marks where a run of equal leaf values
+/// starts. The children and leaves of a node are stored contiguously, a population count of the bit vectors gives
+/// the index, therefore a node needs only 24 bytes and the trie is small enough to stay in the cache for typical
+/// tables. The table gets built once from a list of prefixes.
+class PrefixTable {
+public:
+    struct Entry {
+        Prefix prefix;
+        PrefixValue value;
+    };
+
+    /// @brief Constructor, creates an empty table where lookup() always returns 0.
+    ///
+    PrefixTable() = default;
+
+    /// @brief Build the table from a list of prefixes, replaces the previous contents.
+    /// If the same prefix occurs multiple times, the last one wins.
+    /// @param entries prefixes and their values (1 to MAX_PREFIX_VALUE)
+    void build(std::span<const Entry> entries);
+
+    /// @brief Get the value of the longest prefix that contains an address.
+    /// @param address address
+    /// @return value or 0 if no prefix contains the address
+    PrefixValue lookup(const Address &address) const {
+        if (this->direct_.empty())
+            return 0;
+        uint64_t hi = uint64_t(uint32_t(address.u32[0])) << 32 | uint32_t(address.u32[1]);
+        uint64_t lo = uint64_t(uint32_t(address.u32[2])) << 32 | uint32_t(address.u32[3]);
+        uint32_t entry = this->direct_[hi >> 48];
+        if ((entry & NODE) == 0)
+            return entry;
+        return find(entry & ~NODE, hi, lo);
+    }
+
+    /// @brief Get the values of multiple addresses. The addresses walk down the trie together one node per step and
+    /// the next node of each address is prefetched, so that the cache misses of the addresses overlap.
+    /// @param addresses addresses
+    /// @param values values for the addresses, 0 for addresses that are not contained in any prefix
+    void lookup(std::span<const Address> addresses, PrefixValue *values) const;
+
+protected:
+    // flag for an entry of the direct table that contains a node index
+    static constexpr uint32_t NODE = 0x80000000;
+
+    // number of bits that index the direct table and number of bits per node
+    static constexpr int DIRECT_BITS = 16;
+    static constexpr int NODE_BITS = 6;
+
+    struct Node {
+        // slots that have a child node
+        uint64_t children;
+
+        // slots without child node where a new leaf value starts
+        uint64_t leaves;
+
+        // index of the first leaf and the first child
+        uint32_t leafBase;
+        uint32_t childBase;
+    };
+
+    // get 6 bits of the address at a bit offset, bits beyond the address are zero
+    static int chunk(uint64_t hi, uint64_t lo, int offset) {
+        if (offset <= 64 - NODE_BITS)
+            return (hi >> (64 - NODE_BITS - offset)) & 63;
+        if (offset >= 64) {
+            offset -= 64;
+            return offset <= 64 - NODE_BITS ? (lo >> (64 - NODE_BITS - offset)) & 63
+                : (lo << (offset - (64 - NODE_BITS))) & 63;
+        }
+        return ((hi << (offset - (64 - NODE_BITS))) | (lo >> (128 - NODE_BITS - offset))) & 63;
+    }
+
+    PrefixValue find(uint32_t index, uint64_t hi, uint64_t lo) const;
+
+    // node of the trie while building
+    struct BuildNode {
+        PrefixValue leaves[64];
+        int children[64];
+    };
+    void emit(const std::vector<BuildNode> &build, int buildIndex, int index);
+
+    std::vector<uint32_t> direct_;
+    std::vector<Node> nodes_;
+    std::vector<PrefixValue> leaves_;
+};
+
+} // namespace v6
+
+} // namespace ip
+} // namespace coco
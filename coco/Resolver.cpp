@@ -0,0 +1,371 @@
+#include "Resolver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+
+namespace coco {
+namespace ip {
+
+namespace {
+
+// current time in seconds for the expiry of cached responses
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// lower case name without trailing dot
+std::string normalize(String name) {
+    std::string s(name.begin(), name.end());
+    if (!s.empty() && s.back() == '.')
+        s.pop_back();
+    for (auto &ch : s) {
+        if (ch >= 'A' && ch <= 'Z')
+            ch += 'a' - 'A';
+    }
+    return s;
+}
+
+// address family of the records of a type
+Resolver::Family toFamily(dns::Type type) {
+    return type == dns::Type::A ? Resolver::Family::V4 : Resolver::Family::V6;
+}
+
+bool isSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+} // namespace
+
+
+Resolver::Resolver(Loop &loop, Buffer &sendBuffer, Buffer &receiveBuffer, const Endpoint &server, Duration interval,
+    int attempts)
+    : loop_(loop), sendBuffer_(sendBuffer), receiveBuffer_(receiveBuffer), server_(server), interval_(interval)
+    , attempts_(attempts), random_(std::random_device()())
+{
+    send(this->destroyed_);
+    receive(this->destroyed_);
+    retransmit(this->destroyed_);
+}
+
+Resolver::~Resolver() {
+    *this->destroyed_ = true;
+
+    // complete the outstanding requests with failure
+    auto requests = std::move(this->requests_);
+    this->queries_.clear();
+    for (auto &request : requests) {
+        request.result->status = Status::FAILED;
+        request.result->endpoints.clear();
+        request.tasks.doAll();
+    }
+
+    // resume the coroutines that wait for a buffer or a query so that they return, a coroutine that sleeps returns
+    // when its timer expires
+    this->sendBuffer_.cancel();
+    this->receiveBuffer_.cancel();
+    this->sendTasks_.doAll();
+    this->queryTasks_.doAll();
+}
+
+void Resolver::addHost(String name, const Endpoint &address) {
+    Endpoint endpoint = address;
+    endpoint.generic.port = 0;
+    auto &addresses = this->hosts_[normalize(name)];
+    if (std::find(addresses.begin(), addresses.end(), endpoint) == addresses.end())
+        addresses.push_back(endpoint);
+}
+
+int Resolver::addHosts(String text) {
+    int count = 0;
+    auto it = text.begin();
+    auto end = text.end();
+    while (it != end) {
+        // a line contains an address followed by names, a comment extends to the end of the line
+        auto lineEnd = std::find(it, end, '\n');
+        auto contentEnd = std::find(it, lineEnd, '#');
+        bool first = true;
+        Endpoint address = {};
+        while (true) {
+            auto begin = std::find_if_not(it, contentEnd, isSpace);
+            if (begin == contentEnd)
+                break;
+            it = std::find_if(begin, contentEnd, isSpace);
+            String token(begin, int(it - begin));
+            if (first) {
+                first = false;
+                if (auto a = v4::Address::fromString(token)) {
+                    address = {.v4 = {.address = *a}};
+                } else if (auto a = v6::Address::fromString(token)) {
+                    address = {.v6 = {.address = *a}};
+                } else {
+                    // e.g. an address with a scope id
+                    break;
+                }
+            } else {
+                addHost(token, address);
+                ++count;
+            }
+        }
+        it = lineEnd == end ? end : lineEnd + 1;
+    }
+    return count;
+}
+
+bool Resolver::loadHosts(const char *path) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    addHosts(String(text.c_str(), int(text.size())));
+    return true;
+}
+
+Awaitable<CoroutineTask<>> Resolver::resolve(String name, uint16_t port, Result &result, Family family) {
+    result.endpoints.clear();
+    auto n = normalize(name);
+    if (resolveLocal(n, port, result, family))
+        return {};
+    if (!dns::valid(name)) {
+        result.status = Status::FAILED;
+        return {};
+    }
+
+    // take the addresses from the cache or query them
+    auto &request = this->requests_.emplace_back();
+    request.name = n;
+    request.family = family;
+    request.port = port;
+    request.result = &result;
+    request.pending = Family(0);
+    request.status = Status::NOT_FOUND;
+    for (auto type : {dns::Type::AAAA, dns::Type::A}) {
+        if ((family & toFamily(type)) == 0)
+            continue;
+        if (auto entry = getCached(n, type)) {
+            add(request, type, entry->status, entry->addresses);
+        } else {
+            request.pending |= toFamily(type);
+            startQuery(n, type);
+        }
+    }
+
+    // complete immediately if all addresses were cached
+    if (request.pending == Family(0)) {
+        result.status = result.endpoints.empty() ? request.status : Status::OK;
+        this->requests_.pop_back();
+        return {};
+    }
+    return {request.tasks};
+}
+
+bool Resolver::resolveLocal(const std::string &name, uint16_t port, Result &result, Family family) {
+    String s(name.c_str(), int(name.size()));
+
+    // numeric address
+    if (auto address = v4::Address::fromString(s)) {
+        if ((family & Family::V4) != 0)
+            result.endpoints.push_back({.v4 = {.port = port, .address = *address}});
+    } else if (auto address = v6::Address::fromString(s)) {
+        if ((family & Family::V6) != 0)
+            result.endpoints.push_back({.v6 = {.port = port, .address = *address}});
+    } else {
+        // static host, resolved by the DNS server if it has no address of the requested family
+        auto it = this->hosts_.find(name);
+        if (it == this->hosts_.end())
+            return false;
+        for (auto protocolId : {v6::PROTOCOL_ID, v4::PROTOCOL_ID}) {
+            if ((family & (protocolId == v4::PROTOCOL_ID ? Family::V4 : Family::V6)) == 0)
+                continue;
+            for (auto &address : it->second) {
+                if (address.protocolId == protocolId) {
+                    auto &endpoint = result.endpoints.emplace_back(address);
+                    endpoint.generic.port = port;
+                }
+            }
+        }
+        if (result.endpoints.empty())
+            return false;
+    }
+    result.status = result.endpoints.empty() ? Status::NOT_FOUND : Status::OK;
+    return true;
+}
+
+const Resolver::Entry *Resolver::getCached(const std::string &name, dns::Type type) {
+    auto it = this->cache_.find(getKey(name, type));
+    if (it == this->cache_.end())
+        return nullptr;
+    if (now() >= it->second.expires) {
+        this->cache_.erase(it);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void Resolver::add(Request &request, dns::Type type, Status status, const std::vector<Endpoint> &addresses) {
+    // IPv6 endpoints go in front of the IPv4 endpoints
+    auto &endpoints = request.result->endpoints;
+    auto it = endpoints.insert(type == dns::Type::AAAA ? endpoints.begin() : endpoints.end(),
+        addresses.begin(), addresses.end());
+    for (auto end = it + addresses.size(); it != end; ++it)
+        it->generic.port = request.port;
+
+    // a timeout or failure is more relevant than a missing record of one family
+    if (status != Status::OK && request.status == Status::NOT_FOUND)
+        request.status = status;
+}
+
+void Resolver::startQuery(const std::string &name, dns::Type type) {
+    // share an outstanding query
+    for (auto &query : this->queries_) {
+        if (query.type == type && query.name == name)
+            return;
+    }
+
+    // random id that is not in use
+    uint16_t id;
+    do {
+        id = uint16_t(this->random_());
+    } while (std::any_of(this->queries_.begin(), this->queries_.end(),
+        [id](const Query &query) {return query.id == id;}));
+
+    this->queries_.push_back({name, type, id, 1, this->tick_});
+    this->sendQueue_.push_back(id);
+    this->sendTasks_.doAll();
+    this->queryTasks_.doAll();
+}
+
+void Resolver::complete(std::list<Query>::iterator it, Status status, std::vector<Endpoint> addresses, uint32_t ttl) {
+    std::string name = std::move(it->name);
+    auto type = it->type;
+    this->queries_.erase(it);
+
+    // cache positive and negative responses for their TTL
+    if (ttl > 0 && (status == Status::OK || status == Status::NOT_FOUND))
+        this->cache_[getKey(name, type)] = {status, addresses, now() + ttl};
+
+    // collect the requests that have all their queries completed, they are resumed after the lists were updated
+    std::list<Request> completed;
+    auto family = toFamily(type);
+    for (auto r = this->requests_.begin(); r != this->requests_.end();) {
+        auto request = r++;
+        if (request->name != name || (request->pending & family) == 0)
+            continue;
+        add(*request, type, status, addresses);
+        request->pending &= ~family;
+        if (request->pending == Family(0)) {
+            auto &result = *request->result;
+            result.status = result.endpoints.empty() ? request->status : Status::OK;
+            completed.splice(completed.end(), this->requests_, request);
+        }
+    }
+    for (auto &request : completed)
+        request.tasks.doAll();
+}
+
+void Resolver::handle(const uint8_t *data, int size) {
+    int id = dns::getId(data, size);
+    auto it = std::find_if(this->queries_.begin(), this->queries_.end(),
+        [id](const Query &query) {return query.id == id;});
+    if (it == this->queries_.end())
+        return;
+
+    // ignore responses that do not match the question, e.g. a late response to a previous query with the same id
+    dns::Response response;
+    if (!dns::parseResponse(data, size, String(it->name.c_str(), int(it->name.size())), it->type, response))
+        return;
+
+    Status status;
+    if (response.truncated) {
+        status = Status::FAILED;
+    } else if (response.code == dns::ResponseCode::NO_ERROR) {
+        status = response.addresses.empty() ? Status::NOT_FOUND : Status::OK;
+    } else if (response.code == dns::ResponseCode::NAME_ERROR) {
+        status = Status::NOT_FOUND;
+    } else {
+        status = Status::FAILED;
+    }
+    if (status != Status::OK)
+        response.addresses.clear();
+    complete(it, status, std::move(response.addresses), response.ttl);
+}
+
+Coroutine Resolver::send(std::shared_ptr<bool> destroyed) {
+    while (true) {
+        co_await untilSend();
+        if (*destroyed)
+            co_return;
+        uint16_t id = this->sendQueue_.front();
+        this->sendQueue_.erase(this->sendQueue_.begin());
+
+        // the query may have completed while it was waiting to be sent
+        auto it = std::find_if(this->queries_.begin(), this->queries_.end(),
+            [id](const Query &query) {return query.id == id;});
+        if (it == this->queries_.end())
+            continue;
+
+        int size = dns::encodeQuery(this->sendBuffer_.data(), this->sendBuffer_.capacity(), id,
+            String(it->name.c_str(), int(it->name.size())), it->type);
+        if (size == 0) {
+            // buffer too small
+            complete(it, Status::FAILED, {}, 0);
+            continue;
+        }
+        this->sendBuffer_.header<Endpoint>() = this->server_;
+        co_await this->sendBuffer_.write(size);
+        if (*destroyed)
+            co_return;
+    }
+}
+
+Coroutine Resolver::receive(std::shared_ptr<bool> destroyed) {
+    while (true) {
+        co_await this->receiveBuffer_.read();
+        if (*destroyed)
+            co_return;
+        if (!this->receiveBuffer_.ready()) {
+            // socket is closed: try again later
+            co_await this->loop_.sleep(this->interval_);
+            if (*destroyed)
+                co_return;
+            continue;
+        }
+        if (this->receiveBuffer_.header<Endpoint>() == this->server_)
+            handle(this->receiveBuffer_.data(), this->receiveBuffer_.size());
+    }
+}
+
+Coroutine Resolver::retransmit(std::shared_ptr<bool> destroyed) {
+    while (true) {
+        if (this->queries_.empty()) {
+            // start ticking when the first query was sent so that it gets retransmitted after one tick
+            co_await untilQuery();
+            if (*destroyed)
+                co_return;
+            ++this->tick_;
+        }
+        co_await this->loop_.sleep(this->interval_);
+        if (*destroyed)
+            co_return;
+        ++this->tick_;
+
+        for (auto it = this->queries_.begin(); it != this->queries_.end();) {
+            auto query = it++;
+            if (this->tick_ - query->tick < 2)
+                continue;
+            if (query->attempts >= this->attempts_) {
+                complete(query, Status::TIMEOUT, {}, 0);
+            } else {
+                ++query->attempts;
+                query->tick = this->tick_;
+                this->sendQueue_.push_back(query->id);
+                this->sendTasks_.doAll();
+            }
+        }
+    }
+}
+
+} // namespace ip
+} // namespace coco
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "dns.hpp"
+#include "ip.hpp"
+#include <coco/Buffer.hpp>
+#include <coco/Coroutine.hpp>
+#include <coco/Loop.hpp>
+#include <coco/enum.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace coco {
+namespace ip {
+
+/// @brief Asynchronous DNS resolver that turns host names into endpoints for IpSocket::connect() without blocking the
+/// event loop. Speaks the DNS wire protocol over a UdpSocket with a recursive DNS server.
+/// Names are looked up in this order: Numeric addresses, static hosts (e.g. loaded from /etc/hosts), the cache of
+/// previous responses which are kept for their TTL, and the DNS server. Concurrent lookups of the same name share one
+/// query, queries that get no response are sent again. Truncated responses are treated as failure (no TCP fallback).
+/// Usage:
+///   Resolver::Result result;
+///   co_await resolver.resolve("example.com", 80, result);
+///   if (result.status == Resolver::Status::OK) socket.connect(result.endpoints[0]);
+class Resolver {
+public:
+    /// @brief Address families to resolve
+    ///
+    enum class Family {
+        V4 = 1,
+        V6 = 2,
+        ANY = 3,
+    };
+
+    /// @brief Status of a resolution
+    ///
+    enum class Status {
+        OK,
+
+        // the name does not exist or has no addresses of the requested family
+        NOT_FOUND,
+
+        // the server did not respond
+        TIMEOUT,
+
+        // invalid name, the server failed, refused or truncated the response, or the resolver was destroyed
+        FAILED,
+    };
+
+    /// @brief Result of a resolution
+    ///
+    struct Result {
+        Status status;
+
+        // IPv6 endpoints first, then IPv4 endpoints, with the requested port
+        std::vector<Endpoint> endpoints;
+    };
+
+    /// @brief Constructor.
+    /// @param loop event loop for retransmitting queries
+    /// @param sendBuffer buffer of an open UdpSocket for sending queries, capacity at least 300
+    /// @param receiveBuffer buffer of the same UdpSocket for receiving responses, capacity dns::MAX_MESSAGE_SIZE
+    /// @param server endpoint of the DNS server, e.g. 127.0.0.53:53
+    /// @param interval tick of the retransmission timer, a query is sent again if there was no response after one to
+    /// two ticks
+    /// @param attempts number of times a query is sent before the resolution times out
+    Resolver(Loop &loop, Buffer &sendBuffer, Buffer &receiveBuffer, const Endpoint &server, Duration interval,
+        int attempts = 3);
+
+    /// @brief Destructor. Completes the outstanding resolutions with Status::FAILED and cancels the buffers, which
+    /// therefore have to outlive the resolver.
+    ~Resolver();
+
+    /// @brief Add a static host that takes precedence over the DNS server.
+    /// @param name host name
+    /// @param address address, the port is ignored
+    void addHost(String name, const Endpoint &address);
+
+    /// @brief Add the static hosts of a text in the format of /etc/hosts (address followed by names, # for comments).
+    /// @param text text
+    /// @return number of added entries
+    int addHosts(String text);
+
+    /// @brief Load the static hosts from a file.
+    /// @param path path of the file, e.g. /etc/hosts
+    /// @return true if the file could be read
+    bool loadHosts(const char *path);
+
+    /// @brief Remove all cached responses.
+    ///
+    void clearCache() {this->cache_.clear();}
+
+    /// @brief Resolve a name. Completes immediately if the name is a numeric address, a static host or cached.
+    /// @param name host name, e.g. "example.com", or numeric address
+    /// @param port port of the resulting endpoints
+    /// @param result result, has to stay valid until the resolution has completed
+    /// @param family address families to resolve
+    /// @return use co_await on return value to wait until the result is available
+    [[nodiscard]] Awaitable<CoroutineTask<>> resolve(String name, uint16_t port, Result &result,
+        Family family = Family::ANY);
+
+protected:
+    // outstanding query for one record type of a name, shared by all requests for the name
+    struct Query {
+        std::string name;
+        dns::Type type;
+        uint16_t id;
+
+        // number of times the query was sent and timer tick of the last send
+        int attempts;
+        int tick;
+    };
+
+    // resolution that a coroutine waits for
+    struct Request {
+        std::string name;
+        Family family;
+        uint16_t port;
+        Result *result;
+
+        // families whose query has not completed
+        Family pending;
+
+        // most relevant failure of the completed queries
+        Status status;
+
+        CoroutineTaskList<> tasks;
+    };
+
+    // cached response for one record type of a name
+    struct Entry {
+        Status status;
+        std::vector<Endpoint> addresses;
+
+        // expiry time in seconds of the steady clock
+        int64_t expires;
+    };
+
+    // key for the cache and the outstanding queries
+    static std::string getKey(const std::string &name, dns::Type type) {
+        return name + (type == dns::Type::A ? "/A" : "/AAAA");
+    }
+
+    // check if the name is a numeric address or a static host, fills in the result
+    bool resolveLocal(const std::string &name, uint16_t port, Result &result, Family family);
+
+    // get the cached entry of a name, nullptr if not cached or expired
+    const Entry *getCached(const std::string &name, dns::Type type);
+
+    // add the addresses of a cached entry or completed query to a request
+    static void add(Request &request, dns::Type type, Status status, const std::vector<Endpoint> &addresses);
+
+    // start a query unless the same query is outstanding
+    void startQuery(const std::string &name, dns::Type type);
+
+    // complete a query, cache the response and resume the requests that have all their queries completed
+    void complete(std::list<Query>::iterator it, Status status, std::vector<Endpoint> addresses, uint32_t ttl);
+
+    // handle a received response
+    void handle(const uint8_t *data, int size);
+
+    Awaitable<CoroutineTask<>> untilSend() {
+        if (!this->sendQueue_.empty())
+            return {};
+        return {this->sendTasks_};
+    }
+
+    Awaitable<CoroutineTask<>> untilQuery() {
+        if (!this->queries_.empty())
+            return {};
+        return {this->queryTasks_};
+    }
+
+    // the coroutines may outlive the resolver while they sleep, they check the destroyed flag when they get resumed
+    Coroutine send(std::shared_ptr<bool> destroyed);
+    Coroutine receive(std::shared_ptr<bool> destroyed);
+    Coroutine retransmit(std::shared_ptr<bool> destroyed);
+
+    Loop &loop_;
+    Buffer &sendBuffer_;
+    Buffer &receiveBuffer_;
+    Endpoint server_;
+    Duration interval_;
+    int attempts_;
+
+    // static hosts by lower case name
+    std::unordered_map<std::string, std::vector<Endpoint>> hosts_;
+
+    // cached responses by getKey()
+    std::unordered_map<std::string, Entry> cache_;
+
+    // outstanding queries, requests and ids of queries to send
+    std::list<Query> queries_;
+    std::list<Request> requests_;
+    std::vector<uint16_t> sendQueue_;
+
+    // random query ids make spoofed responses unlikely
+    std::minstd_rand random_;
+
+    // timer tick
+    int tick_ = 0;
+
+    // coroutines waiting for queries to send or for outstanding queries
+    CoroutineTaskList<> sendTasks_;
+    CoroutineTaskList<> queryTasks_;
+
+    // set by the destructor, shared with the coroutines
+    std::shared_ptr<bool> destroyed_ = std::make_shared<bool>(false);
+};
+COCO_ENUM(Resolver::Family)
+
+} // namespace ip
+} // namespace coco
@@ -0,0 +1,71 @@
+#include "SocketStatistics.hpp"
+#include <cerrno>
+
+
+namespace coco {
+
+SocketStatistics::Error SocketStatistics::classify(int error) {
+    switch (error) {
+    case ECONNREFUSED:
+    case EHOSTUNREACH:
+    case ENETUNREACH:
+    case EADDRNOTAVAIL:
+        return Error::UNREACHABLE;
+    case ECONNRESET:
+    case ECONNABORTED:
+    case EPIPE:
+    case ENOTCONN:
+        return Error::RESET;
+    case ETIMEDOUT:
+        return Error::TIMEOUT;
+    case ENOBUFS:
+    case ENOMEM:
+        return Error::NO_BUFFERS;
+    case EMSGSIZE:
+        return Error::MESSAGE_SIZE;
+    default:
+        return Error::OTHER;
+    }
+}
+
+uint64_t SocketStatistics::Histogram::count() const {
+    uint64_t count = 0;
+    for (uint64_t c : this->counts)
+        count += c;
+    return count;
+}
+
+uint64_t SocketStatistics::Histogram::percentile(double percent) const {
+    uint64_t total = count();
+    if (total == 0)
+        return 0;
+
+    // rank of the value, at least the first value
+    uint64_t rank = uint64_t(percent / 100.0 * double(total) + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t count = 0;
+    for (int i = 0; i < BUCKET_COUNT - 1; ++i) {
+        count += this->counts[i];
+        if (count >= rank)
+            return lowerBound(i + 1) - 1;
+    }
+    return lowerBound(BUCKET_COUNT - 1);
+}
+
+SocketStatistics::Snapshot SocketStatistics::snapshot() const {
+    Snapshot s;
+    s.received = {this->received_.packets.load(std::memory_order_relaxed),
+        this->received_.bytes.load(std::memory_order_relaxed)};
+    s.sent = {this->sent_.packets.load(std::memory_order_relaxed), this->sent_.bytes.load(std::memory_order_relaxed)};
+    for (int i = 0; i < ERROR_COUNT; ++i)
+        s.errors[i] = this->errors_[i].load(std::memory_order_relaxed);
+    s.drops = this->drops_.load(std::memory_order_relaxed);
+    s.inFlight = this->inFlight_.load(std::memory_order_relaxed);
+    for (int i = 0; i < Histogram::BUCKET_COUNT; ++i)
+        s.latency.counts[i] = this->latency_[i].load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace coco
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+
+namespace coco {
+
+/// @brief Statistics of sockets: packets and bytes in each direction, errors by class, datagrams dropped by the
+/// kernel, number of buffers in flight and the latency from start to completion of buffers.
+/// A socket updates its statistics from the thread of its event loop (see UdpSocket::setStatistics() and
+/// IpSocket::setStatistics()), sockets of the same event loop may share one object. The counters are atomics that
+/// only one thread writes, therefore updating needs no locked instructions and other threads (e.g. a monitoring thread)
+/// can take a snapshot at any time without locking.
+class SocketStatistics {
+public:
+    /// @brief Classes of errors
+    ///
+    enum class Error {
+        // destination, port or network unreachable, connection refused
+        UNREACHABLE,
+
+        // connection reset or aborted, broken pipe
+        RESET,
+
+        // timeout
+        TIMEOUT,
+
+        // no buffer space or memory in the kernel
+        NO_BUFFERS,
+
+        // message too long (e.g. larger than the path MTU with "don't fragment")
+        MESSAGE_SIZE,
+
+        // all other errors
+        OTHER,
+    };
+    static constexpr int ERROR_COUNT = 6;
+
+    /// @brief Get the class of an error.
+    /// @param error errno value
+    /// @return error class
+    static Error classify(int error);
+
+    /// @brief Histogram with logarithmic buckets that are divided linearly (like HdrHistogram).
+    /// A bucket is at most 1/16 of its lower bound wide, values up to 2^40 (about 18 minutes in nanoseconds) are
+    /// recorded with a relative error of less than 6.25%, greater values are counted in the last bucket.
+    struct Histogram {
+        static constexpr int SUB_BITS = 4;
+        static constexpr int SUB_COUNT = 1 << SUB_BITS;
+        static constexpr int MAX_BITS = 40;
+        static constexpr int BUCKET_COUNT = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+        uint64_t counts[BUCKET_COUNT] = {};
+
+
+        /// @brief Get the bucket of a value.
+        /// @param value value
+        /// @return bucket index
+        static int index(uint64_t value) {
+            if (value < SUB_COUNT)
+                return int(value);
+            int bits = std::bit_width(value) - 1;
+            if (bits >= MAX_BITS)
+                return BUCKET_COUNT - 1;
+            int shift = bits - SUB_BITS;
+            return (shift + 1) * SUB_COUNT + int((value >> shift) & (SUB_COUNT - 1));
+        }
+
+        /// @brief Get the smallest value of a bucket.
+        /// @param index bucket index
+        /// @return smallest value
+        static uint64_t lowerBound(int index) {
+            if (index < SUB_COUNT)
+                return index;
+            int shift = index / SUB_COUNT - 1;
+            return uint64_t(SUB_COUNT + index % SUB_COUNT) << shift;
+        }
+
+        void record(uint64_t value) {++this->counts[index(value)];}
+
+        /// @brief Get the number of recorded values.
+        ///
+        uint64_t count() const;
+
+        /// @brief Get the value below or at which a given percentage of the recorded values lies.
+        /// @param percent percentage, e.g. 50 for the median or 99
+        /// @return greatest value of the bucket that contains the percentile, 0 if no values were recorded
+        uint64_t percentile(double percent) const;
+    };
+
+    /// @brief Counters of one direction
+    ///
+    struct Counters {
+        // number of datagrams (UDP) or completed buffers (TCP)
+        uint64_t packets;
+        uint64_t bytes;
+    };
+
+    /// @brief Copy of the statistics at one point in time
+    ///
+    struct Snapshot {
+        Counters received;
+        Counters sent;
+
+        // number of failed transfers for each error class, indexed by int(Error)
+        uint64_t errors[ERROR_COUNT];
+
+        // number of datagrams that the kernel dropped because the receive queue of the socket was full (SO_RXQ_OVFL)
+        uint64_t drops;
+
+        // number of started buffers that were not finished yet
+        int64_t inFlight;
+
+        // time from start to completion of buffers in nanoseconds
+        Histogram latency;
+    };
+
+    /// @brief Take a snapshot of the statistics, can be called from any thread.
+    /// Each counter is read atomically, counters that change while the snapshot is taken may be off by the last
+    /// transfer.
+    /// @return snapshot
+    Snapshot snapshot() const;
+
+
+    // methods that are called by the sockets from the thread of the event loop
+
+    /// @brief Get the current time for measuring the latency.
+    /// @return time in nanoseconds
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// @brief A buffer was started.
+    /// @return start time for received() or sent()
+    uint64_t start() {
+        add(this->inFlight_, 1);
+        return now();
+    }
+
+    /// @brief A read buffer has finished.
+    /// @param packets number of received datagrams (more than one with GRO)
+    /// @param bytes number of received bytes
+    /// @param started start time of the buffer
+    void received(int packets, int bytes, uint64_t started) {
+        add(this->received_.packets, packets);
+        add(this->received_.bytes, bytes);
+        finish(started);
+    }
+
+    /// @brief A write buffer has finished.
+    /// @param packets number of sent datagrams (more than one with segment size)
+    /// @param bytes number of sent bytes
+    /// @param started start time of the buffer
+    void sent(int packets, int bytes, uint64_t started) {
+        add(this->sent_.packets, packets);
+        add(this->sent_.bytes, bytes);
+        finish(started);
+    }
+
+    /// @brief A transfer has failed, the buffer gets reported by finished().
+    /// @param error error class
+    void failed(Error error) {
+        add(this->errors_[int(error)], 1);
+    }
+
+    /// @brief A buffer has finished without data, e.g. after an error or when it was cancelled.
+    ///
+    void finished() {
+        add(this->inFlight_, -1);
+    }
+
+    /// @brief The kernel has dropped datagrams.
+    /// @param count number of dropped datagrams
+    void dropped(uint32_t count) {
+        add(this->drops_, count);
+    }
+
+protected:
+    // counters have only one writer, a plain load and store is enough
+    template <typename T, typename V>
+    static void add(std::atomic<T> &counter, V value) {
+        counter.store(counter.load(std::memory_order_relaxed) + T(value), std::memory_order_relaxed);
+    }
+
+    void finish(uint64_t started) {
+        add(this->latency_[Histogram::index(now() - started)], 1);
+        add(this->inFlight_, -1);
+    }
+
+    struct AtomicCounters {
+        std::atomic<uint64_t> packets = 0;
+        std::atomic<uint64_t> bytes = 0;
+    };
+
+    AtomicCounters received_;
+    AtomicCounters sent_;
+    std::atomic<uint64_t> errors_[ERROR_COUNT] = {};
+    std::atomic<uint64_t> drops_ = 0;
+    std::atomic<int64_t> inFlight_ = 0;
+    std::atomic<uint64_t> latency_[Histogram::BUCKET_COUNT] = {};
+};
+
+} // namespace coco
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "AccessList.hpp"
+#include "BufferChain.hpp"
 #include "ip.hpp"
+#include "SocketStatistics.hpp"
 #include <coco/BufferDevice.hpp>
+#include <coco/enum.hpp>
+#include <algorithm>
+#include <span>
 
 
 namespace coco {
@@ -10,18 +16,151 @@ namespace coco {
 /// UDP is the IP protocol for datagram communication.
 class UdpSocket : public BufferDevice {
 public:
+    /// @brief Flags for opening the socket
+    ///
+    enum class Flags {
+        NONE = 0,
+
+        /// @brief Generic receive offload (GRO), a read buffer may receive multiple datagrams from the same sender.
+        /// Use Datagrams to iterate over them. Ignored on platforms that do not support GRO.
+        GRO = 1,
+
+        /// @brief Let multiple sockets share the local port (SO_REUSEPORT), the kernel distributes the received
+        /// datagrams over the sockets. Ignored on platforms that do not support load balancing between sockets.
+        REUSE_PORT = 2,
+
+        /// @brief Kernel or hardware timestamps (SO_TIMESTAMPING), see Header::timestamp. A write buffer stays busy
+        /// until its transmit timestamp was reported. The kernel reports nothing for a datagram that was dropped
+        /// before it reached the network device, then the buffer finishes without timestamp when the timestamp of a
+        /// later datagram gets reported or after a timeout of 100ms. Ignored on platforms that do not support
+        /// timestamps.
+        TIMESTAMPS = 4,
+
+        /// @brief Dual-stack socket (IPV6_V6ONLY=0) that serves IPv4 and IPv6 peers on one port, halving the buffers
+        /// and event sources compared to one socket per protocol. Senders with IPv4-mapped addresses are reported as
+        /// ip::v4::Endpoint and IPv4 receivers get converted to IPv4-mapped addresses when writing.
+        /// Ignored when opening with ip::v4::PROTOCOL_ID.
+        DUAL_STACK = 8,
+    };
+
+    /// @brief Header of the buffers of a UDP socket.
+    /// Starts with the endpoint, therefore buffer.header<ip::Endpoint>() can be used if only the endpoint is needed.
+    struct Header {
+        /// @brief Endpoint of the receiver when writing, endpoint of the sender after reading
+        ip::Endpoint endpoint;
+
+        /// @brief Size of the datagrams if the buffer holds multiple datagrams to or from the same endpoint.
+        /// When writing, the data gets split into datagrams of this size where the last one may be shorter
+        /// (uses segmentation offload if supported by the platform, 0 for one datagram)
+        int segmentSize;
+
+        /// @brief With Flags::TIMESTAMPS, time in nanoseconds since the epoch when the datagram was received by the
+        /// host after reading, or when the (last) datagram was handed to the network device after writing. Taken by
+        /// the network device if it supports hardware timestamps, else by the kernel. 0 if not available
+        uint64_t timestamp;
+    };
+
+    /// @brief Range over the datagrams in a buffer of a UDP socket.
+    /// Usage: for (auto datagram : UdpSocket::Datagrams(buffer)) {...}
+    class Datagrams {
+    public:
+        class Iterator {
+        public:
+            std::span<uint8_t> operator *() const {
+                return {data, size_t(std::min(segmentSize, int(end - data)))};
+            }
+            Iterator &operator ++() {data += segmentSize; return *this;}
+            bool operator !=(const Iterator &it) const {return data < it.data;}
+
+            uint8_t *data;
+            uint8_t *end;
+            int segmentSize;
+        };
+
+        /// @brief Constructor.
+        /// @param buffer Buffer with UdpSocket::Header
+        Datagrams(Buffer &buffer)
+            : data_(buffer.data()), size_(buffer.size()), segmentSize_(buffer.header<Header>().segmentSize)
+        {
+            // one datagram if there is no segment size
+            if (segmentSize_ <= 0 || segmentSize_ > size_)
+                segmentSize_ = size_;
+        }
+
+        Iterator begin() const {
+            // an empty datagram is also a datagram
+            return {data_, data_ + size_, segmentSize_ > 0 ? segmentSize_ : 1};
+        }
+        Iterator end() const {
+            return {data_ + (size_ > 0 ? size_ : 1), data_ + size_, 0};
+        }
+
+    protected:
+        uint8_t *data_;
+        int size_;
+        int segmentSize_;
+    };
+
     UdpSocket(State state) : BufferDevice(state) {}
 
     /// @brief Open the socket on a local port.
     /// @param protocolId Protocol id such as ip::v4::PROTOCOL_ID or ip::v6::PROTOCOL_ID
     /// @param localPort Local port number
+    /// @param flags Flags such as Flags::GRO or Flags::REUSE_PORT
     /// @return true if successful
-    virtual bool open(uint16_t protocolId, int localPort) = 0;
+    virtual bool open(uint16_t protocolId, int localPort, Flags flags = Flags::NONE) = 0;
 
     /// @brief Join an IPv6 multicast group
     /// @param multicastGroup Address of multicast group
     /// @return true if successful
     virtual bool join(const ip::v6::Address &multicastGroup) = 0;
+
+    /// @brief Filter the received datagrams by the address of the sender. Datagrams from denied senders are dropped
+    /// and the read buffer continues receiving, therefore no coroutine gets resumed for them.
+    /// @param accessList Access list, has to stay valid while it is set, nullptr to receive from all senders
+    void setAccessList(const ip::AccessList *accessList) {this->accessList_ = accessList;}
+
+    /// @brief Collect statistics of the transfers. Set before opening the socket, datagrams dropped by the kernel are
+    /// only counted if the statistics were set when the socket was opened.
+    /// @param statistics Statistics, have to stay valid while they are set, nullptr to collect no statistics
+    void setStatistics(SocketStatistics *statistics) {this->statistics_ = statistics;}
+
+    /// @brief Busy poll the network device when receiving instead of waiting for an interrupt (SO_BUSY_POLL), trades
+    /// CPU time for latency. Set before opening the socket, ignored on platforms that do not support busy polling.
+    /// @param time Time in microseconds to poll before waiting, 0 to disable
+    void setBusyPoll(int time) {this->busyPollTime_ = time;}
+
+protected:
+    // check if a datagram from the given sender gets accepted
+    bool accept(const ip::Endpoint &sender) const {
+        return this->accessList_ == nullptr || this->accessList_->allowed(sender);
+    }
+
+    // report a sender with IPv4-mapped address as IPv4 endpoint on a dual-stack socket
+    void unmap(ip::Endpoint &sender) const {
+        if (this->dualStack_)
+            sender = sender.unmapV4();
+    }
+
+    // get the receiver to pass to the platform, on a dual-stack socket an IPv4 receiver is converted to its IPv4-mapped
+    // address which is stored in the given endpoint
+    void *map(ip::Endpoint &receiver, ip::v6::Endpoint &mapped) const {
+        if (!this->dualStack_ || receiver.protocolId != ip::v4::PROTOCOL_ID)
+            return &receiver;
+        mapped = receiver.mapV4().v6;
+        return &mapped;
+    }
+
+    // number of datagrams in a buffer with the given segment size
+    static int getDatagramCount(int size, int segmentSize) {
+        return segmentSize > 0 && size > segmentSize ? (size + segmentSize - 1) / segmentSize : 1;
+    }
+
+    const ip::AccessList *accessList_ = nullptr;
+    SocketStatistics *statistics_ = nullptr;
+    int busyPollTime_ = 0;
+    bool dualStack_ = false;
 };
+COCO_ENUM(UdpSocket::Flags)
 
 } // namespace coco
@@ -0,0 +1,259 @@
+#include "dns.hpp"
+#include <algorithm>
+
+
+namespace coco {
+namespace ip {
+namespace dns {
+
+namespace {
+
+// class of Internet records
+constexpr uint16_t CLASS_IN = 1;
+
+// flags of the header
+constexpr uint16_t FLAG_RESPONSE = 0x8000;
+constexpr uint16_t FLAG_TRUNCATED = 0x0200;
+constexpr uint16_t FLAG_RECURSION_DESIRED = 0x0100;
+constexpr uint16_t OPCODE_MASK = 0x7800;
+
+// maximum size of an encoded name
+constexpr int MAX_ENCODED_NAME_SIZE = 255;
+
+// maximum number of compression pointers in a name, protects against pointer loops
+constexpr int MAX_POINTERS = 32;
+
+constexpr char toLower(char ch) {
+    return ch >= 'A' && ch <= 'Z' ? ch + ('a' - 'A') : ch;
+}
+
+// remove the trailing dot of an absolute name
+String trim(String name) {
+    if (name.size() > 0 && name[name.size() - 1] == '.')
+        return {name.begin(), name.size() - 1};
+    return name;
+}
+
+uint16_t get16(const uint8_t *data) {
+    return data[0] << 8 | data[1];
+}
+
+uint32_t get32(const uint8_t *data) {
+    return uint32_t(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+uint8_t *put16(uint8_t *it, uint16_t value) {
+    it[0] = value >> 8;
+    it[1] = value;
+    return it + 2;
+}
+
+// read a possibly compressed name into a buffer of MAX_ENCODED_NAME_SIZE characters in dotted notation, returns the
+// offset after the name at its original position or -1 if the name is malformed
+int readName(const uint8_t *data, int size, int offset, char *name, int &length) {
+    int end = -1;
+    int pointers = 0;
+    length = 0;
+    while (true) {
+        if (offset >= size)
+            return -1;
+        int labelLength = data[offset];
+        if ((labelLength & 0xc0) == 0xc0) {
+            // compression pointer to an earlier name
+            if (offset + 1 >= size || ++pointers > MAX_POINTERS)
+                return -1;
+            if (end == -1)
+                end = offset + 2;
+            offset = (labelLength & 0x3f) << 8 | data[offset + 1];
+            continue;
+        }
+        if (labelLength > 63)
+            return -1;
+        ++offset;
+        if (labelLength == 0)
+            break;
+        if (offset + labelLength > size || length + labelLength + 1 > MAX_ENCODED_NAME_SIZE)
+            return -1;
+        if (length > 0)
+            name[length++] = '.';
+        for (int i = 0; i < labelLength; ++i)
+            name[length++] = char(data[offset + i]);
+        offset += labelLength;
+    }
+    return end == -1 ? offset : end;
+}
+
+// skip a possibly compressed name, returns the offset after the name or -1 if the name is malformed
+int skipName(const uint8_t *data, int size, int offset) {
+    while (offset < size) {
+        int labelLength = data[offset];
+        if ((labelLength & 0xc0) == 0xc0)
+            return offset + 2 <= size ? offset + 2 : -1;
+        if (labelLength > 63)
+            return -1;
+        offset += 1 + labelLength;
+        if (labelLength == 0)
+            return offset <= size ? offset : -1;
+    }
+    return -1;
+}
+
+} // namespace
+
+
+bool valid(String name) {
+    name = trim(name);
+    if (name.size() == 0 || name.size() > MAX_NAME_LENGTH)
+        return false;
+    int labelLength = 0;
+    for (char ch : name) {
+        if (ch == '.') {
+            if (labelLength == 0)
+                return false;
+            labelLength = 0;
+        } else if (++labelLength > 63) {
+            return false;
+        }
+    }
+    return labelLength > 0;
+}
+
+bool equal(String a, String b) {
+    a = trim(a);
+    b = trim(b);
+    if (a.size() != b.size())
+        return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (toLower(a[i]) != toLower(b[i]))
+            return false;
+    }
+    return true;
+}
+
+int encodeQuery(uint8_t *data, int capacity, uint16_t id, String name, Type type) {
+    if (!valid(name))
+        return 0;
+    name = trim(name);
+
+    // header, question (labels, root label, type, class) and OPT record
+    int size = 12 + 1 + name.size() + 1 + 4 + 11;
+    if (size > capacity)
+        return 0;
+
+    // header with one question and one additional record
+    uint8_t *it = data;
+    it = put16(it, id);
+    it = put16(it, FLAG_RECURSION_DESIRED);
+    it = put16(it, 1);
+    it = put16(it, 0);
+    it = put16(it, 0);
+    it = put16(it, 1);
+
+    // question: labels prefixed by their length
+    auto begin = name.begin();
+    auto end = name.end();
+    while (begin != end) {
+        auto dot = std::find(begin, end, '.');
+        *it++ = uint8_t(dot - begin);
+        it = std::copy(begin, dot, it);
+        begin = dot == end ? end : dot + 1;
+    }
+    *it++ = 0;
+    it = put16(it, uint16_t(type));
+    it = put16(it, CLASS_IN);
+
+    // EDNS(0) OPT record that announces the UDP payload size in its class
+    *it++ = 0;
+    it = put16(it, uint16_t(Type::OPT));
+    it = put16(it, MAX_MESSAGE_SIZE);
+    it = put16(it, 0);
+    it = put16(it, 0);
+    it = put16(it, 0);
+
+    return int(it - data);
+}
+
+bool parseResponse(const uint8_t *data, int size, String name, Type type, Response &response) {
+    if (size < 12)
+        return false;
+    uint16_t flags = get16(data + 2);
+    if ((flags & FLAG_RESPONSE) == 0 || (flags & OPCODE_MASK) != 0 || get16(data + 4) != 1)
+        return false;
+    response.id = get16(data);
+    response.code = ResponseCode(flags & 0x0f);
+    response.truncated = (flags & FLAG_TRUNCATED) != 0;
+    response.addresses.clear();
+    int answerCount = get16(data + 6);
+    int authorityCount = get16(data + 8);
+
+    // the question has to match the query
+    char owner[MAX_ENCODED_NAME_SIZE];
+    int length;
+    int offset = readName(data, size, 12, owner, length);
+    if (offset == -1 || offset + 4 > size || !equal(String(owner, length), name)
+        || get16(data + offset) != uint16_t(type) || get16(data + offset + 2) != CLASS_IN)
+    {
+        return false;
+    }
+    offset += 4;
+
+    // name whose records are used, follows the aliases (CNAME records are ordered along the chain)
+    char current[MAX_ENCODED_NAME_SIZE];
+    int currentLength = std::min(trim(name).size(), MAX_ENCODED_NAME_SIZE);
+    std::copy(name.begin(), name.begin() + currentLength, current);
+
+    uint32_t ttl = 0xffffffff;
+    for (int i = 0; i < answerCount + authorityCount; ++i) {
+        // record header
+        offset = readName(data, size, offset, owner, length);
+        if (offset == -1 || offset + 10 > size)
+            return false;
+        auto recordType = Type(get16(data + offset));
+        uint16_t recordClass = get16(data + offset + 2);
+        uint32_t recordTtl = get32(data + offset + 4);
+        int dataSize = get16(data + offset + 8);
+        offset += 10;
+        if (offset + dataSize > size)
+            return false;
+        const uint8_t *recordData = data + offset;
+
+        if (recordClass == CLASS_IN) {
+            bool answer = i < answerCount;
+            bool matches = equal(String(owner, length), String(current, currentLength));
+            if (answer && matches && recordType == Type::CNAME) {
+                // continue with the target of the alias
+                if (readName(data, size, offset, current, currentLength) == -1)
+                    return false;
+                ttl = std::min(ttl, recordTtl);
+            } else if (answer && matches && recordType == type) {
+                if (type == Type::A && dataSize == 4) {
+                    auto &address = response.addresses.emplace_back(Endpoint{.v4 = {}});
+                    std::copy(recordData, recordData + 4, address.v4.address.u8);
+                    ttl = std::min(ttl, recordTtl);
+                } else if (type == Type::AAAA && dataSize == 16) {
+                    auto &address = response.addresses.emplace_back(Endpoint{.v6 = {}});
+                    std::copy(recordData, recordData + 16, address.v6.address.u8);
+                    ttl = std::min(ttl, recordTtl);
+                }
+            } else if (!answer && recordType == Type::SOA && response.addresses.empty()) {
+                // negative response: the SOA record limits the time for caching (RFC 2308)
+                int it = skipName(data, offset + dataSize, offset);
+                if (it != -1)
+                    it = skipName(data, offset + dataSize, it);
+                if (it != -1 && it + 20 <= offset + dataSize)
+                    ttl = std::min(ttl, std::min(recordTtl, get32(data + it + 16)));
+            }
+        }
+        offset += dataSize;
+    }
+
+    // no cacheable records
+    if (ttl == 0xffffffff)
+        ttl = 0;
+    response.ttl = ttl;
+    return true;
+}
+
+} // namespace dns
+} // namespace ip
+} // namespace coco
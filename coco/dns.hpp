@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ip.hpp"
+#include <cstdint>
+#include <vector>
+
+
+namespace coco {
+namespace ip {
+
+/// @brief DNS wire format (RFC 1035) for address queries over UDP, as used by Resolver.
+///
+namespace dns {
+
+/// @brief UDP port of DNS servers
+constexpr uint16_t PORT = 53;
+
+/// @brief Maximum size of a DNS message that a query announces with EDNS(0) (RFC 6891), the size that avoids IP
+/// fragmentation on common paths (DNS flag day 2020). Buffers for receiving responses should have this size.
+constexpr int MAX_MESSAGE_SIZE = 1232;
+
+/// @brief Maximum length of a name in dotted notation without trailing dot
+constexpr int MAX_NAME_LENGTH = 253;
+
+/// @brief Record types
+///
+enum class Type : uint16_t {
+    A = 1,
+    CNAME = 5,
+    SOA = 6,
+    AAAA = 28,
+    OPT = 41,
+};
+
+/// @brief Response codes
+///
+enum class ResponseCode : uint8_t {
+    NO_ERROR = 0,
+    FORMAT_ERROR = 1,
+    SERVER_FAILURE = 2,
+
+    // the name does not exist (NXDOMAIN)
+    NAME_ERROR = 3,
+
+    NOT_IMPLEMENTED = 4,
+    REFUSED = 5,
+};
+
+/// @brief Response to an address query
+///
+struct Response {
+    uint16_t id;
+    ResponseCode code;
+
+    // the response did not fit into the UDP message
+    bool truncated;
+
+    // addresses of the A or AAAA records of the name or of its aliases (CNAME), the ports are 0
+    std::vector<Endpoint> addresses;
+
+    // time in seconds that the response may be cached: the minimum TTL of the used records, for a negative response
+    // the minimum of the SOA record (RFC 2308), 0 if the response must not be cached
+    uint32_t ttl;
+};
+
+/// @brief Check if a string is a valid name for a query (labels of 1 to 63 characters, optional trailing dot).
+/// @param name name, e.g. "example.com"
+/// @return true if valid
+bool valid(String name);
+
+/// @brief Compare two names case-insensitively, a trailing dot is ignored.
+///
+bool equal(String a, String b);
+
+/// @brief Encode a recursive query for one record type of a name.
+/// @param data buffer for the message
+/// @param capacity capacity of the buffer
+/// @param id id of the query which the response repeats, should be random
+/// @param name name, e.g. "example.com"
+/// @param type record type, Type::A or Type::AAAA
+/// @return size of the message, 0 if the name is invalid or the buffer is too small
+int encodeQuery(uint8_t *data, int capacity, uint16_t id, String name, Type type);
+
+/// @brief Get the id of a message.
+/// @param data message
+/// @param size size of the message
+/// @return id, -1 if the message is too short
+inline int getId(const uint8_t *data, int size) {
+    return size >= 12 ? data[0] << 8 | data[1] : -1;
+}
+
+/// @brief Parse the response to an address query. The question of the response has to match the given name and type,
+/// otherwise the response is rejected (e.g. a spoofed or late response).
+/// @param data message
+/// @param size size of the message
+/// @param name name of the query
+/// @param type record type of the query
+/// @param response parsed response
+/// @return true if the message is a well-formed response to the query
+bool parseResponse(const uint8_t *data, int size, String name, Type type, Response &response);
+
+} // namespace dns
+} // namespace ip
+} // namespace coco
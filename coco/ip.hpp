@@ -17,33 +17,33 @@ struct Net16 {
 
     Net16() = default;
 
-    Net16(uint16_t x) {
+    constexpr Net16(uint16_t x) {
         value = (x >> 8)
         | (x << 8);
     }
 
-    operator uint16_t () const {
+    constexpr operator uint16_t () const {
         return (value >> 8)
         | (value << 8);
     }
 
-    void operator =(uint16_t x) {
+    constexpr void operator =(uint16_t x) {
         value = (x >> 8)
         | (x << 8);
     }
 };
 
 template <typename T>
-bool operator ==(const Net16 &x, const T &y) {
+constexpr bool operator ==(const Net16 &x, const T &y) {
     return x.value == Net16(y).value;
 }
 
 template <typename T>
-bool operator ==(const T &x, const Net16 &y) {
+constexpr bool operator ==(const T &x, const Net16 &y) {
     return Net16(x).value == y.value;
 }
 
-inline bool operator ==(const Net16 &x, const Net16 &y) {
+constexpr bool operator ==(const Net16 &x, const Net16 &y) {
     return x.value == y.value;
 }
 
@@ -55,21 +55,21 @@ struct Net32 {
 
     Net32() = default;
 
-    Net32(uint32_t x) {
+    constexpr Net32(uint32_t x) {
         value = (x >> 24)
         | ((x >> 8) & 0x0000ff00)
         | ((x << 8) & 0x00ff0000)
         | (x << 24);
     }
 
-    operator uint32_t () const {
+    constexpr operator uint32_t () const {
         return (value >> 24)
         | ((value >> 8) & 0x0000ff00)
         | ((value << 8) & 0x00ff0000)
         | (value << 24);
     }
 
-    void operator =(uint32_t x) {
+    constexpr void operator =(uint32_t x) {
         value = ((x >> 24)
         | ((x >> 8) & 0x0000ff00)
         | ((x << 8) & 0x00ff0000)
@@ -78,16 +78,16 @@ struct Net32 {
 };
 
 template <typename T>
-bool operator ==(const Net32 &x, const T &y) {
+constexpr bool operator ==(const Net32 &x, const T &y) {
     return x.value == Net32(y).value;
 }
 
 template <typename T>
-bool operator ==(const T &x, const Net32 &y) {
+constexpr bool operator ==(const T &x, const Net32 &y) {
     return Net32(x).value == y.value;
 }
 
-inline bool operator ==(const Net32 &x, const Net32 &y) {
+constexpr bool operator ==(const Net32 &x, const Net32 &y) {
     return x.value == y.value;
 }
 
@@ -104,6 +104,260 @@ constexpr uint32_t hostToNetwork(uint32_t x) {
         | (x << 24);
 }
 
+namespace detail {
+
+constexpr bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+constexpr int hexDigit(char ch) {
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+// parse a decimal number without leading zeros, returns the end of the number or nullptr on error
+constexpr const char *parseDecimal(const char *it, const char *end, uint32_t maxValue, uint32_t &value) {
+    if (it == end || !isDigit(*it))
+        return nullptr;
+    value = *it++ - '0';
+    if (value == 0)
+        return it;
+    while (it != end && isDigit(*it)) {
+        // check before multiplying, value * 10 + d can wrap around for maxValue 0xffffffff
+        uint32_t d = *it++ - '0';
+        if (value > (maxValue - d) / 10)
+            return nullptr;
+        value = value * 10 + d;
+    }
+    return it;
+}
+
+// parse an IPv4 address in dotted decimal notation
+constexpr const char *parseV4(const char *it, const char *end, uint8_t *address) {
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) {
+            if (it == end || *it != '.')
+                return nullptr;
+            ++it;
+        }
+        uint32_t value;
+        it = parseDecimal(it, end, 255, value);
+        if (it == nullptr)
+            return nullptr;
+        address[i] = value;
+    }
+    return it;
+}
+
+// parse an IPv6 address in the text representation of RFC 4291, including an embedded IPv4 address
+constexpr const char *parseV6(const char *it, const char *end, uint8_t *address) {
+    uint8_t bytes[16] = {};
+    int count = 0;
+
+    // position of "::" in bytes
+    int gap = -1;
+    if (it != end && *it == ':') {
+        if (end - it < 2 || it[1] != ':')
+            return nullptr;
+        it += 2;
+        gap = 0;
+    }
+
+    if (gap != 0 || (it != end && hexDigit(*it) >= 0)) {
+        while (true) {
+            const char *start = it;
+            uint32_t value = 0;
+            int digits = 0;
+            while (it != end && digits < 5 && hexDigit(*it) >= 0) {
+                value = value * 16 + hexDigit(*it++);
+                ++digits;
+            }
+            if (digits == 0)
+                return nullptr;
+
+            if (it != end && *it == '.') {
+                // embedded IPv4 address in the last 32 bits
+                if (count > 12)
+                    return nullptr;
+                it = parseV4(start, end, bytes + count);
+                if (it == nullptr)
+                    return nullptr;
+                count += 4;
+                break;
+            }
+            if (digits > 4)
+                return nullptr;
+            bytes[count++] = value >> 8;
+            bytes[count++] = value;
+
+            if (count == 16 || it == end || *it != ':')
+                break;
+            if (end - it >= 2 && it[1] == ':') {
+                // "::" is allowed only once
+                if (gap != -1)
+                    return nullptr;
+                it += 2;
+                gap = count;
+                if (it == end || hexDigit(*it) < 0)
+                    break;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // "::" stands for at least one group of zeros
+    if (gap == -1 ? count != 16 : count > 14)
+        return nullptr;
+
+    // copy groups before and after "::"
+    int tail = gap == -1 ? 0 : count - gap;
+    int head = count - tail;
+    for (int i = 0; i < head; ++i)
+        address[i] = bytes[i];
+    for (int i = head; i < 16 - tail; ++i)
+        address[i] = 0;
+    for (int i = 0; i < tail; ++i)
+        address[16 - tail + i] = bytes[head + i];
+    return it;
+}
+
+// parse ":port" if present
+constexpr const char *parsePort(const char *it, const char *end, uint16_t &port) {
+    if (it == end)
+        return it;
+    if (*it != ':')
+        return nullptr;
+
+    // the port must have at least one digit
+    uint32_t value = 0;
+    it = parseDecimal(it + 1, end, 65535, value);
+    if (it == nullptr)
+        return nullptr;
+    port = value;
+    return it;
+}
+
+// parse "/length" of a prefix if present, otherwise the length is the maximum length
+constexpr const char *parseLength(const char *it, const char *end, int maxLength, int &length) {
+    length = maxLength;
+    if (it == end)
+        return it;
+    if (*it != '/')
+        return nullptr;
+
+    // the length must have at least one digit
+    uint32_t value = 0;
+    it = parseDecimal(it + 1, end, maxLength, value);
+    if (it == nullptr)
+        return nullptr;
+    length = value;
+    return it;
+}
+
+// clear the bits of an address that are not covered by the prefix length
+constexpr void clearHostBits(uint8_t *address, int size, int length) {
+    for (int i = 0; i < size; ++i) {
+        int bits = length - i * 8;
+        if (bits <= 0)
+            address[i] = 0;
+        else if (bits < 8)
+            address[i] &= uint8_t(0xff00 >> bits);
+    }
+}
+
+constexpr char *formatDecimal(char *it, uint32_t value) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    while (count > 0)
+        *it++ = digits[--count];
+    return it;
+}
+
+constexpr char *formatV4(char *it, const uint8_t *address) {
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0)
+            *it++ = '.';
+        it = formatDecimal(it, address[i]);
+    }
+    return it;
+}
+
+// format an IPv6 address in the recommended text representation of RFC 5952
+constexpr char *formatV6(char *it, const uint8_t *address) {
+    uint16_t groups[8];
+    for (int i = 0; i < 8; ++i)
+        groups[i] = (address[i * 2] << 8) | address[i * 2 + 1];
+
+    // IPv4-mapped address
+    if (groups[0] == 0 && groups[1] == 0 && groups[2] == 0 && groups[3] == 0 && groups[4] == 0 && groups[5] == 0xffff) {
+        for (char ch : "::ffff:")
+            if (ch != 0)
+                *it++ = ch;
+        return formatV4(it, address + 12);
+    }
+
+    // find the first longest run of at least two zero groups which gets replaced by "::"
+    int gapStart = -1;
+    int gapLength = 1;
+    for (int i = 0; i < 8;) {
+        int j = i;
+        while (j < 8 && groups[j] == 0)
+            ++j;
+        if (j - i > gapLength) {
+            gapStart = i;
+            gapLength = j - i;
+        }
+        i = j + 1;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (i == gapStart) {
+            *it++ = ':';
+            *it++ = ':';
+            i += gapLength - 1;
+            continue;
+        }
+        if (i > 0 && i != gapStart + gapLength)
+            *it++ = ':';
+
+        // lower case hex without leading zeros
+        uint16_t group = groups[i];
+        bool leading = true;
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            int digit = (group >> shift) & 15;
+            if (leading && digit == 0 && shift > 0)
+                continue;
+            leading = false;
+            *it++ = "0123456789abcdef"[digit];
+        }
+    }
+    return it;
+}
+
+/// @brief Mix the bits of a 64 bit value so that every input bit affects every output bit (finalizer of
+/// SplitMix64), used for hashing endpoints
+constexpr uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace detail
+
+
 // IPv4
 namespace v4 {
 
@@ -116,13 +370,28 @@ union Address {
     Net32 u32[1];
 
 
-    /// @brief Create an address from a string
-    /// @param s String containing the address, e.g. "::1" for localhost
+    /// @brief Maximum length of the string representation of an address
+    static constexpr int MAX_STRING_LENGTH = 15;
+
+    /// @brief Create an address from a string in dotted decimal notation
+    /// @param s String containing the address, e.g. "127.0.0.1" for localhost
     /// @return Address
-    static std::optional<Address> fromString(String s);
+    static constexpr std::optional<Address> fromString(String s) {
+        Address address = {};
+        if (detail::parseV4(s.begin(), s.end(), address.u8) != s.end())
+            return {};
+        return address;
+    }
+
+    /// @brief Convert the address to a string in dotted decimal notation
+    /// @param buffer Buffer of at least MAX_STRING_LENGTH characters
+    /// @return String that points into the buffer
+    constexpr String toString(char *buffer) const {
+        return {buffer, int(detail::formatV4(buffer, this->u8) - buffer)};
+    }
 
     bool operator ==(const Address &b) const {
-        return this->u32[0] != b.u32[0];
+        return this->u32[0] == b.u32[0];
     }
 };
 
@@ -133,21 +402,129 @@ struct Endpoint {
     uint8_t zero[8];
 
 
-    //static Endpoint fromString(String s, uint16_t defaultPort);
+    /// @brief Maximum length of the string representation of an endpoint
+    static constexpr int MAX_STRING_LENGTH = Address::MAX_STRING_LENGTH + 6;
+
+    /// @brief Create an endpoint from a string
+    /// @param s String containing address and optional port, e.g. "127.0.0.1:80"
+    /// @param defaultPort Port if the string contains no port
+    /// @return Endpoint
+    static constexpr std::optional<Endpoint> fromString(String s, uint16_t defaultPort = 0) {
+        Endpoint endpoint = {};
+        uint16_t port = defaultPort;
+        auto it = detail::parseV4(s.begin(), s.end(), endpoint.address.u8);
+        if (it == nullptr || detail::parsePort(it, s.end(), port) != s.end())
+            return {};
+        endpoint.port = port;
+        return endpoint;
+    }
+
+    /// @brief Convert the endpoint to a string, e.g. "127.0.0.1:80"
+    /// @param buffer Buffer of at least MAX_STRING_LENGTH characters
+    /// @return String that points into the buffer
+    constexpr String toString(char *buffer) const {
+        auto it = detail::formatV4(buffer, this->address.u8);
+        *it++ = ':';
+        it = detail::formatDecimal(it, this->port);
+        return {buffer, int(it - buffer)};
+    }
 
+    /// @brief Hash of address and port, the padding is ignored
+    /// @return Hash value where all bits are well distributed
+    uint64_t hash() const {
+        return detail::mix(uint64_t(this->address.u32[0].value) << 16 | this->port.value);
+    }
+
+    /// @brief Compare address and port, the padding is ignored
     bool operator ==(const Endpoint &e) const {
         return e.address == this->address && e.port == this->port;
     }
 };
 
+/// @brief Address prefix in CIDR notation, e.g. 10.0.0.0/8
+///
+struct Prefix {
+    Address address;
+    int length;
+
+
+    /// @brief Maximum length of the string representation of a prefix
+    static constexpr int MAX_STRING_LENGTH = Address::MAX_STRING_LENGTH + 3;
+
+    /// @brief Create a prefix from a string, the bits of the address beyond the prefix length are cleared
+    /// @param s String containing address and optional length, e.g. "10.0.0.0/8" (an address without length is a /32)
+    /// @return Prefix
+    static constexpr std::optional<Prefix> fromString(String s) {
+        Prefix prefix = {};
+        auto it = detail::parseV4(s.begin(), s.end(), prefix.address.u8);
+        if (it == nullptr || detail::parseLength(it, s.end(), 32, prefix.length) != s.end())
+            return {};
+        detail::clearHostBits(prefix.address.u8, 4, prefix.length);
+        return prefix;
+    }
+
+    /// @brief Convert the prefix to a string in CIDR notation, e.g. "10.0.0.0/8"
+    /// @param buffer Buffer of at least MAX_STRING_LENGTH characters
+    /// @return String that points into the buffer
+    constexpr String toString(char *buffer) const {
+        auto it = detail::formatV4(buffer, this->address.u8);
+        *it++ = '/';
+        it = detail::formatDecimal(it, this->length);
+        return {buffer, int(it - buffer)};
+    }
+
+    /// @brief Check if the prefix contains an address.
+    /// @param a address
+    /// @return true if the first length bits of the address match
+    bool contains(const Address &a) const {
+        uint32_t mask = this->length == 0 ? 0 : 0xffffffffU << (32 - this->length);
+        return ((uint32_t(a.u32[0]) ^ uint32_t(this->address.u32[0])) & mask) == 0;
+    }
+
+    bool operator ==(const Prefix &p) const {
+        return p.address == this->address && p.length == this->length;
+    }
+};
+
+/// @brief Stream operators for all streams that accept String
+///
+template <typename S> requires requires (S &s, String str) {s << str;}
+S &operator <<(S &s, const Address &address) {
+    char buffer[Address::MAX_STRING_LENGTH];
+    s << address.toString(buffer);
+    return s;
+}
+
+template <typename S> requires requires (S &s, String str) {s << str;}
+S &operator <<(S &s, const Endpoint &endpoint) {
+    char buffer[Endpoint::MAX_STRING_LENGTH];
+    s << endpoint.toString(buffer);
+    return s;
+}
+
+template <typename S> requires requires (S &s, String str) {s << str;}
+S &operator <<(S &s, const Prefix &prefix) {
+    char buffer[Prefix::MAX_STRING_LENGTH];
+    s << prefix.toString(buffer);
+    return s;
+}
+
 } // namespace v4
 
 
 // IPv6
 namespace v6 {
 
-/// @brief IPv6 protocol ID, equals AF_INET6
+/// @brief IPv6 protocol ID, equals AF_INET6 on native platforms so that endpoints can be passed to the socket API
+#if defined(__linux__)
+constexpr uint16_t PROTOCOL_ID = 10;
+#elif defined(__APPLE__)
+constexpr uint16_t PROTOCOL_ID = 30;
+#elif defined(__FreeBSD__)
+constexpr uint16_t PROTOCOL_ID = 28;
+#else
 constexpr uint16_t PROTOCOL_ID = 23;
+#endif
 
 
 union Address {
@@ -156,10 +533,25 @@ union Address {
     Net32 u32[4];
 
 
+    /// @brief Maximum length of the string representation of an address
+    static constexpr int MAX_STRING_LENGTH = 45;
+
     /// @brief Create an address from a string
     /// @param s String containing the address, e.g. "::1" for localhost
     /// @return Address
-    static std::optional<Address> fromString(String s);
+    static constexpr std::optional<Address> fromString(String s) {
+        Address address = {};
+        if (detail::parseV6(s.begin(), s.end(), address.u8) != s.end())
+            return {};
+        return address;
+    }
+
+    /// @brief Convert the address to a string in the recommended representation of RFC 5952, e.g. "fe80::1"
+    /// @param buffer Buffer of at least MAX_STRING_LENGTH characters
+    /// @return String that points into the buffer
+    constexpr String toString(char *buffer) const {
+        return {buffer, int(detail::formatV6(buffer, this->u8) - buffer)};
+    }
 
     /// @brief Check if it is a link local address.
     /// @return True if link local address
@@ -167,6 +559,12 @@ union Address {
         return this->u32[0] == (0xfe800000U) && this->u32[1] == 0;
     }
 
+    /// @brief Check if it is an IPv4-mapped address (::ffff:a.b.c.d).
+    /// @return True if IPv4-mapped address
+    bool v4Mapped() const {
+        return this->u32[0] == 0 && this->u32[1] == 0 && this->u32[2] == 0x0000ffff;
+    }
+
     bool operator ==(const Address &b) const {
         for (int i = 0; i < 4; ++i) {
             if (this->u32[i] != b.u32[i])
@@ -184,13 +582,151 @@ struct Endpoint {
     uint32_t scopeId;
 
 
-    //static Endpoint fromString(String s, uint16_t defaultPort);
+    /// @brief Maximum length of the string representation of an endpoint
+    static constexpr int MAX_STRING_LENGTH = Address::MAX_STRING_LENGTH + 19;
+
+    /// @brief Create an endpoint from a string
+    /// @param s String containing address, optional numeric scope id and optional port, e.g. "[::1]:80", "::1" or
+    /// "[fe80::1%2]:80"
+    /// @param defaultPort Port if the string contains no port
+    /// @return Endpoint
+    static constexpr std::optional<Endpoint> fromString(String s, uint16_t defaultPort = 0) {
+        Endpoint endpoint = {};
+        uint16_t port = defaultPort;
+        auto it = s.begin();
+        auto end = s.end();
+        bool brackets = it != end && *it == '[';
+        if (brackets)
+            ++it;
+        it = detail::parseV6(it, end, endpoint.address.u8);
+        if (it != nullptr && it != end && *it == '%') {
+            // the scope id must have at least one digit
+            uint32_t scopeId = 0;
+            it = detail::parseDecimal(it + 1, end, 0xffffffff, scopeId);
+            if (it == nullptr)
+                return {};
+            endpoint.scopeId = scopeId;
+        }
+        if (brackets) {
+            if (it == nullptr || it == end || *it != ']')
+                return {};
+            it = detail::parsePort(it + 1, end, port);
+        }
+        if (it != end)
+            return {};
+        endpoint.port = port;
+        return endpoint;
+    }
 
+    /// @brief Convert the endpoint to a string, e.g. "[::1]:80"
+    /// @param buffer Buffer of at least MAX_STRING_LENGTH characters
+    /// @return String that points into the buffer
+    constexpr String toString(char *buffer) const {
+        auto it = buffer;
+        *it++ = '[';
+        it = detail::formatV6(it, this->address.u8);
+        if (this->scopeId != 0) {
+            *it++ = '%';
+            it = detail::formatDecimal(it, this->scopeId);
+        }
+        *it++ = ']';
+        *it++ = ':';
+        it = detail::formatDecimal(it, this->port);
+        return {buffer, int(it - buffer)};
+    }
+
+    /// @brief Hash of address, port and scope id, the flow info is ignored
+    /// @return Hash value where all bits are well distributed
+    uint64_t hash() const {
+        auto &a = this->address.u32;
+        uint64_t h = detail::mix((uint64_t(a[0].value) << 32 | a[1].value)
+            ^ (uint64_t(this->scopeId) << 16 | this->port.value));
+        return detail::mix(h ^ (uint64_t(a[2].value) << 32 | a[3].value));
+    }
+
+    /// @brief Compare address, port and scope id (link local addresses on different interfaces are different
+    /// peers), the flow info is ignored
     bool operator ==(const Endpoint &e) const {
-        return e.address == this->address && e.port == this->port;
+        return e.address == this->address && e.port == this->port && e.scopeId == this->scopeId;
+    }
+};
+
+/// @brief Address prefix in CIDR notation, e.g. 2001:db8::/32
+///
+struct Prefix {
+    Address address;
+    int length;
+
+
+    /// @brief Maximum length of the string representation of a prefix
+    static constexpr int MAX_STRING_LENGTH = Address::MAX_STRING_LENGTH + 4;
+
+    /// @brief Create a prefix from a string, the bits of the address beyond the prefix length are cleared
+    /// @param s String containing address and optional length, e.g. "2001:db8::/32" (an address without length
+    /// is a /128)
+    /// @return Prefix
+    static constexpr std::optional<Prefix> fromString(String s) {
+        Prefix prefix = {};
+        auto it = detail::parseV6(s.begin(), s.end(), prefix.address.u8);
+        if (it == nullptr || detail::parseLength(it, s.end(), 128, prefix.length) != s.end())
+            return {};
+        detail::clearHostBits(prefix.address.u8, 16, prefix.length);
+        return prefix;
+    }
+
+    /// @brief Convert the prefix to a string in CIDR notation, e.g. "2001:db8::/32"
+    /// @param buffer Buffer of at least MAX_STRING_LENGTH characters
+    /// @return String that points into the buffer
+    constexpr String toString(char *buffer) const {
+        auto it = detail::formatV6(buffer, this->address.u8);
+        *it++ = '/';
+        it = detail::formatDecimal(it, this->length);
+        return {buffer, int(it - buffer)};
+    }
+
+    /// @brief Check if the prefix contains an address.
+    /// @param a address
+    /// @return true if the first length bits of the address match
+    bool contains(const Address &a) const {
+        for (int i = 0; i < 4; ++i) {
+            int bits = this->length - i * 32;
+            if (bits <= 0)
+                break;
+            uint32_t mask = bits >= 32 ? 0xffffffffU : 0xffffffffU << (32 - bits);
+            if (((uint32_t(a.u32[i]) ^ uint32_t(this->address.u32[i])) & mask) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool operator ==(const Prefix &p) const {
+        return p.address == this->address && p.length == this->length;
     }
 };
 
+/// @brief Stream operators for all streams that accept String
+///
+template <typename S> requires requires (S &s, String str) {s << str;}
+S &operator <<(S &s, const Address &address) {
+    char buffer[Address::MAX_STRING_LENGTH];
+    s << address.toString(buffer);
+    return s;
+}
+
+template <typename S> requires requires (S &s, String str) {s << str;}
+S &operator <<(S &s, const Endpoint &endpoint) {
+    char buffer[Endpoint::MAX_STRING_LENGTH];
+    s << endpoint.toString(buffer);
+    return s;
+}
+
+template <typename S> requires requires (S &s, String str) {s << str;}
+S &operator <<(S &s, const Prefix &prefix) {
+    char buffer[Prefix::MAX_STRING_LENGTH];
+    s << prefix.toString(buffer);
+    return s;
+}
+
 } // namespace v6
 
 
@@ -205,7 +741,107 @@ union Endpoint {
     } generic;
     v4::Endpoint v4;
     v6::Endpoint v6;
+
+
+    /// @brief Maximum length of the string representation of an endpoint
+    static constexpr int MAX_STRING_LENGTH = v6::Endpoint::MAX_STRING_LENGTH;
+
+    /// @brief Create an IPv4 or IPv6 endpoint from a string
+    /// @param s String containing address and optional port, e.g. "127.0.0.1:80" or "[::1]:80"
+    /// @param defaultPort Port if the string contains no port
+    /// @return Endpoint
+    static constexpr std::optional<Endpoint> fromString(String s, uint16_t defaultPort = 0) {
+        if (auto endpoint = v4::Endpoint::fromString(s, defaultPort))
+            return Endpoint{.v4 = *endpoint};
+        if (auto endpoint = v6::Endpoint::fromString(s, defaultPort))
+            return Endpoint{.v6 = *endpoint};
+        return {};
+    }
+
+    /// @brief Convert the endpoint to a string
+    /// @param buffer Buffer of at least MAX_STRING_LENGTH characters
+    /// @return String that points into the buffer (empty if the protocol is neither IPv4 nor IPv6)
+    constexpr String toString(char *buffer) const {
+        if (this->protocolId == v4::PROTOCOL_ID)
+            return this->v4.toString(buffer);
+        if (this->protocolId == v6::PROTOCOL_ID)
+            return this->v6.toString(buffer);
+        return {buffer, 0};
+    }
+
+    /// @brief Convert an IPv4 endpoint to an IPv6 endpoint with the IPv4-mapped address (::ffff:a.b.c.d) as used by
+    /// dual-stack sockets. Other endpoints are returned unchanged
+    /// @return Endpoint
+    Endpoint mapV4() const {
+        if (this->protocolId != v4::PROTOCOL_ID)
+            return *this;
+        Endpoint endpoint = {.v6 = {.port = this->v4.port}};
+        endpoint.v6.address.u32[2] = 0x0000ffff;
+        endpoint.v6.address.u32[3] = this->v4.address.u32[0];
+        return endpoint;
+    }
+
+    /// @brief Convert an IPv6 endpoint with IPv4-mapped address to an IPv4 endpoint, the inverse of mapV4(). Other
+    /// endpoints are returned unchanged
+    /// @return Endpoint
+    Endpoint unmapV4() const {
+        if (this->protocolId != v6::PROTOCOL_ID || !this->v6.address.v4Mapped())
+            return *this;
+        Endpoint endpoint = {.v4 = {.port = this->v6.port}};
+        endpoint.v4.address.u32[0] = this->v6.address.u32[3];
+        return endpoint;
+    }
+
+    /// @brief Hash of the endpoint that depends only on the members that are relevant for the protocol
+    /// @return Hash value where all bits are well distributed
+    uint64_t hash() const {
+        switch (this->protocolId) {
+        case v4::PROTOCOL_ID:
+            return this->v4.hash();
+        case v6::PROTOCOL_ID:
+            return this->v6.hash();
+        default:
+            return detail::mix(uint64_t(this->generic.protocolId) << 16 | this->generic.port.value);
+        }
+    }
+
+    /// @brief Compare the members that are relevant for the protocol, padding and flow info are ignored
+    bool operator ==(const Endpoint &e) const {
+        if (e.protocolId != this->protocolId)
+            return false;
+        switch (this->protocolId) {
+        case v4::PROTOCOL_ID:
+            return e.v4 == this->v4;
+        case v6::PROTOCOL_ID:
+            return e.v6 == this->v6;
+        default:
+            return e.generic.port == this->generic.port;
+        }
+    }
 };
 
+
+/// @brief Stream operator for all streams that accept String
+///
+template <typename S> requires requires (S &s, String str) {s << str;}
+S &operator <<(S &s, const Endpoint &endpoint) {
+    char buffer[Endpoint::MAX_STRING_LENGTH];
+    s << endpoint.toString(buffer);
+    return s;
+}
+
+
+/// @brief User-defined literals, use with "using namespace coco::ip::literals;"
+///
+namespace literals {
+
+/// @brief Endpoint that gets parsed at compile time, e.g. auto ep = "127.0.0.1:80"_ep;
+/// A malformed endpoint is a compile error.
+consteval Endpoint operator ""_ep(const char *s, size_t size) {
+    return Endpoint::fromString(String(s, int(size))).value();
+}
+
+} // namespace literals
+
 } // namespace ip
 } // namespace coco
@@ -0,0 +1,103 @@
+#include "BufferChannel_Linux.hpp"
+#include <algorithm>
+#include <bit>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+namespace coco {
+
+// the index of a cell is the position masked by capacity - 1 and a ring of one cell can't tell full from free
+static size_t ringSize(int capacity) {
+    return std::bit_ceil(size_t(std::max(capacity, 2)));
+}
+
+BufferChannel_Linux::BufferChannel_Linux(Loop_Linux &loop, int capacity)
+    : loop_(loop)
+    , cells_(std::make_unique<Cell[]>(ringSize(capacity)))
+    , mask_(ringSize(capacity) - 1)
+{
+    // each cell is free for the push at its index
+    for (size_t i = 0; i <= mask_; ++i)
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+
+    // add eventfd to epoll of event loop (edge-triggered, each signal generates a new edge)
+    int eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd == -1)
+        return;
+    Loop_Linux::CompletionHandler *handler = this;
+    epoll_event event = {.events = EPOLLIN | EPOLLET, .data = {.ptr = handler}};
+    if (epoll_ctl(loop_.epollQueue, EPOLL_CTL_ADD, eventFd, &event) == -1) {
+        ::close(eventFd);
+        return;
+    }
+    eventFd_ = eventFd;
+}
+
+BufferChannel_Linux::~BufferChannel_Linux() {
+    if (eventFd_ != -1)
+        ::close(eventFd_);
+}
+
+bool BufferChannel_Linux::push(Buffer &buffer) {
+    // nobody would wake up the consumer
+    if (eventFd_ == -1)
+        return false;
+
+    // claim a cell
+    size_t position = tail_.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell = &cells_[position & mask_];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t difference = intptr_t(sequence) - intptr_t(position);
+        if (difference == 0) {
+            // the cell is free: try to claim it
+            if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (difference < 0) {
+            // the cell still holds the buffer of the previous round: full
+            return false;
+        } else {
+            // another producer has claimed the cell
+            position = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // publish the buffer to the consumer
+    cell->buffer = &buffer;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+void BufferChannel_Linux::flush() {
+    // only the first flush after the consumer has checked the channel needs to signal
+    if (!signaled_.exchange(true)) {
+        uint64_t value = 1;
+        (void)!write(eventFd_, &value, sizeof(value));
+    }
+}
+
+Buffer *BufferChannel_Linux::pop() {
+    auto &cell = cells_[head_ & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != head_ + 1)
+        return nullptr;
+    Buffer *buffer = cell.buffer;
+
+    // free the cell for the push of the next round
+    cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+    return buffer;
+}
+
+void BufferChannel_Linux::handle(epoll_event &event) {
+    // the eventfd is not read, with edge-triggered epoll each signal generates a new event.
+    // Clear the flag before checking the channel so that a buffer that gets pushed after the check signals again
+    signaled_.store(false);
+
+    // resume all coroutines waiting for buffers
+    if (!empty())
+        tasks_.doAll();
+}
+
+} // namespace coco
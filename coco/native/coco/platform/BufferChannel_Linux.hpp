@@ -0,0 +1,99 @@
+#pragma once
+
+#include <coco/Buffer.hpp>
+#include <coco/Coroutine.hpp>
+#include <coco/platform/Loop_native.hpp>
+#include <atomic>
+#include <memory>
+
+
+namespace coco {
+
+/// @brief Lock-free channel that passes buffers from other threads to the coroutines of an event loop.
+/// The buffers are queued in a bounded ring that supports multiple producers and one consumer. Producers push any
+/// number of buffers and then call flush() which signals the eventfd of the consumer loop only if it was not signaled
+/// since the consumer has emptied the channel, therefore a batch of buffers costs at most one cross-thread wakeup.
+///
+/// Ownership of a buffer passes with the channel, i.e. the consumer may read the data but must not start the buffer
+/// because it belongs to the loop of its device. To re-post a buffer, pass it back to the loop of its device through a
+/// second channel. Usage:
+///   io loop:     co_await buffer.read(); toWorker.push(buffer); toWorker.flush();
+///   worker loop: co_await toWorker.untilNotEmpty(); while (auto buffer = toWorker.pop()) {...; toIo.push(*buffer);} toIo.flush();
+///   io loop:     co_await toIo.untilNotEmpty(); while (auto buffer = toIo.pop()) buffer->start(Buffer::Op::READ);
+class BufferChannel_Linux : public Loop_Linux::CompletionHandler {
+public:
+    /// @brief Constructor. Check valid() to see if the eventfd could be created and added to the loop.
+    /// @param loop event loop of the consumer
+    /// @param capacity maximum number of buffers in the channel, gets rounded up to a power of two (at least 2)
+    BufferChannel_Linux(Loop_Linux &loop, int capacity);
+
+    ~BufferChannel_Linux() override;
+
+    /// @brief Check if the channel can be used.
+    /// @return true if the consumer loop can be woken up
+    bool valid() const {return eventFd_ != -1;}
+
+    /// @brief Get the capacity of the channel.
+    /// @return maximum number of buffers in the channel
+    int capacity() const {return int(mask_ + 1);}
+
+    /// @brief Push a buffer into the channel, can be called from any thread.
+    /// The consumer gets woken up by the next call to flush().
+    /// @param buffer buffer to pass to the consumer
+    /// @return true if successful, false if the channel is full or not valid
+    bool push(Buffer &buffer);
+
+    /// @brief Wake up the consumer if it was not woken up since it has emptied the channel, can be called from any thread.
+    ///
+    void flush();
+
+    /// @brief Pop a buffer from the channel, has to be called from the thread of the consumer loop.
+    /// @return buffer or nullptr if the channel is empty
+    Buffer *pop();
+
+    /// @brief Check if the channel is empty, has to be called from the thread of the consumer loop.
+    /// @return true if empty
+    bool empty() const {
+        return cells_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+    /// @brief Wait until the channel is not empty, has to be called from the thread of the consumer loop.
+    /// @return use co_await on return value to wait until a buffer can be popped
+    [[nodiscard]] Awaitable<CoroutineTask<>> untilNotEmpty() {
+        if (!empty())
+            return {};
+        return {tasks_};
+    }
+
+protected:
+    void handle(epoll_event &event) override;
+
+    struct Cell {
+        // sequence number that indicates whether the cell is free or holds a buffer (Vyukov bounded queue)
+        std::atomic<size_t> sequence;
+        Buffer *buffer;
+    };
+
+    Loop_Linux &loop_;
+
+    // eventfd that wakes up the consumer loop
+    int eventFd_ = -1;
+
+    // ring of cells
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+
+    // position of the next push, shared by the producers
+    alignas(64) std::atomic<size_t> tail_ = 0;
+
+    // true if the consumer was signaled and has not checked the channel yet
+    alignas(64) std::atomic<bool> signaled_ = false;
+
+    // position of the next pop, only used by the consumer
+    alignas(64) size_t head_ = 0;
+
+    // coroutines waiting until the channel is not empty
+    CoroutineTaskList<> tasks_;
+};
+
+} // namespace coco
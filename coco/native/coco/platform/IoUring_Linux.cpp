@@ -0,0 +1,417 @@
+#include "IoUring_Linux.hpp"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace coco {
+
+namespace {
+
+int io_uring_setup(unsigned entries, io_uring_params &params) {
+    return int(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int io_uring_enter(int ring, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return int(syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int io_uring_register(int ring, unsigned opcode, void *arg, unsigned argCount) {
+    return int(syscall(__NR_io_uring_register, ring, opcode, arg, argCount));
+}
+
+// busy polling of the network devices (IORING_REGISTER_NAPI and struct io_uring_napi, Linux 6.9)
+constexpr unsigned REGISTER_NAPI = 27;
+constexpr unsigned UNREGISTER_NAPI = 28;
+struct Napi {
+    uint32_t busyPollTime;
+    uint8_t preferBusyPoll;
+    uint8_t pad[3];
+    uint64_t reserved;
+};
+
+// default rings of event loops, owned by the sockets that use them
+struct DefaultRing {
+    Loop_Linux *loop;
+    std::weak_ptr<IoUring_Linux> ring;
+};
+std::mutex defaultRingsMutex;
+std::vector<DefaultRing> defaultRings;
+
+} // namespace
+
+
+IoUring_Linux::Handler::~Handler() {
+}
+
+IoUring_Linux::IoUring_Linux(Loop_Linux &loop, int entries, Flags flags, int idleTime)
+    : loop_(loop), flags_(flags)
+{
+    // create ring, the completion queue has twice the size of the submission queue
+    io_uring_params params = {};
+    if ((flags & Flags::SQPOLL) != 0) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = idleTime;
+    }
+    int ring = io_uring_setup(entries, params);
+    if (ring == -1)
+        return;
+    ring_ = ring;
+
+    // map submission and completion queue rings
+    sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+        sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+    void *sqMemory = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    if (sqMemory == MAP_FAILED) {
+        destroy();
+        return;
+    }
+    sqMemory_ = sqMemory;
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+        cqMemory_ = sqMemory_;
+    } else {
+        void *cqMemory = mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+        if (cqMemory == MAP_FAILED) {
+            destroy();
+            return;
+        }
+        cqMemory_ = cqMemory;
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        destroy();
+        return;
+    }
+    sqes_ = (io_uring_sqe *)sqes;
+
+    auto sq = (uint8_t *)sqMemory_;
+    sqHead_ = (unsigned *)(sq + params.sq_off.head);
+    sqTail_ = (unsigned *)(sq + params.sq_off.tail);
+    sqFlags_ = (unsigned *)(sq + params.sq_off.flags);
+    sqMask_ = *(unsigned *)(sq + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    tail_ = *sqTail_;
+
+    // the index array maps each slot to the entry with the same index
+    auto array = (unsigned *)(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries_; ++i)
+        array[i] = i;
+
+    auto cq = (uint8_t *)cqMemory_;
+    cqHead_ = (unsigned *)(cq + params.cq_off.head);
+    cqTail_ = (unsigned *)(cq + params.cq_off.tail);
+    cqMask_ = *(unsigned *)(cq + params.cq_off.ring_mask);
+    cqes_ = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    // the eventfd signals completions to the loop and is also used to wake up the loop for submission
+    eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ == -1 || io_uring_register(ring, IORING_REGISTER_EVENTFD, &eventFd_, 1) != 0) {
+        destroy();
+        return;
+    }
+
+    // add eventfd to epoll of event loop (edge-triggered, each signal generates a new edge)
+    Loop_Linux::CompletionHandler *handler = this;
+    epoll_event event = {.events = EPOLLIN | EPOLLET, .data = {.ptr = handler}};
+    if (epoll_ctl(loop_.epollQueue, EPOLL_CTL_ADD, eventFd_, &event) == -1)
+        destroy();
+}
+
+IoUring_Linux::~IoUring_Linux() {
+    destroy();
+}
+
+void IoUring_Linux::destroy() {
+    if (eventFd_ != -1) {
+        ::close(eventFd_);
+        eventFd_ = -1;
+    }
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqesSize_);
+        sqes_ = nullptr;
+    }
+    if (cqMemory_ != nullptr && cqMemory_ != sqMemory_)
+        munmap(cqMemory_, cqSize_);
+    cqMemory_ = nullptr;
+    if (sqMemory_ != nullptr) {
+        munmap(sqMemory_, sqSize_);
+        sqMemory_ = nullptr;
+    }
+    if (ring_ != -1) {
+        ::close(ring_);
+        ring_ = -1;
+    }
+}
+
+std::shared_ptr<IoUring_Linux> IoUring_Linux::get(Loop_Linux &loop) {
+    std::lock_guard<std::mutex> lock(defaultRingsMutex);
+
+    // forget the rings that were destroyed together with their last socket, a new loop may have the same address
+    std::erase_if(defaultRings, [](const DefaultRing &defaultRing) {return defaultRing.ring.expired();});
+    for (auto &defaultRing : defaultRings) {
+        if (defaultRing.loop == &loop) {
+            if (auto ring = defaultRing.ring.lock())
+                return ring;
+        }
+    }
+
+    auto ring = std::make_shared<IoUring_Linux>(loop);
+    std::erase_if(defaultRings, [&loop](const DefaultRing &defaultRing) {return defaultRing.loop == &loop;});
+    defaultRings.push_back({&loop, ring});
+    return ring;
+}
+
+bool IoUring_Linux::setBusyPoll(int time) {
+    Napi napi = {.busyPollTime = uint32_t(time), .preferBusyPoll = 1};
+    return io_uring_register(ring_, time > 0 ? REGISTER_NAPI : UNREGISTER_NAPI, &napi, 1) == 0;
+}
+
+io_uring_sqe &IoUring_Linux::get(Handler *handler) {
+    // if the submission queue is full, submit and wait until the kernel has consumed an entry, the slot of an entry must
+    // not be reused before
+    while (tail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_)
+        wait();
+
+    auto &sqe = sqes_[tail_ & sqMask_];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.user_data = uint64_t(handler);
+    if (handler != nullptr)
+        ++handler->operations_;
+    return sqe;
+}
+
+void IoUring_Linux::commit() {
+    // publish the entry to the kernel
+    ++tail_;
+    __atomic_store_n(sqTail_, tail_, __ATOMIC_RELEASE);
+
+    if ((flags_ & Flags::SQPOLL) != 0) {
+        // the poll thread picks up the entry, wake it up if it went to sleep
+        submit();
+    } else if (!handling_ && !woken_) {
+        // wake up the loop to submit all entries that get committed until the next loop iteration
+        uint64_t value = 1;
+        (void)!write(eventFd_, &value, sizeof(value));
+        woken_ = true;
+    }
+}
+
+void IoUring_Linux::cancel(Handler *handler) {
+    auto &sqe = get(nullptr);
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.fd = -1;
+    sqe.addr = uint64_t(handler);
+    commit();
+}
+
+void IoUring_Linux::drain(Handler &handler) {
+    if (handler.operations_ == 0)
+        return;
+
+    // wait for the completions of the cancelled operations, the notification of a zero-copy send arrives when the
+    // kernel has released the memory
+    cancel(&handler);
+    while (handler.operations_ > 0) {
+        submit();
+        io_uring_enter(ring_, 0, 1, IORING_ENTER_GETEVENTS);
+        reap();
+    }
+}
+
+void IoUring_Linux::submit() {
+    // number of entries the kernel has not consumed yet
+    unsigned count = tail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+
+    unsigned flags = 0;
+    if ((flags_ & Flags::SQPOLL) != 0) {
+        // the entries only need to be submitted by the kernel if the poll thread sleeps
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if ((__atomic_load_n(sqFlags_, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) == 0)
+            return;
+        flags |= IORING_ENTER_SQ_WAKEUP;
+    } else if (count == 0) {
+        return;
+    }
+
+    // flush completions that did not fit into the completion queue
+    if ((__atomic_load_n(sqFlags_, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) != 0)
+        flags |= IORING_ENTER_GETEVENTS;
+
+    io_uring_enter(ring_, count, 0, flags);
+}
+
+void IoUring_Linux::flush() {
+    while (tail_ != __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE))
+        wait();
+}
+
+void IoUring_Linux::wait() {
+    unsigned flags;
+    if ((flags_ & Flags::SQPOLL) != 0) {
+        // wake up the poll thread if it sleeps and wait until it has consumed entries
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        flags = IORING_ENTER_SQ_WAIT;
+        if ((__atomic_load_n(sqFlags_, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) != 0)
+            flags |= IORING_ENTER_SQ_WAKEUP;
+    } else {
+        // the kernel may consume only a part of the entries or none (e.g. -EBUSY while completions that did not fit
+        // into the completion queue wait to be flushed)
+        flags = IORING_ENTER_GETEVENTS;
+    }
+    unsigned count = tail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    io_uring_enter(ring_, count, 0, flags);
+}
+
+void IoUring_Linux::handle(epoll_event &event) {
+    // the eventfd is not read, with edge-triggered epoll each signal generates a new event
+    handling_ = true;
+    woken_ = false;
+
+    reap();
+    handling_ = false;
+
+    // submit all entries that were committed by the handlers and resumed coroutines
+    submit();
+}
+
+void IoUring_Linux::reap() {
+    while (true) {
+        unsigned head = *cqHead_;
+        if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+            // move completions that did not fit into the completion queue into the queue which now has room
+            if ((__atomic_load_n(sqFlags_, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) == 0)
+                break;
+            io_uring_enter(ring_, 0, 0, IORING_ENTER_GETEVENTS);
+            if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+                break;
+            continue;
+        }
+
+        // copy the entry and publish the head before calling the handler, it may destroy an object that drains its
+        // completions and therefore reaps recursively
+        io_uring_cqe cqe = cqes_[head & cqMask_];
+        __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+
+        auto handler = (Handler *)cqe.user_data;
+        if (handler != nullptr) {
+            // the last completion of an operation comes without IORING_CQE_F_MORE (multishot operations, result of a
+            // zero-copy send that is followed by its notification)
+            if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+                --handler->operations_;
+            handler->handle(cqe);
+        }
+    }
+}
+
+
+
+// IoUring_Linux::BufferRing
+
+IoUring_Linux::BufferRing::Receiver::~Receiver() {
+}
+
+IoUring_Linux::BufferRing::BufferRing(IoUring_Linux &ring, BufferPool &pool, int entries, int group)
+    : ring_(ring), pool_(pool), group_(group)
+{
+    if (!ring.valid())
+        return;
+
+    // allocate the ring shared with the kernel (page aligned)
+    bufsSize_ = entries * sizeof(io_uring_buf);
+    void *bufs = mmap(nullptr, bufsSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufs == MAP_FAILED)
+        return;
+
+    // register the ring as buffer group
+    io_uring_buf_reg reg = {.ring_addr = uint64_t(bufs), .ring_entries = unsigned(entries), .bgid = uint16_t(group)};
+    if (io_uring_register(ring.ring_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        munmap(bufs, bufsSize_);
+        return;
+    }
+    bufs_ = (io_uring_buf *)bufs;
+    mask_ = entries - 1;
+
+    // take one block per entry from the pool (fewer if the pool gets exhausted)
+    blocks_ = std::make_unique<Block[]>(entries);
+    for (; blockCount_ < entries; ++blockCount_) {
+        uint8_t *data = pool.allocate();
+        if (data == nullptr)
+            break;
+        blocks_[blockCount_] = {data, 0, -1};
+        add(blockCount_);
+    }
+}
+
+IoUring_Linux::BufferRing::~BufferRing() {
+    if (bufs_ == nullptr)
+        return;
+    io_uring_buf_reg reg = {.bgid = uint16_t(group_)};
+    io_uring_register(ring_.ring_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(bufs_, bufsSize_);
+    for (int i = 0; i < blockCount_; ++i)
+        pool_.free(blocks_[i].data);
+}
+
+void IoUring_Linux::BufferRing::add(int id) {
+    auto &buf = bufs_[tail_ & mask_];
+    buf.addr = uint64_t(blocks_[id].data);
+    buf.len = pool_.blockSize();
+    buf.bid = id;
+
+    // publish the entry to the kernel
+    ++tail_;
+    __atomic_store_n(&bufs_[0].resv, tail_, __ATOMIC_RELEASE);
+    ++available_;
+
+    // resume receivers that wait for memory
+    while (!waiting_.empty()) {
+        auto &receiver = waiting_.front();
+        receiver.remove();
+        receiver.resume();
+    }
+}
+
+void IoUring_Linux::BufferRing::push(Queue &queue, int id, int size) {
+    --available_;
+    auto &block = blocks_[id];
+    block.size = size;
+    block.next = -1;
+    if (queue.last == -1)
+        queue.first = id;
+    else
+        blocks_[queue.last].next = id;
+    queue.last = id;
+}
+
+int IoUring_Linux::BufferRing::pop(Queue &queue) {
+    int id = queue.first;
+    queue.first = blocks_[id].next;
+    if (queue.first == -1)
+        queue.last = -1;
+    return id;
+}
+
+void IoUring_Linux::BufferRing::clear(Queue &queue) {
+    while (!queue.empty())
+        add(pop(queue));
+}
+
+void IoUring_Linux::BufferRing::wait(Receiver &receiver) {
+    // the ring may have been refilled before the failed receive was reported
+    receiver.remove();
+    if (available_ > 0)
+        receiver.resume();
+    else
+        waiting_.add(receiver);
+}
+
+} // namespace coco
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <coco/BufferPool.hpp>
+#include <coco/IntrusiveList.hpp>
+#include <coco/enum.hpp>
+#include <coco/platform/Loop_native.hpp>
+#include <linux/io_uring.h>
+#include <memory>
+
+
+namespace coco {
+
+/// @brief io_uring submission and completion queue that is attached to the event loop.
+/// Submission queue entries that are added while the loop handles completions get submitted with one io_uring_enter,
+/// completion queue entries are reaped in batches when the eventfd of the ring signals the loop.
+class IoUring_Linux : public Loop_Linux::CompletionHandler {
+public:
+    enum class Flags {
+        NONE = 0,
+
+        /// @brief A kernel thread polls the submission queue so that submitting needs no system call
+        SQPOLL = 1,
+    };
+
+    /// @brief Handler for completion queue entries.
+    /// The user_data of a submission queue entry points to its handler.
+    class Handler {
+        friend class IoUring_Linux;
+    public:
+        virtual ~Handler();
+        virtual void handle(const io_uring_cqe &cqe) = 0;
+
+    protected:
+        // number of submitted operations whose last completion has not arrived
+        int operations_ = 0;
+    };
+
+    /// @brief Handler that forwards completions to a member function, for objects that need more than one handler.
+    ///
+    template <typename T, void (T::*H)(const io_uring_cqe &)>
+    class MemberHandler : public Handler {
+    public:
+        MemberHandler(T &object) : object_(object) {}
+        void handle(const io_uring_cqe &cqe) override {(object_.*H)(cqe);}
+    protected:
+        T &object_;
+    };
+
+    /// @brief Ring of memory blocks that the kernel picks from when data arrives (provided buffer ring).
+    /// Sockets that receive with a multishot receive share the ring and hold memory only while received data waits to
+    /// be consumed. Received blocks are queued per socket and get returned to the ring with add().
+    class BufferRing {
+    public:
+        /// @brief Socket that receives into the ring.
+        /// Gets resumed when memory was returned to the ring after its multishot receive failed with -ENOBUFS.
+        class Receiver : public IntrusiveListNode {
+        public:
+            virtual ~Receiver();
+            virtual void resume() = 0;
+        };
+
+        /// @brief Queue of received blocks of a socket, linked through the entries of the ring
+        ///
+        struct Queue {
+            int first = -1;
+            int last = -1;
+
+            bool empty() const {return first == -1;}
+        };
+
+        /// @brief Constructor.
+        /// @param ring io_uring
+        /// @param pool pool that provides the memory, one block per entry
+        /// @param entries number of entries (power of two, at most 32768)
+        /// @param group buffer group id, unique per io_uring
+        BufferRing(IoUring_Linux &ring, BufferPool &pool, int entries, int group = 0);
+
+        ~BufferRing();
+
+        /// @brief Check if the ring was registered successfully (requires Linux 5.19).
+        /// @return true if the ring can be used
+        bool valid() const {return bufs_ != nullptr;}
+
+        IoUring_Linux &ring() {return ring_;}
+        int group() const {return group_;}
+        int blockSize() const {return pool_.blockSize();}
+
+        /// @brief Get the memory of a block.
+        /// @param id block id from the completion queue entry
+        /// @return memory of the block
+        uint8_t *data(int id) {return blocks_[id].data;}
+
+        /// @brief Get the number of bytes the kernel has written into a queued block.
+        /// @param id block id
+        /// @return number of bytes
+        int size(int id) {return blocks_[id].size;}
+
+        /// @brief Return a block to the ring.
+        /// @param id block id
+        void add(int id);
+
+        /// @brief Append a block that was consumed by the kernel to the queue of a socket.
+        /// @param queue queue of the socket
+        /// @param id block id from the completion queue entry
+        /// @param size number of bytes the kernel has written into the block
+        void push(Queue &queue, int id, int size);
+
+        /// @brief Take the first block from the queue of a socket.
+        /// @param queue queue of the socket, must not be empty
+        /// @return block id
+        int pop(Queue &queue);
+
+        /// @brief Return all blocks of the queue of a socket to the ring.
+        /// @param queue queue of the socket
+        void clear(Queue &queue);
+
+        /// @brief Resume a receiver when memory was returned to the ring (immediately if the ring is not empty).
+        /// @param receiver receiver
+        void wait(Receiver &receiver);
+
+    protected:
+        struct Block {
+            uint8_t *data;
+            int size;
+            int next;
+        };
+
+        IoUring_Linux &ring_;
+        BufferPool &pool_;
+        int group_;
+
+        // ring that is shared with the kernel, the tail overlays the resv field of the first entry
+        io_uring_buf *bufs_ = nullptr;
+        size_t bufsSize_ = 0;
+        unsigned mask_;
+        uint16_t tail_ = 0;
+
+        // blocks and number of blocks that are in the ring
+        std::unique_ptr<Block[]> blocks_;
+        int blockCount_ = 0;
+        int available_ = 0;
+
+        // receivers waiting for memory
+        IntrusiveList<Receiver> waiting_;
+    };
+
+    /// @brief Constructor.
+    /// @param loop event loop
+    /// @param entries number of submission queue entries (power of two)
+    /// @param flags flags, e.g. Flags::SQPOLL for latency-critical sockets
+    /// @param idleTime idle time in milliseconds after which the submission queue poll thread goes to sleep
+    IoUring_Linux(Loop_Linux &loop, int entries = 256, Flags flags = Flags::NONE, int idleTime = 1000);
+
+    ~IoUring_Linux() override;
+
+    /// @brief Get the default ring of an event loop which gets created on first use. The sockets that use it share the
+    /// ownership and it gets destroyed together with the last of them, therefore they must not outlive the loop.
+    /// @param loop event loop
+    /// @return ring
+    static std::shared_ptr<IoUring_Linux> get(Loop_Linux &loop);
+
+    /// @brief Check if the ring was created successfully.
+    /// @return true if the ring can be used
+    bool valid() const {return ring_ != -1;}
+
+    /// @brief Let the kernel busy poll the network devices of the sockets of the ring (Linux 6.9). Takes effect with
+    /// Flags::SQPOLL where the poll thread also polls the network devices, so that received data is completed without
+    /// waiting for an interrupt. Only has an effect for network devices that support NAPI, not e.g. on loopback.
+    /// @param time time in microseconds to poll, 0 to disable
+    /// @return true if successful
+    bool setBusyPoll(int time);
+
+    /// @brief Get a zero-initialized submission queue entry. Fill it and call commit().
+    /// @param handler handler for the completion or nullptr to ignore the completion
+    /// @return submission queue entry
+    io_uring_sqe &get(Handler *handler);
+
+    /// @brief Commit the entry obtained by get(). It gets submitted at latest in the next loop iteration.
+    ///
+    void commit();
+
+    /// @brief Cancel the operations of a handler, they complete with -ECANCELED.
+    /// @param handler handler
+    void cancel(Handler *handler);
+
+    /// @brief Cancel the operations of a handler and wait until their last completions have arrived, e.g. before the
+    /// handler gets destroyed. All completions that arrive in the meantime get handled, also those of the handler.
+    /// @param handler handler
+    void drain(Handler &handler);
+
+    /// @brief Submit all committed entries now.
+    ///
+    void submit();
+
+    /// @brief Submit all committed entries and wait until the kernel has consumed them, e.g. before closing a file
+    /// descriptor that they refer to and which may get reused by a new file.
+    void flush();
+
+protected:
+    void handle(epoll_event &event) override;
+
+    // release the ring, also after a failed setup
+    void destroy();
+
+    // handle all completions in the completion queue
+    void reap();
+
+    // submit the committed entries and wait until the kernel has consumed some of them
+    void wait();
+
+    Loop_Linux &loop_;
+    Flags flags_;
+
+    // ring and eventfd that signals completions to the loop
+    int ring_ = -1;
+    int eventFd_ = -1;
+
+    // submission queue
+    void *sqMemory_ = nullptr;
+    size_t sqSize_ = 0;
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned *sqFlags_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+
+    // local tail of submission queue
+    unsigned tail_ = 0;
+
+    // completion queue
+    void *cqMemory_ = nullptr;
+    size_t cqSize_ = 0;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe *cqes_;
+
+    // true while completions are handled, submission is deferred until all completions are handled
+    bool handling_ = false;
+
+    // true when the loop was woken up to submit entries that were committed outside of handle()
+    bool woken_ = false;
+};
+COCO_ENUM(IoUring_Linux::Flags)
+
+} // namespace coco
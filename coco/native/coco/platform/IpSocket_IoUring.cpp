@@ -0,0 +1,748 @@
+#include "IpSocket_IoUring.hpp"
+#include "SocketOptions_Linux.hpp"
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+
+
+namespace coco {
+
+// create a vector for vectored I/O
+static iovec toVector(uint8_t *data, int size) {
+    return {data, size_t(size)};
+}
+
+IpSocket_IoUring::IpSocket_IoUring(IoUring_Linux &ring, int type, int protocol)
+    : IpSocket(State::DISABLED)
+    , ring_(ring)
+    , type_(type), protocol_(protocol)
+{
+}
+
+IpSocket_IoUring::IpSocket_IoUring(IoUring_Linux::BufferRing &bufferRing, int type, int protocol)
+    : IpSocket_IoUring(bufferRing.ring(), type, protocol)
+{
+    bufferRing_ = &bufferRing;
+}
+
+IpSocket_IoUring::~IpSocket_IoUring() {
+    // close and wait for the completions of the cancelled operations which get handled as for a closed socket, the
+    // kernel must not access the members of the socket or the memory of its buffers after they were destroyed
+    close();
+    for (auto &buffer : buffers_)
+        ring_.drain(buffer);
+    ring_.drain(*this);
+    ring_.drain(receiveHandler_);
+    ring_.drain(deliverHandler_);
+    ring_.drain(errorHandler_);
+    ring_.drain(timeoutHandler_);
+}
+
+int IpSocket_IoUring::getBufferCount() {
+    return buffers_.count();
+}
+
+IpSocket_IoUring::Buffer &IpSocket_IoUring::getBuffer(int index) {
+    return buffers_.get(index);
+}
+
+bool IpSocket_IoUring::connect(const ip::Endpoint &endpoint, int size, int localPort, const Options &options) {
+    if (socket_ != -1 || !ring_.valid())
+        return false;
+
+    // create socket
+    int socket = ::socket(endpoint.protocolId, type_ | SOCK_CLOEXEC, protocol_);
+    if (socket == -1)
+        return false;
+
+    // reuse address/port
+    // https://stackoverflow.com/questions/14388706/how-do-so-reuseaddr-and-so-reuseport-differ
+    int reuse = 1;
+    if (setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == -1) {
+        ::close(socket);
+        return false;
+    }
+
+    // bind to local port
+    if (localPort != 0) {
+        sockaddr_in6 local = {.sin6_family = endpoint.protocolId, .sin6_port = htons(localPort)};
+        if (bind(socket, (sockaddr *)&local, sizeof(local)) == -1) {
+            ::close(socket);
+            return false;
+        }
+    }
+
+    // set options, e.g. TCP Fast Open
+    socketOptions::set(socket, type_, options);
+
+    if (type_ == SOCK_DGRAM) {
+        // connect UDP
+        if (::connect(socket, (struct sockaddr *)&endpoint, size) == -1) {
+            ::close(socket);
+            return false;
+        }
+        socket_ = socket;
+
+        // enable timestamps
+        if (timestamps_)
+            stamp();
+
+        // set state
+        st.set(State::READY);
+
+        // enable buffers
+        for (auto &buffer : buffers_) {
+            buffer.setReady(0);
+        }
+
+        // resume all coroutines waiting for state change
+        st.notify(Events::ENTER_OPENING | Events::ENTER_READY);
+    } else {
+        // connect TCP (completes immediately with Fast Open and the SYN is sent with the first write)
+        std::copy((const uint8_t *)&endpoint, (const uint8_t *)&endpoint + size, (uint8_t *)&endpoint_);
+        endpointSize_ = size;
+        socket_ = socket;
+
+        // a connect that was cancelled by closing the socket has to complete first (see handle())
+        if (!connecting_)
+            startConnect();
+
+        // set state
+        st.set(State::OPENING);
+
+        // enable buffers
+        for (auto &buffer : buffers_) {
+            buffer.setReady();
+        }
+
+        // resume all coroutines waiting for state change
+        st.notify(Events::ENTER_OPENING);
+    }
+
+    return true;
+}
+
+void IpSocket_IoUring::close() {
+    if (socket_ == -1)
+        return;
+
+    // cancel connect and pending transfers, completions of the buffers are ignored when they arrive (see
+    // Buffer::handle()), including the notifications of zero-copy sends
+    if (connecting_) {
+        ring_.cancel(this);
+        stale_ = true;
+    }
+    for (auto &buffer : buffers_) {
+        if (buffer.completions_ > 0) {
+            ring_.cancel(&buffer);
+            buffer.stale_ = true;
+        }
+    }
+    while (!transfers_.empty())
+        transfers_.front().remove2();
+    while (!transmits_.empty()) {
+        auto &buffer = transmits_.front();
+        buffer.stamping_ = false;
+        buffer.remove2();
+    }
+    if (polling_) {
+        ring_.cancel(&errorHandler_);
+        polling_ = false;
+    }
+    if (timeouts_ > 0)
+        ring_.cancel(&timeoutHandler_);
+
+    // cancel multishot receive, blocks that arrive until the cancellation completes are returned to the ring
+    if (multishot_)
+        ring_.cancel(&receiveHandler_);
+    while (!receives_.empty())
+        receives_.front().remove2();
+    if (bufferRing_ != nullptr) {
+        IntrusiveListNode::remove();
+        bufferRing_->clear(received_);
+    }
+
+    // close socket, the kernel has to pick up the entries that refer to it before a new socket may get the same handle
+    ring_.flush();
+    ::close(socket_);
+    socket_ = -1;
+
+    // set state
+    st.set(State::DISABLED);
+
+    // disable buffers
+    for (auto &buffer : buffers_) {
+        if (statistics_ != nullptr && buffer.busy())
+            statistics_->finished();
+        buffer.setDisabled();
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_CLOSING | Events::ENTER_DISABLED);
+}
+
+bool IpSocket_IoUring::enableTimestamps() {
+    timestamps_ = true;
+
+    // a TCP socket gets timestamps when the connection is established
+    if (socket_ != -1 && st.state == State::READY)
+        stamp();
+    return timestamps_;
+}
+
+void IpSocket_IoUring::stamp() {
+    // the kernel counts the keys from here
+    timestamps_ = timestamping::enable(socket_);
+    key_ = 0;
+
+    // watch the error queue for transmit timestamps
+    if (timestamps_ && !polling_)
+        poll();
+}
+
+void IpSocket_IoUring::poll() {
+    // one multishot poll reports each time the error queue becomes non-empty
+    auto &sqe = ring_.get(&errorHandler_);
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = socket_;
+    sqe.poll32_events = POLLERR;
+    sqe.len = IORING_POLL_ADD_MULTI;
+    ring_.commit();
+    polling_ = true;
+}
+
+void IpSocket_IoUring::handleError(const io_uring_cqe &cqe) {
+    // ignore the cancellation by close()
+    if (cqe.res == -ECANCELED)
+        return;
+
+    // the kernel ends the multishot poll on error or when it can't post more completions
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+        polling_ = false;
+    if (st.state != State::READY)
+        return;
+
+    timestamping::readTransmit(socket_, [this](uint32_t key, uint64_t timestamp) {
+        // the kernel reports in the order of sending, a UDP buffer whose report is missing (e.g. the datagram was
+        // dropped before reaching the network device) finishes without timestamp with the next report, TCP reports
+        // only the last byte of writes that were sent together
+        while (!transmits_.empty()) {
+            auto &buffer = transmits_.front();
+            if (int32_t(buffer.key_ - key) > 0)
+                break;
+
+            // remove from list of buffers waiting for their timestamp
+            buffer.stamping_ = false;
+            buffer.remove2();
+
+            // transfer finished, unless the kernel has not released the memory of zero-copy sends yet
+            buffer.header_.timestamp = buffer.key_ == key || type_ != SOCK_DGRAM ? timestamp : 0;
+            if (buffer.notifications_ == 0)
+                ready(buffer, buffer.transferred_);
+        }
+    });
+
+    if (!polling_ && st.state == State::READY)
+        poll();
+}
+
+void IpSocket_IoUring::arm() {
+    if (timeouts_ > 0 || type_ != SOCK_DGRAM || st.state != State::READY || transmits_.empty())
+        return;
+
+    // expire at the deadline of the oldest buffer, the buffers wait in the order of sending
+    int64_t deadline = transmits_.front().deadline_;
+    timeout_ = {.tv_sec = deadline / 1000000000, .tv_nsec = deadline % 1000000000};
+    auto &sqe = ring_.get(&timeoutHandler_);
+    sqe.opcode = IORING_OP_TIMEOUT;
+    sqe.addr = uint64_t(uintptr_t(&timeout_));
+    sqe.len = 1;
+    sqe.timeout_flags = IORING_TIMEOUT_ABS;
+    ring_.commit();
+    ++timeouts_;
+}
+
+void IpSocket_IoUring::handleTimeout(const io_uring_cqe &cqe) {
+    // expired (-ETIME) or cancelled by close(), a timeout that was cancelled before the socket was connected again
+    // only delays the timeout of the new socket
+    --timeouts_;
+
+    // the datagram of a buffer whose report did not arrive in time counts as sent
+    int64_t now = timestamping::now();
+    while (!transmits_.empty()) {
+        auto &buffer = transmits_.front();
+        if (buffer.deadline_ > now)
+            break;
+
+        // remove from list of buffers waiting for their timestamp
+        buffer.stamping_ = false;
+        buffer.remove2();
+
+        // transfer finished without timestamp, unless the kernel has not released the memory of zero-copy sends yet
+        buffer.header_.timestamp = 0;
+        if (buffer.notifications_ == 0)
+            ready(buffer, buffer.transferred_);
+    }
+
+    arm();
+}
+
+void IpSocket_IoUring::ready(Buffer &buffer, int size) {
+    if (statistics_ != nullptr) {
+        if (size <= 0)
+            statistics_->finished();
+        else if ((buffer.op_ & Buffer::Op::WRITE) == 0)
+            statistics_->received(1, size, buffer.started_);
+        else
+            statistics_->sent(1, size, buffer.started_);
+    }
+    buffer.setReady(buffer.split(size, (buffer.op_ & Buffer::Op::WRITE) == 0 ? buffer.capacity_ : buffer.size_));
+}
+
+void IpSocket_IoUring::fail(int error) {
+    // a cancelled transfer is no error
+    if (statistics_ != nullptr && error != ECANCELED)
+        statistics_->failed(SocketStatistics::classify(error));
+}
+
+bool IpSocket_IoUring::enableZeroCopy(int threshold) {
+    zeroCopyThreshold_ = std::max(threshold, 1);
+    return true;
+}
+
+void IpSocket_IoUring::startConnect() {
+    auto &sqe = ring_.get(this);
+    sqe.opcode = IORING_OP_CONNECT;
+    sqe.fd = socket_;
+    sqe.addr = uint64_t(&endpoint_);
+    sqe.off = endpointSize_;
+    ring_.commit();
+    connecting_ = true;
+}
+
+void IpSocket_IoUring::handle(const io_uring_cqe &cqe) {
+    // result of connect
+    connecting_ = false;
+
+    // ignore the completion of a connect that was cancelled by closing the socket, a connect that was started in the
+    // meantime (after closing) gets submitted now
+    if (stale_) {
+        stale_ = false;
+        if (st.state == State::OPENING)
+            startConnect();
+        return;
+    }
+
+    if (st.state != State::OPENING)
+        return;
+    if (cqe.res < 0) {
+        // "real" error or cancelled: close
+        fail(-cqe.res);
+        close();
+    } else {
+        // enable timestamps
+        if (timestamps_)
+            stamp();
+
+        // set state
+        st.set(State::READY);
+
+        // start pending transfers, a transfer of a buffer whose previous transfer was cancelled by closing the socket
+        // gets started when the completion of the previous transfer arrives
+        for (auto &buffer : transfers_) {
+            if (!buffer.stale_)
+                buffer.start();
+        }
+        receive();
+
+        // resume all coroutines waiting for state change
+        st.notify(Events::ENTER_READY);
+    }
+}
+
+void IpSocket_IoUring::resume() {
+    // memory was returned to the buffer ring
+    if (st.state == State::READY)
+        receive();
+}
+
+void IpSocket_IoUring::receive() {
+    if (receives_.empty())
+        return;
+
+    if (!received_.empty()) {
+        // hand over received blocks in the next loop iteration
+        if (!delivering_) {
+            auto &sqe = ring_.get(&deliverHandler_);
+            sqe.opcode = IORING_OP_NOP;
+            ring_.commit();
+            delivering_ = true;
+        }
+    } else if (!multishot_) {
+        // one multishot receive takes a block from the buffer ring each time data arrives
+        auto &sqe = ring_.get(&receiveHandler_);
+        sqe.opcode = IORING_OP_RECV;
+        sqe.fd = socket_;
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = bufferRing_->group();
+        ring_.commit();
+        multishot_ = true;
+    }
+}
+
+void IpSocket_IoUring::deliver() {
+    while (!receives_.empty() && !received_.empty()) {
+        auto &buffer = receives_.front();
+        int id = bufferRing_->pop(received_);
+
+        // the buffer points into the block until it gets started again
+        buffer.blockId_ = id;
+        buffer.data_ = bufferRing_->data(id);
+        buffer.capacity_ = bufferRing_->blockSize();
+        buffer.header_.timestamp = 0;
+
+        // remove from list of active transfers
+        buffer.remove2();
+
+        // transfer finished
+        ready(buffer, bufferRing_->size(id));
+    }
+}
+
+void IpSocket_IoUring::handleReceive(const io_uring_cqe &cqe) {
+    // the kernel ends the multishot receive on error, when the peer has closed the connection or when it can't post
+    // more completions
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    if (!more)
+        multishot_ = false;
+
+    // queue the received block, also if no buffer is waiting
+    if ((cqe.flags & IORING_CQE_F_BUFFER) != 0)
+        bufferRing_->push(received_, cqe.flags >> IORING_CQE_BUFFER_SHIFT, cqe.res);
+
+    if (st.state != State::READY) {
+        // closed: return the block to the ring
+        bufferRing_->clear(received_);
+        return;
+    }
+
+    deliver();
+
+    if (!more) {
+        if (cqe.res == -ENOBUFS) {
+            // the buffer ring ran empty: continue when memory gets returned
+            bufferRing_->wait(*this);
+        } else if ((cqe.flags & IORING_CQE_F_BUFFER) == 0 && cqe.res != -ECANCELED) {
+            // "real" error or closed by peer (end of stream, no error): return zero size
+            if (cqe.res < 0)
+                fail(-cqe.res);
+            while (!receives_.empty()) {
+                auto &buffer = receives_.front();
+                buffer.remove2();
+                ready(buffer, 0);
+            }
+        } else {
+            receive();
+        }
+    }
+}
+
+void IpSocket_IoUring::handleDeliver(const io_uring_cqe &cqe) {
+    delivering_ = false;
+    if (st.state != State::READY)
+        return;
+    deliver();
+
+    // continue receiving if buffers are still waiting
+    receive();
+}
+
+
+// IpSocket_IoUring::Buffer
+
+IpSocket_IoUring::Buffer::Buffer(IpSocket_IoUring &device, int size)
+    : Buffer(device, new uint8_t[size], size)
+{
+    ownsData_ = true;
+}
+
+IpSocket_IoUring::Buffer::Buffer(IpSocket_IoUring &device, BufferPool &pool)
+    : Buffer(device, pool.allocate(), pool.blockSize())
+{
+    pool_ = &pool;
+    if (data_ == nullptr)
+        capacity_ = 0;
+}
+
+IpSocket_IoUring::Buffer::Buffer(IpSocket_IoUring &device, uint8_t *data, int size)
+    : coco::Buffer(&header_, sizeof(header_), 0, data, size, device.st.state)
+    , device_(device)
+{
+    device.buffers_.add(*this);
+}
+
+IpSocket_IoUring::Buffer::Buffer(IpSocket_IoUring &device)
+    : Buffer(device, nullptr, 0)
+{
+    fromRing_ = true;
+}
+
+IpSocket_IoUring::Buffer::~Buffer() {
+    if (completions_ > 0) {
+        // ignore the completions of the pending transfer (see handle()) and wait for them, the kernel must not access
+        // the memory after it was freed
+        stale_ = true;
+        setDisabled();
+        device_.ring_.drain(*this);
+    }
+    remove2();
+    release();
+    if (pool_ != nullptr) {
+        if (data_ != nullptr)
+            pool_->free(data_);
+    } else if (ownsData_) {
+        delete [] data_;
+    }
+}
+
+bool IpSocket_IoUring::Buffer::start(Op op) {
+    if (st.state != State::READY) {
+        assert(st.state != State::BUSY);
+        return false;
+    }
+
+    // check if READ or WRITE flag is set
+    assert((op & Op::READ_WRITE) != 0);
+    op_ = op;
+    transferred_ = 0;
+    chainSize_ = 0;
+
+    // buffers without own memory can't receive into a chain
+    assert(!fromRing_ || (op & Op::WRITE) != 0 || chain_.empty());
+    notifications_ = 0;
+    sent_ = false;
+    stamping_ = false;
+    header_.timestamp = 0;
+    if (device_.statistics_ != nullptr)
+        started_ = device_.statistics_->start();
+
+    if (fromRing_ && (op & Op::WRITE) == 0) {
+        // return the block of the previous read to the ring and wait for the next data
+        release();
+        device_.receives_.add(*this);
+
+        // set state
+        setBusy();
+
+        // receive into the buffer ring if device is ready
+        if (device_.st.state == Device::State::READY)
+            device_.receive();
+
+        return true;
+    }
+
+    // add to list of pending transfers
+    device_.transfers_.add(*this);
+
+    // start if device is ready, a transfer of the buffer that was cancelled by closing the socket has to complete first
+    if (device_.st.state == Device::State::READY && !stale_)
+        start();
+
+    // set state
+    setBusy();
+
+    return true;
+}
+
+bool IpSocket_IoUring::Buffer::cancel() {
+    if (st.state != State::BUSY)
+        return false;
+
+    if (stamping_) {
+        // remove from list of buffers waiting for their timestamp
+        stamping_ = false;
+        remove2();
+
+        // cancelled: the data was sent, return its size without timestamp
+        if (notifications_ == 0)
+            device_.ready(*this, transferred_);
+
+        return true;
+    }
+
+    if (fromRing_ && (op_ & Op::WRITE) == 0) {
+        // remove from list of buffers waiting for the buffer ring
+        remove2();
+
+        // cancelled: return zero size
+        device_.ready(*this, 0);
+
+        return true;
+    }
+
+    if (stale_) {
+        // not submitted yet: remove from list of pending transfers
+        remove2();
+
+        // cancelled: return zero size
+        device_.ready(*this, 0);
+
+        return true;
+    }
+
+    // the completion arrives with -ECANCELED
+    device_.ring_.cancel(this);
+
+    return true;
+}
+
+void IpSocket_IoUring::Buffer::start() {
+    auto &sqe = device_.ring_.get(this);
+    sqe.fd = device_.socket_;
+    if ((op_ & Op::WRITE) == 0) {
+        // receive
+        message_ = {};
+        if (device_.timestamps_ || !chain_.empty()) {
+            // receive into the buffer followed by its chain, with timestamp
+            message_.msg_iov = vectors_;
+            message_.msg_iovlen = getVectors(vectors_, data_, capacity_, 0, toVector);
+            if (device_.timestamps_) {
+                message_.msg_control = control_;
+                message_.msg_controllen = sizeof(control_);
+            }
+            sqe.opcode = IORING_OP_RECVMSG;
+            sqe.addr = uint64_t(&message_);
+            sqe.len = 1;
+        } else {
+            sqe.opcode = IORING_OP_RECV;
+            sqe.addr = uint64_t(data_);
+            sqe.len = capacity_;
+        }
+    } else {
+        // send, large writes are sent directly from the memory of the buffer
+        zeroCopy_ = device_.zeroCopyThreshold_ > 0 && size_ + getChainCapacity() >= device_.zeroCopyThreshold_;
+        if (chain_.empty()) {
+            sqe.opcode = zeroCopy_ ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+            sqe.addr = uint64_t(data_ + transferred_);
+            sqe.len = size_ - transferred_;
+        } else {
+            // send the rest of the buffer followed by its chain
+            message_ = {.msg_iov = vectors_};
+            message_.msg_iovlen = getVectors(vectors_, data_, size_, transferred_, toVector);
+            sqe.opcode = zeroCopy_ ? IORING_OP_SENDMSG_ZC : IORING_OP_SENDMSG;
+            sqe.addr = uint64_t(&message_);
+            sqe.len = 1;
+        }
+        if (zeroCopy_)
+            sqe.ioprio = IORING_SEND_ZC_REPORT_USAGE;
+        else
+            ++device_.zeroCopy_.copied;
+        sqe.msg_flags = MSG_NOSIGNAL;
+    }
+    device_.ring_.commit();
+    ++completions_;
+}
+
+void IpSocket_IoUring::Buffer::handle(const io_uring_cqe &cqe) {
+    // count the completions, a notification follows the result of a zero-copy send
+    --completions_;
+    if ((cqe.flags & IORING_CQE_F_MORE) != 0)
+        ++completions_;
+
+    // ignore the completions of a transfer that was cancelled by closing the socket, a transfer that was started again
+    // in the meantime (after reconnecting) gets submitted when all completions have arrived
+    if (stale_) {
+        if (completions_ == 0) {
+            stale_ = false;
+            if (st.state == State::BUSY && device_.st.state == Device::State::READY)
+                start();
+        }
+        return;
+    }
+
+    if ((cqe.flags & IORING_CQE_F_NOTIF) != 0) {
+        // the kernel has released the memory of a zero-copy send
+        --notifications_;
+        if ((cqe.res & IORING_NOTIF_USAGE_ZC_COPIED) != 0)
+            ++device_.zeroCopy_.copied;
+        else
+            ++device_.zeroCopy_.zeroCopy;
+
+        // transfer finished
+        if (sent_ && notifications_ == 0 && !stamping_)
+            device_.ready(*this, transferred_);
+        return;
+    }
+
+    // a notification follows the result of a zero-copy send
+    if ((cqe.flags & IORING_CQE_F_MORE) != 0)
+        ++notifications_;
+
+    if (cqe.res == -EINVAL && zeroCopy_) {
+        // zero-copy send is not supported by the kernel: copy
+        device_.zeroCopyThreshold_ = 0;
+        start();
+        return;
+    }
+
+    if ((op_ & Op::WRITE) == 0) {
+        header_.timestamp = cqe.res >= 0 ? timestamping::get(message_) : 0;
+    } else if (cqe.res >= 0 && device_.timestamps_ && (device_.type_ == SOCK_DGRAM || cqe.res > 0)) {
+        // UDP counts the keys per message, TCP per byte and reports the key of the last byte
+        device_.key_ += device_.type_ == SOCK_DGRAM ? 1 : cqe.res;
+        stamping_ = true;
+        key_ = device_.key_ - 1;
+    }
+
+    if (cqe.res > 0) {
+        transferred_ += cqe.res;
+
+        // TCP may send only a part of the buffer, then send the rest
+        if ((op_ & Op::WRITE) != 0 && transferred_ < size_ + getChainCapacity()) {
+            start();
+            return;
+        }
+    }
+
+    // remove from list of active transfers
+    remove2();
+    if (cqe.res < 0)
+        device_.fail(-cqe.res);
+
+    // wait for the transmit timestamp, no timestamp will be reported after an error
+    if (stamping_) {
+        if (cqe.res >= 0) {
+            sent_ = true;
+            deadline_ = timestamping::now() + timestamping::TRANSMIT_TIMEOUT;
+            device_.transmits_.add(*this);
+            device_.arm();
+        } else {
+            stamping_ = false;
+        }
+    }
+
+    // wait until the kernel has released the memory of zero-copy sends
+    if (notifications_ > 0) {
+        sent_ = true;
+        return;
+    }
+    if (stamping_)
+        return;
+
+    // transfer finished ("real" error, cancelled or closed by peer: zero size)
+    device_.ready(*this, transferred_);
+}
+
+void IpSocket_IoUring::Buffer::release() {
+    // return the block that holds the received data to the buffer ring
+    if (blockId_ != -1) {
+        device_.bufferRing_->add(blockId_);
+        blockId_ = -1;
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+}
+
+} // namespace coco
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <coco/IpSocket.hpp>
+#include <coco/BufferPool.hpp>
+#include <coco/IntrusiveList.hpp>
+#include <coco/platform/IoUring_Linux.hpp>
+#include <coco/platform/Timestamping_Linux.hpp>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+namespace coco {
+
+/// @brief Connection based IP socket on Linux using io_uring.
+/// Each started buffer becomes a submission queue entry and gets finished by its completion queue entry.
+/// When constructed with a buffer ring, buffers without own memory receive using one multishot receive per socket and
+/// get the memory from the ring when data arrives. The memory is returned to the ring when the buffer is read again.
+/// With zero-copy send enabled, large writes use IORING_OP_SEND_ZC and the buffer stays busy until the notification
+/// reports that the kernel has released its memory. With timestamps enabled, a write buffer also waits for its
+/// transmit timestamp which a multishot poll picks up from the error queue of the socket, on a UDP socket at most until
+/// a timeout operation completes.
+/// Destroying the socket or a buffer cancels the pending operations and blocks until their completions have arrived.
+class IpSocket_IoUring : public IpSocket, public IoUring_Linux::Handler, public IoUring_Linux::BufferRing::Receiver {
+public:
+    /// @brief Constructor using the default ring of the event loop.
+    /// @param loop event loop
+    /// @param type socket type such as SOCK_STREAM or SOCK_DGRAM
+    /// @param protocol protocol such as IPPROTO_TCP or IPPROTO_UDP
+    IpSocket_IoUring(Loop_Linux &loop, int type = SOCK_STREAM, int protocol = IPPROTO_TCP)
+        : IpSocket_IoUring(IoUring_Linux::get(loop), type, protocol) {}
+
+    /// @brief Constructor.
+    /// @param ring io_uring, e.g. with IoUring_Linux::Flags::SQPOLL for latency-critical sockets
+    /// @param type socket type such as SOCK_STREAM or SOCK_DGRAM
+    /// @param protocol protocol such as IPPROTO_TCP or IPPROTO_UDP
+    IpSocket_IoUring(IoUring_Linux &ring, int type = SOCK_STREAM, int protocol = IPPROTO_TCP);
+
+    /// @brief Constructor for receiving into a shared buffer ring.
+    /// @param bufferRing buffer ring
+    /// @param type socket type such as SOCK_STREAM or SOCK_DGRAM
+    /// @param protocol protocol such as IPPROTO_TCP or IPPROTO_UDP
+    IpSocket_IoUring(IoUring_Linux::BufferRing &bufferRing, int type = SOCK_STREAM, int protocol = IPPROTO_TCP);
+
+    ~IpSocket_IoUring() override;
+
+    // TcpSocket methods
+    bool connect(const ip::Endpoint &endpoint, int size = sizeof(ip::Endpoint), int localPort = 0,
+        const Options &options = {}) override;
+    using IpSocket::connect;
+
+    // BufferDevice methods
+    class Buffer;
+    int getBufferCount() override;
+    Buffer &getBuffer(int index) override;
+
+    // Device methods
+    void close() override;
+
+    /// @brief Enable zero-copy send (IORING_OP_SEND_ZC) for large writes.
+    /// A write buffer stays busy until the kernel has released its memory, i.e. the data was acknowledged by the peer.
+    /// @param threshold minimum size of a write, smaller writes are copied because the notification costs more than
+    /// the copy
+    /// @return true if successful
+    bool enableZeroCopy(int threshold = 65536);
+
+    /// @brief Get statistics of zero-copy send.
+    /// @return zero-copy statistics
+    const ZeroCopyStatistics &getZeroCopy() const {return zeroCopy_;}
+
+    /// @brief Enable kernel or hardware timestamps (SO_TIMESTAMPING), see Header::timestamp. Can be called before or
+    /// after connect(), a TCP socket gets them when the connection is established. Buffers that receive from the
+    /// buffer ring get no timestamp.
+    /// A write buffer stays busy until the transmit timestamp of its last byte was reported. On a UDP socket, a
+    /// datagram whose report is missing (e.g. dropped before reaching the network device) finishes without timestamp
+    /// when a later report arrives or after timestamping::TRANSMIT_TIMEOUT.
+    /// @return true if successful, false if the kernel does not support timestamps
+    bool enableTimestamps();
+
+
+    /// @brief Buffer for transferring data to/from a TCP socket.
+    ///
+    class Buffer : public coco::Buffer, public BufferChain, public IntrusiveListNode, public IntrusiveListNode2, public IoUring_Linux::Handler {
+        friend class IpSocket_IoUring;
+    public:
+        Buffer(IpSocket_IoUring &device, int size);
+
+        /// @brief Constructor that takes the memory from a pool.
+        /// @param device socket
+        /// @param pool pool of memory blocks, the capacity is the block size (0 if the pool is exhausted)
+        Buffer(IpSocket_IoUring &device, BufferPool &pool);
+
+        /// @brief Constructor that wraps caller-provided memory, e.g. a mmap'd region.
+        /// @param device socket
+        /// @param data memory, has to stay valid until the buffer is destroyed
+        /// @param size size of the memory
+        Buffer(IpSocket_IoUring &device, uint8_t *data, int size);
+
+        /// @brief Constructor for a buffer without own memory that receives into the buffer ring of the socket.
+        /// After reading, data() points into the ring and stays valid until the buffer is started again.
+        /// @param device socket that was constructed with a buffer ring
+        Buffer(IpSocket_IoUring &device);
+
+        ~Buffer() override;
+
+        bool start(Op op) override;
+        bool cancel() override;
+
+    protected:
+        void start();
+        void handle(const io_uring_cqe &cqe) override;
+        void release();
+
+        IpSocket_IoUring &device_;
+
+        // memory is either owned, taken from a pool, provided by the caller or taken from the buffer ring
+        BufferPool *pool_ = nullptr;
+        bool ownsData_ = false;
+        bool fromRing_ = false;
+
+        // block of the buffer ring that holds the received data
+        int blockId_ = -1;
+
+        // message header for receiving with timestamp
+        Header header_ = {};
+        iovec vectors_[BufferChain::MAX_COUNT + 1];
+        msghdr message_;
+        alignas(cmsghdr) uint8_t control_[timestamping::CONTROL_SIZE];
+        Op op_;
+
+        // number of bytes already sent (TCP may send only a part of the buffer)
+        int transferred_;
+
+        // true if the last send was a zero-copy send
+        bool zeroCopy_;
+
+        // number of completions that have not arrived (results and zero-copy notifications), and true if they belong to a
+        // transfer that was cancelled by closing the socket
+        int completions_ = 0;
+        bool stale_ = false;
+
+        // number of zero-copy sends whose memory was not released yet, set sent_ when all data was sent
+        int notifications_;
+        bool sent_;
+
+        // true while the buffer waits for the transmit timestamp with the given key (last message or byte), time
+        // after which a UDP buffer finishes without timestamp
+        bool stamping_ = false;
+        uint32_t key_;
+        int64_t deadline_;
+
+        // start time for the statistics
+        uint64_t started_;
+    };
+
+protected:
+    void startConnect();
+    void handle(const io_uring_cqe &cqe) override;
+    void resume() override;
+    void receive();
+    void deliver();
+    void handleReceive(const io_uring_cqe &cqe);
+    void handleDeliver(const io_uring_cqe &cqe);
+    void stamp();
+    void poll();
+    void handleError(const io_uring_cqe &cqe);
+
+    // finish the sent UDP buffers whose transmit timestamp did not arrive in time, submit the timeout for the next one
+    void arm();
+    void handleTimeout(const io_uring_cqe &cqe);
+
+    // set a buffer ready and update the statistics, a buffer without data counts as finished without packet
+    void ready(Buffer &buffer, int size);
+
+    // count an error in the statistics
+    void fail(int error);
+
+    // constructor that shares the ownership of the default ring of the event loop
+    IpSocket_IoUring(std::shared_ptr<IoUring_Linux> ring, int type, int protocol)
+        : IpSocket_IoUring(*ring, type, protocol) {defaultRing_ = std::move(ring);}
+
+    // default ring that is owned together with the other sockets of the loop, destroyed after all other members
+    std::shared_ptr<IoUring_Linux> defaultRing_;
+    IoUring_Linux &ring_;
+    int type_;
+    int protocol_;
+
+    // socket handle
+    int socket_ = -1;
+
+    // endpoint of server that stays valid until the connect completes
+    ip::Endpoint endpoint_ = {};
+    int endpointSize_;
+
+    // true while the completion of a connect is pending, and true if it belongs to a connect that was cancelled by
+    // closing the socket
+    bool connecting_ = false;
+    bool stale_ = false;
+
+    // minimum size of writes that are sent with zero-copy (0 if disabled)
+    int zeroCopyThreshold_ = 0;
+
+    // statistics
+    ZeroCopyStatistics zeroCopy_;
+
+    // true if timestamps are enabled, key of the next message (UDP) or byte (TCP)
+    bool timestamps_ = false;
+    uint32_t key_ = 0;
+
+    // sent buffers waiting for their transmit timestamp and multishot poll for the error queue that reports them
+    IntrusiveList2<Buffer> transmits_;
+    IoUring_Linux::MemberHandler<IpSocket_IoUring, &IpSocket_IoUring::handleError> errorHandler_{*this};
+    bool polling_ = false;
+
+    // timeout that finishes the sent UDP buffers whose report is missing, number of submitted timeouts
+    IoUring_Linux::MemberHandler<IpSocket_IoUring, &IpSocket_IoUring::handleTimeout> timeoutHandler_{*this};
+    __kernel_timespec timeout_;
+    int timeouts_ = 0;
+
+    // list of buffers
+    IntrusiveList<Buffer> buffers_;
+
+    // pending transfers
+    IntrusiveList2<Buffer> transfers_;
+
+    // buffer ring for receiving with multishot receive
+    IoUring_Linux::BufferRing *bufferRing_ = nullptr;
+    IoUring_Linux::MemberHandler<IpSocket_IoUring, &IpSocket_IoUring::handleReceive> receiveHandler_{*this};
+    IoUring_Linux::MemberHandler<IpSocket_IoUring, &IpSocket_IoUring::handleDeliver> deliverHandler_{*this};
+
+    // true while the multishot receive is active
+    bool multishot_ = false;
+
+    // true while delivery of received blocks is scheduled for the next loop iteration
+    bool delivering_ = false;
+
+    // buffers waiting for data from the buffer ring and received blocks waiting for a buffer
+    IntrusiveList2<Buffer> receives_;
+    IoUring_Linux::BufferRing::Queue received_;
+};
+
+} // namespace coco
@@ -0,0 +1,594 @@
+#include "IpSocket_Linux.hpp"
+#include "SocketOptions_Linux.hpp"
+#include "Timestamping_Linux.hpp"
+#include <linux/errqueue.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+
+
+namespace coco {
+
+// create a vector for vectored I/O
+static iovec toVector(uint8_t *data, int size) {
+    return {data, size_t(size)};
+}
+
+IpSocket_Linux::IpSocket_Linux(Loop_Linux &loop, int type, int protocol)
+    : IpSocket(State::DISABLED)
+    , loop_(loop)
+    , type_(type), protocol_(protocol)
+{
+}
+
+IpSocket_Linux::~IpSocket_Linux() {
+    if (socket_ != -1)
+        ::close(socket_);
+    closeTimer();
+}
+
+int IpSocket_Linux::getBufferCount() {
+    return buffers_.count();
+}
+
+IpSocket_Linux::Buffer &IpSocket_Linux::getBuffer(int index) {
+    return buffers_.get(index);
+}
+
+bool IpSocket_Linux::connect(const ip::Endpoint &endpoint, int size, int localPort, const Options &options) {
+    if (socket_ != -1)
+        return false;
+
+    // create non-blocking socket
+    int socket = ::socket(endpoint.protocolId, type_ | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol_);
+    if (socket == -1)
+        return false;
+
+    // reuse address/port
+    // https://stackoverflow.com/questions/14388706/how-do-so-reuseaddr-and-so-reuseport-differ
+    int reuse = 1;
+    if (setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == -1) {
+        ::close(socket);
+        return false;
+    }
+
+    // bind to local port
+    if (localPort != 0) {
+        sockaddr_in6 local = {.sin6_family = endpoint.protocolId, .sin6_port = htons(localPort)};
+        if (bind(socket, (sockaddr *)&local, sizeof(local)) == -1) {
+            ::close(socket);
+            return false;
+        }
+    }
+
+    // set options, e.g. TCP Fast Open
+    socketOptions::set(socket, type_, options);
+
+    // enable zero-copy send
+    int zeroCopy = 1;
+    if (zeroCopyThreshold_ > 0 && setsockopt(socket, SOL_SOCKET, SO_ZEROCOPY, &zeroCopy, sizeof(zeroCopy)) == -1)
+        zeroCopyThreshold_ = 0;
+    sequence_ = 0;
+    released_ = 0;
+
+    // add socket to epoll of event loop (edge-triggered)
+    Loop_Linux::CompletionHandler *handler = this;
+    epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data = {.ptr = handler}};
+    if (epoll_ctl(loop_.epollQueue, EPOLL_CTL_ADD, socket, &event) == -1) {
+        ::close(socket);
+        return false;
+    }
+
+    // the initial state gets reported by epoll
+    readable_ = false;
+    writable_ = false;
+    updating_ = true;
+
+    // connect (TCP connect is finished by the first epoll event that reports the socket as writable, with Fast Open
+    // immediately and the SYN is sent with the first write)
+    if (::connect(socket, (struct sockaddr *)&endpoint, size) == -1) {
+        if (type_ == SOCK_DGRAM || errno != EINPROGRESS) {
+            // "real" error
+            ::close(socket);
+            return false;
+        }
+    }
+    socket_ = socket;
+
+    if (type_ == SOCK_DGRAM) {
+        // enable timestamps
+        if (timestamps_)
+            stamp();
+
+        // set state
+        st.set(State::READY);
+
+        // enable buffers
+        for (auto &buffer : buffers_) {
+            buffer.setReady(0);
+        }
+
+        // resume all coroutines waiting for state change
+        st.notify(Events::ENTER_OPENING | Events::ENTER_READY);
+    } else {
+        // set state
+        st.set(State::OPENING);
+
+        // enable buffers
+        for (auto &buffer : buffers_) {
+            buffer.setReady();
+        }
+
+        // resume all coroutines waiting for state change
+        st.notify(Events::ENTER_OPENING);
+    }
+
+    return true;
+}
+
+void IpSocket_Linux::close() {
+    if (socket_ == -1)
+        return;
+
+    // close socket and timer (also removes them from epoll)
+    ::close(socket_);
+    socket_ = -1;
+    closeTimer();
+
+    // drop pending transfers
+    while (!receives_.empty())
+        receives_.front().remove2();
+    while (!sends_.empty())
+        sends_.front().remove2();
+    while (!releases_.empty())
+        releases_.front().remove2();
+
+    // set state
+    st.set(State::DISABLED);
+
+    // disable buffers
+    for (auto &buffer : buffers_) {
+        if (statistics_ != nullptr && buffer.busy())
+            statistics_->finished();
+        buffer.setDisabled();
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_CLOSING | Events::ENTER_DISABLED);
+}
+
+bool IpSocket_Linux::enableTimestamps() {
+    timestamps_ = true;
+
+    // a TCP socket gets timestamps when the connection is established
+    if (socket_ != -1 && st.state == State::READY)
+        stamp();
+    return timestamps_;
+}
+
+void IpSocket_Linux::stamp() {
+    // the kernel counts the keys from here, UDP needs the timer for transmit timestamps that are not reported
+    timestamps_ = (type_ != SOCK_DGRAM || openTimer()) && timestamping::enable(socket_);
+    if (!timestamps_)
+        closeTimer();
+    key_ = 0;
+}
+
+bool IpSocket_Linux::enableZeroCopy(int threshold) {
+    if (socket_ != -1) {
+        int zeroCopy = 1;
+        if (setsockopt(socket_, SOL_SOCKET, SO_ZEROCOPY, &zeroCopy, sizeof(zeroCopy)) == -1)
+            return false;
+    }
+    zeroCopyThreshold_ = std::max(threshold, 1);
+    return true;
+}
+
+void IpSocket_Linux::handle(epoll_event &event) {
+    updating_ = false;
+
+    // notifications of zero-copy sends and transmit timestamps are reported as error
+    if ((event.events & EPOLLERR) != 0 && (zeroCopyThreshold_ > 0 || timestamps_))
+        release();
+
+    // errors and hangup are reported by the next receive or send
+    if ((event.events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) != 0)
+        readable_ = true;
+    if ((event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0)
+        writable_ = true;
+
+    if (st.state == State::OPENING) {
+        // wait until the socket becomes writable which indicates the result of the TCP connect
+        if (!writable_)
+            return;
+
+        // get result of connect
+        int error = 0;
+        socklen_t size = sizeof(error);
+        if (getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error, &size) == -1 || error != 0) {
+            // "real" error or refused: close
+            fail(error != 0 ? error : errno);
+            close();
+            return;
+        }
+
+        // enable timestamps
+        if (timestamps_)
+            stamp();
+
+        // set state
+        st.set(State::READY);
+
+        // start pending transfers
+        receive();
+        send();
+
+        // resume all coroutines waiting for state change
+        st.notify(Events::ENTER_READY);
+        return;
+    }
+
+    receive();
+    send();
+}
+
+void IpSocket_Linux::update() {
+    if (updating_ || st.state != State::READY)
+        return;
+    if ((readable_ && !receives_.empty()) || (writable_ && !sends_.empty())) {
+        // modifying an edge-triggered file descriptor reports its current readiness again
+        Loop_Linux::CompletionHandler *handler = this;
+        epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data = {.ptr = handler}};
+        epoll_ctl(loop_.epollQueue, EPOLL_CTL_MOD, socket_, &event);
+        updating_ = true;
+    }
+}
+
+void IpSocket_Linux::receive() {
+    while (readable_ && !receives_.empty()) {
+        auto &buffer = receives_.front();
+
+        int result;
+        if (timestamps_ || !buffer.chain_.empty()) {
+            // receive into the buffer followed by its chain, with timestamp
+            iovec vectors[BufferChain::MAX_COUNT + 1];
+            int vectorCount = buffer.getVectors(vectors, buffer.data_, buffer.capacity_, 0, toVector);
+            alignas(cmsghdr) uint8_t control[timestamping::CONTROL_SIZE];
+            msghdr message = {.msg_iov = vectors, .msg_iovlen = size_t(vectorCount)};
+            if (timestamps_) {
+                message.msg_control = control;
+                message.msg_controllen = sizeof(control);
+            }
+            result = recvmsg(socket_, &message, 0);
+            buffer.header_.timestamp = result >= 0 && timestamps_ ? timestamping::get(message) : 0;
+        } else {
+            result = recv(socket_, buffer.data_, buffer.capacity_, 0);
+        }
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // wait for next edge
+                readable_ = false;
+                break;
+            }
+
+            // "real" error: return zero size
+            fail(errno);
+            result = 0;
+        }
+
+        // remove from list of active transfers
+        buffer.remove2();
+
+        // transfer finished (zero size if the peer has closed the connection)
+        ready(buffer, result);
+    }
+}
+
+void IpSocket_Linux::send() {
+    while (writable_ && !sends_.empty()) {
+        auto &buffer = sends_.front();
+        int size = buffer.size_ + buffer.getChainCapacity();
+
+        // send the rest of the buffer followed by its chain
+        iovec vectors[BufferChain::MAX_COUNT + 1];
+        int vectorCount = buffer.getVectors(vectors, buffer.data_, buffer.size_, buffer.transferred_, toVector);
+        msghdr message = {.msg_iov = vectors, .msg_iovlen = size_t(vectorCount)};
+
+        // large writes are sent directly from the memory of the buffer
+        bool zeroCopy = zeroCopyThreshold_ > 0 && size >= zeroCopyThreshold_;
+        int result = sendmsg(socket_, &message, zeroCopy ? MSG_NOSIGNAL | MSG_ZEROCOPY : MSG_NOSIGNAL);
+        if (result < 0 && zeroCopy && errno == ENOBUFS) {
+            // the kernel can't pin more memory (socket option memory limit): copy
+            zeroCopy = false;
+            result = sendmsg(socket_, &message, MSG_NOSIGNAL);
+        }
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // wait for next edge
+                writable_ = false;
+                break;
+            }
+
+            // "real" error: return zero size, no timestamp will be reported
+            fail(errno);
+            buffer.stamping_ = false;
+            finish(buffer, 0);
+            continue;
+        }
+
+        if (zeroCopy) {
+            // each zero-copy send gets a sequence number that is reported by its notification
+            buffer.zeroCopy_ = true;
+            buffer.sequence_ = sequence_++;
+        } else {
+            ++zeroCopy_.copied;
+        }
+
+        if (timestamps_ && (type_ == SOCK_DGRAM || result > 0)) {
+            // UDP counts the keys per message, TCP per byte and reports the key of the last byte
+            key_ += type_ == SOCK_DGRAM ? 1 : result;
+            buffer.stamping_ = true;
+            buffer.key_ = key_ - 1;
+            buffer.deadline_ = timestamping::now() + timestamping::TRANSMIT_TIMEOUT;
+        }
+
+        // TCP may send only a part of the buffer, then the socket send buffer is full
+        buffer.transferred_ += result;
+        if (buffer.transferred_ < size) {
+            writable_ = false;
+            break;
+        }
+
+        // transfer finished
+        finish(buffer, buffer.transferred_);
+    }
+}
+
+void IpSocket_Linux::finish(Buffer &buffer, int size) {
+    // remove from list of active transfers
+    buffer.remove2();
+
+    if (waiting(buffer)) {
+        // wait until the kernel has released the memory and reported the transmit timestamp
+        buffer.transferred_ = size;
+        releases_.add(buffer);
+        arm();
+    } else {
+        ready(buffer, size);
+    }
+}
+
+void IpSocket_Linux::ready(Buffer &buffer, int size) {
+    if (statistics_ != nullptr) {
+        if (size <= 0)
+            statistics_->finished();
+        else if ((buffer.op_ & Buffer::Op::WRITE) == 0)
+            statistics_->received(1, size, buffer.started_);
+        else
+            statistics_->sent(1, size, buffer.started_);
+    }
+    buffer.setReady(buffer.split(size, (buffer.op_ & Buffer::Op::WRITE) == 0 ? buffer.capacity_ : buffer.size_));
+}
+
+void IpSocket_Linux::fail(int error) {
+    // a cancelled transfer is no error
+    if (statistics_ != nullptr && error != ECANCELED)
+        statistics_->failed(SocketStatistics::classify(error));
+}
+
+bool IpSocket_Linux::waiting(Buffer &buffer) {
+    return (buffer.zeroCopy_ && int32_t(buffer.sequence_ - released_) >= 0) || buffer.stamping_;
+}
+
+void IpSocket_Linux::release() {
+    alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(scm_timestamping))
+        + CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+    msghdr message = {.msg_control = control, .msg_controllen = sizeof(control)};
+    while (recvmsg(socket_, &message, MSG_ERRQUEUE) != -1) {
+        // the kernel reports the transmit timestamps in the order of sending
+        uint32_t key;
+        uint64_t timestamp;
+        if (timestamping::getTransmit(message, key, timestamp)) {
+            for (auto &buffer : releases_) {
+                if (!buffer.stamping_)
+                    continue;
+                if (int32_t(buffer.key_ - key) > 0)
+                    break;
+
+                // a UDP buffer whose report is missing (e.g. the datagram was dropped before reaching the network
+                // device) gets no timestamp, TCP reports only the last byte of writes that were sent together
+                buffer.stamping_ = false;
+                buffer.header_.timestamp = buffer.key_ == key || type_ != SOCK_DGRAM ? timestamp : 0;
+            }
+        }
+
+        for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                && !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+            {
+                continue;
+            }
+            auto &error = *(sock_extended_err *)CMSG_DATA(cmsg);
+            if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+
+            // the notification covers a range of sends, TCP releases them in order
+            uint32_t count = error.ee_data - error.ee_info + 1;
+            if ((error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0)
+                zeroCopy_.copied += count;
+            else
+                zeroCopy_.zeroCopy += count;
+            released_ = error.ee_data + 1;
+        }
+        message.msg_controllen = sizeof(control);
+
+        // finish the buffers whose last zero-copy send was released and whose transmit timestamp was reported
+        complete();
+    }
+}
+
+void IpSocket_Linux::complete() {
+    while (!releases_.empty()) {
+        auto &buffer = releases_.front();
+        if (waiting(buffer))
+            break;
+
+        // remove from list of active transfers
+        buffer.remove2();
+
+        // transfer finished
+        ready(buffer, buffer.transferred_);
+    }
+}
+
+bool IpSocket_Linux::openTimer() {
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer == -1)
+        return false;
+
+    // add timer to epoll of event loop
+    Loop_Linux::CompletionHandler *handler = &timer_;
+    epoll_event event = {.events = EPOLLIN, .data = {.ptr = handler}};
+    if (epoll_ctl(loop_.epollQueue, EPOLL_CTL_ADD, timer, &event) == -1) {
+        ::close(timer);
+        return false;
+    }
+    timerFd_ = timer;
+    timing_ = false;
+    return true;
+}
+
+void IpSocket_Linux::closeTimer() {
+    if (timerFd_ == -1)
+        return;
+    ::close(timerFd_);
+    timerFd_ = -1;
+    timing_ = false;
+}
+
+void IpSocket_Linux::expire() {
+    // clear the expiration of the timer
+    uint64_t count;
+    (void)!read(timerFd_, &count, sizeof(count));
+    timing_ = false;
+
+    // the datagram of a buffer whose report did not arrive in time counts as sent
+    int64_t now = timestamping::now();
+    for (auto &buffer : releases_) {
+        if (!buffer.stamping_)
+            continue;
+        if (buffer.deadline_ > now)
+            break;
+        buffer.stamping_ = false;
+        buffer.header_.timestamp = 0;
+    }
+    complete();
+
+    arm();
+}
+
+void IpSocket_Linux::arm() {
+    if (timing_ || timerFd_ == -1)
+        return;
+
+    // expire at the deadline of the oldest buffer that waits for its timestamp, the buffers wait in the order of sending
+    for (auto &buffer : releases_) {
+        if (!buffer.stamping_)
+            continue;
+        int64_t deadline = buffer.deadline_;
+        itimerspec time = {.it_value = {.tv_sec = time_t(deadline / 1000000000), .tv_nsec = long(deadline % 1000000000)}};
+        timing_ = timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &time, nullptr) == 0;
+        break;
+    }
+}
+
+
+// IpSocket_Linux::Buffer
+
+IpSocket_Linux::Buffer::Buffer(IpSocket_Linux &device, int size)
+    : Buffer(device, new uint8_t[size], size)
+{
+    ownsData_ = true;
+}
+
+IpSocket_Linux::Buffer::Buffer(IpSocket_Linux &device, BufferPool &pool)
+    : Buffer(device, pool.allocate(), pool.blockSize())
+{
+    pool_ = &pool;
+    if (data_ == nullptr)
+        capacity_ = 0;
+}
+
+IpSocket_Linux::Buffer::Buffer(IpSocket_Linux &device, uint8_t *data, int size)
+    : coco::Buffer(&header_, sizeof(header_), 0, data, size, device.st.state)
+    , device_(device)
+{
+    device.buffers_.add(*this);
+}
+
+IpSocket_Linux::Buffer::~Buffer() {
+    if (pool_ != nullptr) {
+        if (data_ != nullptr)
+            pool_->free(data_);
+    } else if (ownsData_) {
+        delete [] data_;
+    }
+}
+
+bool IpSocket_Linux::Buffer::start(Op op) {
+    if (st.state != State::READY) {
+        assert(st.state != State::BUSY);
+        return false;
+    }
+
+    // check if READ or WRITE flag is set
+    assert((op & Op::READ_WRITE) != 0);
+    op_ = op;
+    transferred_ = 0;
+    chainSize_ = 0;
+    zeroCopy_ = false;
+    stamping_ = false;
+    header_.timestamp = 0;
+    if (device_.statistics_ != nullptr)
+        started_ = device_.statistics_->start();
+
+    // add to list of pending transfers
+    if ((op & Op::WRITE) == 0)
+        device_.receives_.add(*this);
+    else
+        device_.sends_.add(*this);
+
+    // set state
+    setBusy();
+
+    // transfer in the next loop iteration if the socket is ready
+    device_.update();
+
+    return true;
+}
+
+bool IpSocket_Linux::Buffer::cancel() {
+    if (st.state != State::BUSY)
+        return false;
+
+    // do not wait for the transmit timestamp
+    stamping_ = false;
+
+    if (zeroCopy_ && device_.waiting(*this)) {
+        // the buffer gets ready when the kernel has released the memory
+        if (!device_.sends_.empty() && &device_.sends_.front() == this)
+            device_.finish(*this, transferred_);
+        return true;
+    }
+
+    // remove from list of active transfers
+    remove2();
+
+    // cancelled: return the number of bytes sent so far
+    device_.ready(*this, transferred_);
+
+    return true;
+}
+
+} // namespace coco
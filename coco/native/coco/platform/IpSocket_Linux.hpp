@@ -0,0 +1,204 @@
+#pragma once
+
+#include <coco/IpSocket.hpp>
+#include <coco/BufferPool.hpp>
+#include <coco/IntrusiveList.hpp>
+#include <coco/platform/Loop_native.hpp>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+namespace coco {
+
+/// @brief Connection based IP socket on Linux using non-blocking sockets and edge-triggered epoll.
+/// Transfers are started when the event loop reports that the socket is readable or writable.
+/// With zero-copy send enabled, large writes use MSG_ZEROCOPY and the buffer stays busy until the notification on the
+/// error queue of the socket reports that the kernel has released its memory. With timestamps enabled, a write buffer
+/// also waits for its transmit timestamp on the error queue, on a UDP socket at most until a timer (timerfd) expires.
+class IpSocket_Linux : public IpSocket, public Loop_Linux::CompletionHandler {
+public:
+    /// @brief Constructor.
+    /// @param loop event loop
+    /// @param type socket type such as SOCK_STREAM or SOCK_DGRAM
+    /// @param protocol protocol such as IPPROTO_TCP or IPPROTO_UDP
+    IpSocket_Linux(Loop_Linux &loop, int type = SOCK_STREAM, int protocol = IPPROTO_TCP);
+
+    ~IpSocket_Linux() override;
+
+    // TcpSocket methods
+    bool connect(const ip::Endpoint &endpoint, int size = sizeof(ip::Endpoint), int localPort = 0,
+        const Options &options = {}) override;
+    using IpSocket::connect;
+
+    // BufferDevice methods
+    class Buffer;
+    int getBufferCount() override;
+    Buffer &getBuffer(int index) override;
+
+    // Device methods
+    void close() override;
+
+    /// @brief Enable zero-copy send (MSG_ZEROCOPY) for large writes, can be called before or after connect().
+    /// A write buffer stays busy until the kernel has released its memory, i.e. the data was acknowledged by the peer.
+    /// @param threshold minimum size of a write, smaller writes are copied because the notification costs more than
+    /// the copy
+    /// @return true if successful, false if the kernel does not support zero-copy send
+    bool enableZeroCopy(int threshold = 65536);
+
+    /// @brief Get statistics of zero-copy send.
+    /// @return zero-copy statistics
+    const ZeroCopyStatistics &getZeroCopy() const {return zeroCopy_;}
+
+    /// @brief Enable kernel or hardware timestamps (SO_TIMESTAMPING), see Header::timestamp. Can be called before or
+    /// after connect(), a TCP socket gets them when the connection is established.
+    /// A write buffer stays busy until the transmit timestamp of its last byte was reported. On a UDP socket, a
+    /// datagram whose report is missing (e.g. dropped before reaching the network device) finishes without timestamp
+    /// when a later report arrives or after timestamping::TRANSMIT_TIMEOUT.
+    /// @return true if successful, false if the kernel does not support timestamps
+    bool enableTimestamps();
+
+
+    /// @brief Buffer for transferring data to/from a TCP socket.
+    ///
+    class Buffer : public coco::Buffer, public BufferChain, public IntrusiveListNode, public IntrusiveListNode2 {
+        friend class IpSocket_Linux;
+    public:
+        Buffer(IpSocket_Linux &device, int size);
+
+        /// @brief Constructor that takes the memory from a pool.
+        /// @param device socket
+        /// @param pool pool of memory blocks, the capacity is the block size (0 if the pool is exhausted)
+        Buffer(IpSocket_Linux &device, BufferPool &pool);
+
+        /// @brief Constructor that wraps caller-provided memory, e.g. a mmap'd region.
+        /// @param device socket
+        /// @param data memory, has to stay valid until the buffer is destroyed
+        /// @param size size of the memory
+        Buffer(IpSocket_Linux &device, uint8_t *data, int size);
+
+        ~Buffer() override;
+
+        bool start(Op op) override;
+        bool cancel() override;
+
+    protected:
+        IpSocket_Linux &device_;
+
+        // memory is either owned, taken from a pool or provided by the caller
+        BufferPool *pool_ = nullptr;
+        bool ownsData_ = false;
+
+        Header header_ = {};
+        Op op_;
+
+        // number of bytes already sent (TCP may send only a part of the buffer)
+        int transferred_;
+
+        // true if a part of the buffer was sent with zero-copy, then the buffer waits for the notification of the send
+        // with the given sequence number
+        bool zeroCopy_;
+        uint32_t sequence_;
+
+        // true if the buffer waits for the transmit timestamp with the given key (last message or byte), time after
+        // which a UDP buffer finishes without timestamp
+        bool stamping_;
+        uint32_t key_;
+        int64_t deadline_;
+
+        // start time for the statistics
+        uint64_t started_;
+    };
+
+protected:
+    void handle(epoll_event &event) override;
+
+    // request an event from the loop if the socket is ready for a pending transfer
+    void update();
+
+    // transfer as many pending buffers as possible until the socket would block
+    void receive();
+    void send();
+
+    // finish a send, waits until the kernel has released the memory if it was sent with zero-copy
+    void finish(Buffer &buffer, int size);
+
+    // set a buffer ready and update the statistics, a buffer without data counts as finished without packet
+    void ready(Buffer &buffer, int size);
+
+    // count an error in the statistics
+    void fail(int error);
+
+    // enable timestamps on the connected socket
+    void stamp();
+
+    // check if a sent buffer waits for the release of its memory or for its transmit timestamp
+    bool waiting(Buffer &buffer);
+
+    // read the notifications of zero-copy sends and the transmit timestamps from the error queue and finish the
+    // buffers that were released and stamped
+    void release();
+
+    // finish the sent buffers in the order of sending until one still waits
+    void complete();
+
+    // create and destroy the timer for sent UDP buffers whose transmit timestamp is missing
+    bool openTimer();
+    void closeTimer();
+
+    // finish the sent buffers whose transmit timestamp did not arrive in time, start the timer for the next one
+    void expire();
+    void arm();
+
+    // forwards the events of the timer
+    class Timer : public Loop_Linux::CompletionHandler {
+    public:
+        Timer(IpSocket_Linux &socket) : socket_(socket) {}
+        void handle(epoll_event &event) override {socket_.expire();}
+    protected:
+        IpSocket_Linux &socket_;
+    };
+
+    Loop_Linux &loop_;
+    int type_;
+    int protocol_;
+
+    // socket handle
+    int socket_ = -1;
+
+    // readiness of the socket, cleared when an operation would block (edge-triggered epoll)
+    bool readable_ = false;
+    bool writable_ = false;
+
+    // set when epoll was re-armed to report the current readiness in the next loop iteration
+    bool updating_ = false;
+
+    // minimum size of writes that are sent with zero-copy (0 if disabled)
+    int zeroCopyThreshold_ = 0;
+
+    // sequence number of the next zero-copy send and of the first send whose memory was not released yet
+    uint32_t sequence_ = 0;
+    uint32_t released_ = 0;
+
+    // true if timestamps are enabled, key of the next message (UDP) or byte (TCP)
+    bool timestamps_ = false;
+    uint32_t key_ = 0;
+
+    // statistics
+    ZeroCopyStatistics zeroCopy_;
+
+    // list of buffers
+    IntrusiveList<Buffer> buffers_;
+
+    // pending transfers
+    IntrusiveList2<Buffer> receives_;
+    IntrusiveList2<Buffer> sends_;
+
+    // sent buffers waiting until the kernel has released their memory or reported their transmit timestamp, timer
+    // that finishes UDP buffers when their report is missing
+    IntrusiveList2<Buffer> releases_;
+    Timer timer_{*this};
+    int timerFd_ = -1;
+    bool timing_ = false;
+};
+
+} // namespace coco
@@ -1,11 +1,69 @@
 #include "IpSocket_Win32.hpp"
 #include <ws2tcpip.h>
 #include <mswsock.h>
+#include <algorithm>
 #include <iostream>
 
 
 namespace coco {
 
+// get the error class of a Winsock error
+static SocketStatistics::Error classify(int error) {
+    switch (error) {
+    case WSAECONNREFUSED:
+    case WSAEHOSTUNREACH:
+    case WSAENETUNREACH:
+        return SocketStatistics::Error::UNREACHABLE;
+    // connection reset or aborted by the peer
+    case WSAECONNRESET:
+    case WSAECONNABORTED:
+        return SocketStatistics::Error::RESET;
+    case WSAETIMEDOUT:
+        return SocketStatistics::Error::TIMEOUT;
+    case WSAENOBUFS:
+        return SocketStatistics::Error::NO_BUFFERS;
+    case WSAEMSGSIZE:
+        return SocketStatistics::Error::MESSAGE_SIZE;
+    default:
+        return SocketStatistics::Error::OTHER;
+    }
+}
+
+// get a Winsock vector for vectored transfers
+static WSABUF toVector(uint8_t *data, int size) {
+    return {ULONG(size), (CHAR *)data};
+}
+
+// set the options of a socket before it gets connected, options that are not supported are ignored
+static void setOptions(SOCKET socket, int type, const IpSocket::Options &options) {
+    using Flags = IpSocket::Options::Flags;
+
+    // buffer sizes
+    if (options.receiveBufferSize > 0)
+        setsockopt(socket, SOL_SOCKET, SO_RCVBUF, (const char *)&options.receiveBufferSize, sizeof(int));
+    if (options.sendBufferSize > 0)
+        setsockopt(socket, SOL_SOCKET, SO_SNDBUF, (const char *)&options.sendBufferSize, sizeof(int));
+
+    if (type != SOCK_STREAM)
+        return;
+    DWORD one = 1;
+    if ((options.flags & Flags::NO_DELAY) != 0)
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&one, sizeof(one));
+#ifdef TCP_FASTOPEN
+    // Windows 10 1607 and later
+    if ((options.flags & Flags::FAST_OPEN) != 0)
+        setsockopt(socket, IPPROTO_TCP, TCP_FASTOPEN, (const char *)&one, sizeof(one));
+#endif
+#ifdef TCP_MAXRTMS
+    // maximum retransmission time, Windows 10 1703 and later
+    if (options.userTimeout > 0) {
+        DWORD timeout = options.userTimeout;
+        setsockopt(socket, IPPROTO_TCP, TCP_MAXRTMS, (const char *)&timeout, sizeof(timeout));
+    }
+#endif
+    // delayed ACKs can't be disabled per socket (TCP_QUICKACK)
+}
+
 IpSocket_Win32::IpSocket_Win32(Loop_Win32 &loop, int type, int protocol)
     : IpSocket(State::DISABLED)
     , loop_(loop)
@@ -29,7 +87,7 @@ IpSocket_Win32::Buffer &IpSocket_Win32::getBuffer(int index) {
     return buffers_.get(index);
 }
 
-bool IpSocket_Win32::connect(const ip::Endpoint &endpoint, int size, int localPort) {
+bool IpSocket_Win32::connect(const ip::Endpoint &endpoint, int size, int localPort, const Options &options) {
     if (socket_ != INVALID_SOCKET)
         return false;
 
@@ -57,6 +115,9 @@ bool IpSocket_Win32::connect(const ip::Endpoint &endpoint, int size, int localPo
         return false;
     }
 
+    // set options, e.g. TCP Fast Open
+    setOptions(socket, type_, options);
+
     // add socket to completion port of event loop
     Loop_Win32::CompletionHandler *handler = this;
     if (CreateIoCompletionPort(
@@ -92,33 +153,27 @@ bool IpSocket_Win32::connect(const ip::Endpoint &endpoint, int size, int localPo
     } else {
         // get pointer to ConnectEx function
         GUID ConnectExGuid = WSAID_CONNECTEX;
-        LPFN_CONNECTEX ConnectEx = NULL;
         DWORD transferred;
         if (WSAIoctl(socket, SIO_GET_EXTENSION_FUNCTION_POINTER,
             &ConnectExGuid, sizeof(ConnectExGuid),
-            &ConnectEx, sizeof(ConnectEx),
+            &connectEx_, sizeof(connectEx_),
             &transferred, NULL, NULL) != 0)
         {
             int error = WSAGetLastError();
             closesocket(socket);
             return false;
         }
+        socket_ = socket;
 
-        // connect TCP
-        memset(&overlapped_, 0, sizeof(OVERLAPPED));
-        if (ConnectEx(socket, (struct sockaddr *)&endpoint, size,
-            nullptr, 0, // send buffer
-            nullptr, // transferred
-            &overlapped_) == FALSE)
-        {
-            int error = WSAGetLastError();
-            if (error != ERROR_IO_PENDING) {
-                // "real" error
-                closesocket(socket);
-                return false;
-            }
+        // connect TCP, with Fast Open when the first write buffer gets started
+        std::copy((const uint8_t *)&endpoint, (const uint8_t *)&endpoint + size, (uint8_t *)&endpoint_);
+        endpointSize_ = size;
+        fastOpen_ = (options.flags & Options::Flags::FAST_OPEN) != 0;
+        if (!fastOpen_ && !connect(nullptr)) {
+            closesocket(socket);
+            socket_ = INVALID_SOCKET;
+            return false;
         }
-        socket_ = socket;
 
         // set state
         st.set(State::OPENING);
@@ -142,12 +197,16 @@ void IpSocket_Win32::close() {
     // close socket
     closesocket(socket_);
     socket_ = INVALID_SOCKET;
+    fastOpen_ = false;
+    fastOpenBuffer_ = nullptr;
 
     // set state
     st.set(State::DISABLED);
 
     // disable buffers
     for (auto &buffer : buffers_) {
+        if (statistics_ != nullptr && buffer.busy())
+            statistics_->finished();
         buffer.setDisabled();
     }
 
@@ -164,6 +223,8 @@ void IpSocket_Win32::handle(OVERLAPPED *overlapped) {
         if (!result) {
             // "real" error or cancelled (ERROR_OPERATION_ABORTED): close
             auto error = WSAGetLastError();
+            if (statistics_ != nullptr && error != ERROR_OPERATION_ABORTED)
+                statistics_->failed(classify(error));
             close();
         } else {
             setsockopt(socket_, SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, NULL, 0);
@@ -171,36 +232,81 @@ void IpSocket_Win32::handle(OVERLAPPED *overlapped) {
             // set state
             st.set(State::READY);
 
-            // start pending transfers
+            // start pending transfers except the write buffer that was sent with the SYN
+            auto fastOpenBuffer = fastOpenBuffer_;
+            fastOpenBuffer_ = nullptr;
             for (auto &buffer : transfers_) {
-                buffer.start();
+                if (&buffer != fastOpenBuffer)
+                    buffer.start();
             }
 
+            // finish the write buffer that was sent with the SYN after starting the pending transfers, because the
+            // resumed coroutine may start buffers which then start immediately and must not be started again
+            if (fastOpenBuffer != nullptr)
+                fastOpenBuffer->finish(transferred, 0);
+
             // resume all coroutines waiting for state change
             st.notify(Events::ENTER_READY);
         }
     } else {
-        for (auto &buffer : transfers_) {
-            if (overlapped == &buffer.overlapped_) {
-                buffer.handle(overlapped);
-                break;
-            }
+        // the overlapped structure is the first member of Buffer::Overlapped which points back to the buffer
+        auto &buffer = *reinterpret_cast<Buffer::Overlapped *>(overlapped)->buffer;
+        buffer.handle(overlapped);
+    }
+}
+
+bool IpSocket_Win32::connect(Buffer *buffer) {
+    fastOpenBuffer_ = buffer;
+    memset(&overlapped_, 0, sizeof(OVERLAPPED));
+    if (connectEx_(socket_, (sockaddr *)&endpoint_, endpointSize_,
+        buffer != nullptr ? buffer->data_ : nullptr, buffer != nullptr ? buffer->size_ : 0, // send buffer
+        nullptr, // transferred
+        &overlapped_) == FALSE)
+    {
+        int error = WSAGetLastError();
+        if (error != ERROR_IO_PENDING) {
+            // "real" error
+            if (statistics_ != nullptr)
+                statistics_->failed(classify(error));
+            fastOpenBuffer_ = nullptr;
+            return false;
         }
     }
+    return true;
 }
 
 
 // IpSocket_Win32::Buffer
 
 IpSocket_Win32::Buffer::Buffer(IpSocket_Win32 &device, int size)
-    : coco::Buffer(new uint8_t[size], size, device.st.state)
+    : Buffer(device, new uint8_t[size], size)
+{
+    ownsData_ = true;
+}
+
+IpSocket_Win32::Buffer::Buffer(IpSocket_Win32 &device, BufferPool &pool)
+    : Buffer(device, pool.allocate(), pool.blockSize())
+{
+    pool_ = &pool;
+    if (data_ == nullptr)
+        capacity_ = 0;
+}
+
+IpSocket_Win32::Buffer::Buffer(IpSocket_Win32 &device, uint8_t *data, int size)
+    : coco::Buffer(&header_, sizeof(header_), 0, data, size, device.st.state)
     , device_(device)
 {
+    overlapped_.buffer = this;
     device.buffers_.add(*this);
 }
 
 IpSocket_Win32::Buffer::~Buffer() {
-    delete [] data_;
+    if (pool_ != nullptr) {
+        if (data_ != nullptr)
+            pool_->free(data_);
+    } else if (ownsData_) {
+        delete [] data_;
+    }
 }
 
 bool IpSocket_Win32::Buffer::start(Op op) {
@@ -213,16 +319,27 @@ bool IpSocket_Win32::Buffer::start(Op op) {
     assert((op & Op::READ_WRITE) != 0);
 
     op_ = op;
+    chainSize_ = 0;
+
+    if (device_.statistics_ != nullptr)
+        started_ = device_.statistics_->start();
 
     // add to list of pending transfers
     device_.transfers_.add(*this);
 
+    // set state (before starting because a "real" error finishes the transfer immediately)
+    setBusy();
+
     // start if device is ready
-    if (device_.st.state == Device::State::READY)
+    if (device_.st.state == Device::State::READY) {
         start();
-
-    // set state
-    setBusy();
+    } else if (device_.fastOpen_ && (op & Op::WRITE) != 0) {
+        // Fast Open: connect and send the data with the SYN (ConnectEx takes only one vector, therefore a buffer with
+        // a chain is sent after the connection is established)
+        device_.fastOpen_ = false;
+        if (!device_.connect(chain_.empty() ? this : nullptr))
+            device_.close();
+    }
 
     return true;
 }
@@ -231,7 +348,7 @@ bool IpSocket_Win32::Buffer::cancel() {
     if (st.state != State::BUSY)
         return false;
 
-    auto result = CancelIoEx((HANDLE)device_.socket_, &overlapped_);
+    auto result = CancelIoEx((HANDLE)device_.socket_, &overlapped_.overlapped);
     if (!result) {
         auto e = WSAGetLastError();
         std::cerr << "cancel error " << e << std::endl;
@@ -242,24 +359,27 @@ bool IpSocket_Win32::Buffer::cancel() {
 
 void IpSocket_Win32::Buffer::start() {
     // initialize overlapped
-    memset(&overlapped_, 0, sizeof(OVERLAPPED));
+    memset(&overlapped_.overlapped, 0, sizeof(OVERLAPPED));
+
+    // vectors for the buffer and its chain (Winsock captures them before returning)
+    WSABUF vectors[MAX_COUNT + 1];
 
     int result;
     if ((op_ & Op::WRITE) == 0) {
         // receive
-        WSABUF buffer{capacity_, (CHAR*)data_};
+        int count = getVectors(vectors, data_, capacity_, 0, toVector);
         DWORD flags = 0;
-        result = WSARecv(device_.socket_, &buffer, 1, nullptr, &flags, &overlapped_, nullptr);
+        result = WSARecv(device_.socket_, vectors, count, nullptr, &flags, &overlapped_.overlapped, nullptr);
     } else {
         // send
-        WSABUF buffer{size_, (CHAR*)data_};
-        result = WSASend(device_.socket_, &buffer, 1, nullptr, 0, &overlapped_, nullptr);
+        int count = getVectors(vectors, data_, size_, 0, toVector);
+        result = WSASend(device_.socket_, vectors, count, nullptr, 0, &overlapped_.overlapped, nullptr);
     }
     if (result != 0) {
         int error = WSAGetLastError();
         if (error != WSA_IO_PENDING) {
             // "real" error
-            setReady(0);
+            finish(0, error);
         }
     }
 }
@@ -270,15 +390,30 @@ void IpSocket_Win32::Buffer::handle(OVERLAPPED *overlapped) {
     auto result = WSAGetOverlappedResult(device_.socket_, overlapped, &transferred, false, &flags);
     if (!result) {
         // "real" error or cancelled (ERROR_OPERATION_ABORTED): return zero size
-        auto error = WSAGetLastError();
-        transferred = 0;
+        finish(0, WSAGetLastError());
+        return;
     }
 
+    // transfer finished
+    finish(transferred, 0);
+}
+
+void IpSocket_Win32::Buffer::finish(int size, int error) {
     // remove from list of active transfers
     remove2();
 
-    // transfer finished
-    setReady(transferred);
+    auto statistics = device_.statistics_;
+    if (statistics != nullptr) {
+        if (error != 0 && error != ERROR_OPERATION_ABORTED)
+            statistics->failed(classify(error));
+        if (size <= 0)
+            statistics->finished();
+        else if ((op_ & Op::WRITE) == 0)
+            statistics->received(1, size, started_);
+        else
+            statistics->sent(1, size, started_);
+    }
+    setReady(split(size, (op_ & Op::WRITE) == 0 ? capacity_ : size_));
 }
 
 } // namespace coco
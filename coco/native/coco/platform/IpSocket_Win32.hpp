@@ -1,10 +1,12 @@
 #pragma once
 
 #include <coco/IpSocket.hpp>
+#include <coco/BufferPool.hpp>
 #include <coco/IntrusiveList.hpp>
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <winsock2.h> // see https://learn.microsoft.com/en-us/windows/win32/winsock/creating-a-basic-winsock-application
+#include <mswsock.h>
 #include <coco/platform/Loop_native.hpp> // includes Windows.h (after winsock2.h)
 
 
@@ -21,7 +23,8 @@ public:
     ~IpSocket_Win32() override;
 
     // TcpSocket methods
-    bool connect(const ip::Endpoint &endpoint, int size = sizeof(ip::Endpoint), int localPort = 0) override;
+    bool connect(const ip::Endpoint &endpoint, int size = sizeof(ip::Endpoint), int localPort = 0,
+        const Options &options = {}) override;
     using IpSocket::connect;
 
     // BufferDevice methods
@@ -35,10 +38,22 @@ public:
 
     /// @brief Buffer for transferring data to/from a TCP socket.
     ///
-    class Buffer : public coco::Buffer, public IntrusiveListNode, public IntrusiveListNode2 {
+    class Buffer : public coco::Buffer, public BufferChain, public IntrusiveListNode, public IntrusiveListNode2 {
         friend class IpSocket_Win32;
     public:
         Buffer(IpSocket_Win32 &device, int size);
+
+        /// @brief Constructor that takes the memory from a pool.
+        /// @param device socket
+        /// @param pool pool of memory blocks, the capacity is the block size (0 if the pool is exhausted)
+        Buffer(IpSocket_Win32 &device, BufferPool &pool);
+
+        /// @brief Constructor that wraps caller-provided memory, e.g. a mmap'd region.
+        /// @param device socket
+        /// @param data memory, has to stay valid until the buffer is destroyed
+        /// @param size size of the memory
+        Buffer(IpSocket_Win32 &device, uint8_t *data, int size);
+
         ~Buffer() override;
 
         bool start(Op op) override;
@@ -48,14 +63,35 @@ public:
         void start();
         void handle(OVERLAPPED *overlapped);
 
+        // finish the transfer and update the statistics
+        void finish(int size, int error);
+
+        // overlapped structure that points back to the buffer so that a completion maps directly to its buffer
+        struct Overlapped {
+            OVERLAPPED overlapped;
+            Buffer *buffer;
+        };
+
         IpSocket_Win32 &device_;
-        OVERLAPPED overlapped_;
+
+        // memory is either owned, taken from a pool or provided by the caller
+        BufferPool *pool_ = nullptr;
+        bool ownsData_ = false;
+
+        Header header_ = {};
+        Overlapped overlapped_;
         Op op_;
+
+        // start time for the statistics
+        uint64_t started_;
     };
 
 protected:
     void handle(OVERLAPPED *overlapped) override;
 
+    // start ConnectEx, with Fast Open the data of the given write buffer is sent with the SYN
+    bool connect(Buffer *buffer);
+
     Loop_Win32 &loop_;
     int type_;
     int protocol_;
@@ -64,6 +100,15 @@ protected:
     SOCKET socket_ = INVALID_SOCKET;
     OVERLAPPED overlapped_;
 
+    // ConnectEx function and endpoint of the server
+    LPFN_CONNECTEX connectEx_ = nullptr;
+    sockaddr_in6 endpoint_;
+    int endpointSize_;
+
+    // with Fast Open, true while ConnectEx waits for the first write, the write buffer that is sent with the SYN
+    bool fastOpen_ = false;
+    Buffer *fastOpenBuffer_ = nullptr;
+
     // list of buffers
     IntrusiveList<Buffer> buffers_;
 
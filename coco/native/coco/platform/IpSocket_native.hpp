@@ -5,4 +5,14 @@
 namespace coco {
 using IpSocket_native = IpSocket_Win32;
 }
+#elif defined(__linux__) && defined(COCO_IP_IO_URING)
+#include "IpSocket_IoUring.hpp"
+namespace coco {
+using IpSocket_native = IpSocket_IoUring;
+}
+#elif defined(__linux__)
+#include "IpSocket_Linux.hpp"
+namespace coco {
+using IpSocket_native = IpSocket_Linux;
+}
 #endif
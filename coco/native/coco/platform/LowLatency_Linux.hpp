@@ -0,0 +1,64 @@
+#pragma once
+
+#include <coco/Coroutine.hpp>
+#include <coco/platform/Loop_native.hpp>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <cstdint>
+
+
+namespace coco {
+
+/// @brief Helpers for a low-latency mode of an event loop on Linux, where the loop thread trades CPU time for wakeup
+/// latency: Pin the loop thread to a CPU that is isolated from other work, let the loop busy poll the network devices
+/// of its sockets before it goes to sleep and enable busy polling on the sockets (see UdpSocket::setBusyPoll() and
+/// IpSocket::Options::busyPollTime). On a dedicated CPU, spin() keeps the loop from sleeping at all.
+namespace lowLatency {
+
+// parameters of epoll busy polling (struct epoll_params of linux/eventpoll.h, Linux 6.9) which can't be included
+// together with sys/epoll.h
+struct EpollParams {
+    uint32_t busyPollTime;
+    uint16_t busyPollBudget;
+    uint8_t preferBusyPoll;
+    uint8_t pad;
+};
+constexpr unsigned long EPOLL_SET_PARAMS = _IOW(0x8A, 0x01, EpollParams);
+
+/// @brief Let the loop busy poll the network devices of its sockets for a while before it goes to sleep when it
+/// waits for events (epoll busy polling, Linux 6.9). Only has an effect for network devices that support NAPI, not
+/// e.g. on loopback.
+/// @param loop event loop
+/// @param time time in microseconds to poll before sleeping, 0 to disable
+/// @param budget maximum number of packets per poll, more than 64 requires CAP_NET_ADMIN
+/// @return true if successful
+inline bool setBusyPoll(Loop_Linux &loop, int time, int budget = 8) {
+    EpollParams params = {.busyPollTime = uint32_t(time), .busyPollBudget = uint16_t(budget),
+        .preferBusyPoll = uint8_t(time > 0)};
+    return ioctl(loop.epollQueue, EPOLL_SET_PARAMS, &params) == 0;
+}
+
+/// @brief Pin the calling thread, e.g. the thread that runs an event loop, to a CPU.
+/// @param cpu index of the CPU
+/// @return true if successful
+inline bool pinThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/// @brief Keep the loop from sleeping: The coroutine yields in every iteration, therefore the loop polls for events
+/// without waiting and resumes a coroutine as soon as its buffer has completed. Uses one CPU completely, therefore pin
+/// the loop thread with pinThread(). Returns in the first loop iteration after running was cleared.
+/// @param loop event loop
+/// @param running flag that keeps the loop spinning while set
+inline Coroutine spin(Loop &loop, const bool &running) {
+    while (running) {
+        co_await loop.yield();
+    }
+}
+
+} // namespace lowLatency
+} // namespace coco
@@ -0,0 +1,399 @@
+#include "PacketSocket_Linux.hpp"
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+
+namespace coco {
+
+// offset of the link layer address and of the data to send in a frame of the rings
+constexpr int FRAME_HEADER_SIZE = TPACKET_ALIGN(sizeof(tpacket3_hdr));
+
+// the status words of blocks and frames are shared with the kernel
+static uint32_t loadStatus(uint32_t &status) {
+    return std::atomic_ref<uint32_t>(status).load(std::memory_order_acquire);
+}
+
+static void storeStatus(uint32_t &status, uint32_t value) {
+    std::atomic_ref<uint32_t>(status).store(value, std::memory_order_release);
+}
+
+PacketSocket_Linux::PacketSocket_Linux(Loop_Linux &loop)
+    : BufferDevice(State::DISABLED)
+    , loop_(loop)
+{
+}
+
+PacketSocket_Linux::~PacketSocket_Linux() {
+    if (socket_ != -1) {
+        munmap(ring_, ringSize_);
+        ::close(socket_);
+    }
+}
+
+bool PacketSocket_Linux::open(int interfaceIndex, const Config &config) {
+    if (socket_ != -1)
+        return false;
+
+    // create non-blocking socket that receives nothing until it is bound
+    int socket = ::socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (socket == -1)
+        return false;
+
+    int version = TPACKET_V3;
+    int one = 1;
+    if (setsockopt(socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) == -1
+        || (config.ignoreOutgoing && setsockopt(socket, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one)) == -1))
+    {
+        ::close(socket);
+        return false;
+    }
+
+    // receive ring
+    tpacket_req3 receiveRing = {
+        .tp_block_size = unsigned(config.blockSize),
+        .tp_block_nr = unsigned(config.blockCount),
+        .tp_frame_size = unsigned(config.frameSize),
+        .tp_frame_nr = unsigned(config.blockSize / config.frameSize * config.blockCount),
+        .tp_retire_blk_tov = unsigned(config.blockTimeout)};
+    if (setsockopt(socket, SOL_PACKET, PACKET_RX_RING, &receiveRing, sizeof(receiveRing)) == -1) {
+        ::close(socket);
+        return false;
+    }
+    size_t receiveSize = size_t(config.blockSize) * config.blockCount;
+
+    // send ring with blocks of whole pages, a frame must not cross a block
+    tpacket_req3 sendRing = {};
+    if (config.frameCount > 0) {
+        int pageSize = getpagesize();
+        int blockSize = (config.frameSize + pageSize - 1) / pageSize * pageSize;
+        int framesPerBlock = blockSize / config.frameSize;
+        int blockCount = (config.frameCount + framesPerBlock - 1) / framesPerBlock;
+        sendRing.tp_block_size = blockSize;
+        sendRing.tp_block_nr = blockCount;
+        sendRing.tp_frame_size = config.frameSize;
+        sendRing.tp_frame_nr = framesPerBlock * blockCount;
+        if (setsockopt(socket, SOL_PACKET, PACKET_TX_RING, &sendRing, sizeof(sendRing)) == -1) {
+            ::close(socket);
+            return false;
+        }
+    }
+    size_t sendSize = size_t(sendRing.tp_block_size) * sendRing.tp_block_nr;
+
+    // map both rings
+    void *ring = mmap(nullptr, receiveSize + sendSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, socket, 0);
+    if (ring == MAP_FAILED) {
+        ::close(socket);
+        return false;
+    }
+
+    // bind to the interface, capturing starts now
+    sockaddr_ll address = {.sll_family = AF_PACKET, .sll_protocol = htons(ETH_P_ALL), .sll_ifindex = interfaceIndex};
+    packet_mreq membership = {.mr_ifindex = interfaceIndex, .mr_type = PACKET_MR_PROMISC};
+    if (bind(socket, (struct sockaddr *)&address, sizeof(address)) == -1
+        || (config.promiscuous
+            && setsockopt(socket, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership)) == -1))
+    {
+        munmap(ring, receiveSize + sendSize);
+        ::close(socket);
+        return false;
+    }
+
+    // add socket to epoll of event loop (edge-triggered), the kernel signals handed over blocks and sent frames
+    Loop_Linux::CompletionHandler *handler = this;
+    epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLET, .data = {.ptr = handler}};
+    if (epoll_ctl(loop_.epollQueue, EPOLL_CTL_ADD, socket, &event) == -1) {
+        munmap(ring, receiveSize + sendSize);
+        ::close(socket);
+        return false;
+    }
+    socket_ = socket;
+    updating_ = true;
+
+    ring_ = (uint8_t *)ring;
+    ringSize_ = receiveSize + sendSize;
+    blockCount_ = config.blockCount;
+    blockSize_ = config.blockSize;
+    references_.assign(blockCount_, 0);
+    block_ = 0;
+    frameCount_ = 0;
+
+    sendRing_ = ring_ + receiveSize;
+    sendBlockSize_ = sendRing.tp_block_size;
+    framesPerBlock_ = sendRing.tp_block_nr > 0 ? sendRing.tp_frame_nr / sendRing.tp_block_nr : 0;
+    sendFrameCount_ = sendRing.tp_frame_nr;
+    sendFrameSize_ = config.frameSize;
+    sendIndex_ = 0;
+    sendPending_ = false;
+
+    // set state
+    st.set(State::READY);
+
+    // enable buffers
+    for (auto &buffer : buffers_) {
+        buffer.setReady(0);
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_OPENING | Events::ENTER_READY);
+
+    return true;
+}
+
+PacketSocket_Linux::Statistics PacketSocket_Linux::getStatistics() {
+    tpacket_stats_v3 stats = {};
+    socklen_t size = sizeof(stats);
+    if (socket_ == -1 || getsockopt(socket_, SOL_PACKET, PACKET_STATISTICS, &stats, &size) == -1)
+        return {};
+    return {stats.tp_packets, stats.tp_drops, stats.tp_freeze_q_cnt};
+}
+
+int PacketSocket_Linux::getBufferCount() {
+    return buffers_.count();
+}
+
+PacketSocket_Linux::Buffer &PacketSocket_Linux::getBuffer(int index) {
+    return buffers_.get(index);
+}
+
+void PacketSocket_Linux::close() {
+    if (socket_ == -1)
+        return;
+
+    // point the buffers back to their own memory before the rings get unmapped
+    for (auto &buffer : buffers_) {
+        buffer.block_ = -1;
+        buffer.data_ = buffer.memory_;
+        buffer.capacity_ = buffer.memorySize_;
+    }
+    munmap(ring_, ringSize_);
+    ring_ = nullptr;
+
+    // close socket (also removes it from epoll)
+    ::close(socket_);
+    socket_ = -1;
+
+    // drop pending transfers
+    while (!receives_.empty())
+        receives_.front().remove2();
+    while (!sends_.empty())
+        sends_.front().remove2();
+
+    // set state
+    st.set(State::DISABLED);
+
+    // disable buffers
+    for (auto &buffer : buffers_) {
+        buffer.setDisabled();
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_CLOSING | Events::ENTER_DISABLED);
+}
+
+void PacketSocket_Linux::handle(epoll_event &event) {
+    updating_ = false;
+
+    // the ownership of blocks and frames is checked in the rings, the event only tells that it may have changed
+    receive();
+    send();
+}
+
+void PacketSocket_Linux::update() {
+    if (updating_ || socket_ == -1)
+        return;
+    if ((!receives_.empty() && receiveReady()) || (!sends_.empty() && (sendReady() || sendPending_))) {
+        // modifying an edge-triggered file descriptor reports its current readiness again
+        Loop_Linux::CompletionHandler *handler = this;
+        epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLET, .data = {.ptr = handler}};
+        epoll_ctl(loop_.epollQueue, EPOLL_CTL_MOD, socket_, &event);
+        updating_ = true;
+    }
+}
+
+bool PacketSocket_Linux::receiveReady() {
+    if (frameCount_ > 0)
+        return true;
+    auto &block = *(tpacket_block_desc *)(ring_ + size_t(block_) * blockSize_);
+    return (loadStatus(block.hdr.bh1.block_status) & TP_STATUS_USER) != 0;
+}
+
+bool PacketSocket_Linux::sendReady() {
+    if (sendFrameCount_ == 0)
+        return false;
+    auto frame = sendRing_ + size_t(sendIndex_ / framesPerBlock_) * sendBlockSize_
+        + (sendIndex_ % framesPerBlock_) * sendFrameSize_;
+    return loadStatus(((tpacket3_hdr *)frame)->tp_status) == TP_STATUS_AVAILABLE;
+}
+
+void PacketSocket_Linux::receive() {
+    while (!receives_.empty()) {
+        if (frameCount_ == 0) {
+            // check if the kernel has handed over the next block
+            auto &block = *(tpacket_block_desc *)(ring_ + size_t(block_) * blockSize_);
+            if ((loadStatus(block.hdr.bh1.block_status) & TP_STATUS_USER) == 0)
+                break;
+            frameCount_ = block.hdr.bh1.num_pkts;
+            frame_ = (uint8_t *)&block + block.hdr.bh1.offset_to_first_pkt;
+            if (frameCount_ == 0) {
+                // empty block
+                storeStatus(block.hdr.bh1.block_status, TP_STATUS_KERNEL);
+                block_ = block_ + 1 == blockCount_ ? 0 : block_ + 1;
+                continue;
+            }
+        }
+
+        // deliver the next frame of the current block
+        auto &buffer = receives_.front();
+        auto &frame = *(tpacket3_hdr *)frame_;
+        auto &address = *(sockaddr_ll *)(frame_ + FRAME_HEADER_SIZE);
+        buffer.data_ = frame_ + frame.tp_mac;
+        buffer.capacity_ = frame.tp_snaplen;
+        buffer.block_ = block_;
+        buffer.header_ = {
+            .interfaceIndex = address.sll_ifindex,
+            .protocol = ntohs(address.sll_protocol),
+            .packetType = address.sll_pkttype,
+            .length = int(frame.tp_len),
+            .timestamp = uint64_t(frame.tp_sec) * 1000000000 + frame.tp_nsec};
+        ++references_[block_];
+
+        // advance to the next frame, the block returns to the kernel when the buffers have released all its frames
+        frame_ += frame.tp_next_offset;
+        if (--frameCount_ == 0)
+            block_ = block_ + 1 == blockCount_ ? 0 : block_ + 1;
+
+        // remove from list of active transfers
+        buffer.remove2();
+
+        // transfer finished (may resume a coroutine that closes the socket)
+        buffer.setReady(frame.tp_snaplen);
+        if (socket_ == -1)
+            return;
+    }
+}
+
+void PacketSocket_Linux::send() {
+    int count = 0;
+    while (!sends_.empty() && sendReady()) {
+        auto &buffer = sends_.front();
+        buffer.remove2();
+
+        // check if the frame fits into a frame of the send ring
+        int size = buffer.size_;
+        if (size > sendFrameSize_ - FRAME_HEADER_SIZE) {
+            buffer.release();
+            buffer.setReady(0);
+            continue;
+        }
+
+        // copy into the send ring and hand the frame over to the kernel
+        auto frame = sendRing_ + size_t(sendIndex_ / framesPerBlock_) * sendBlockSize_
+            + (sendIndex_ % framesPerBlock_) * sendFrameSize_;
+        auto &header = *(tpacket3_hdr *)frame;
+        std::memcpy(frame + FRAME_HEADER_SIZE, buffer.data_, size);
+        header.tp_next_offset = 0;
+        header.tp_len = size;
+        header.tp_snaplen = size;
+        storeStatus(header.tp_status, TP_STATUS_SEND_REQUEST);
+        sendIndex_ = sendIndex_ + 1 == sendFrameCount_ ? 0 : sendIndex_ + 1;
+        ++count;
+
+        // transfer finished, the frame was copied
+        buffer.release();
+        buffer.setReady(size);
+        if (socket_ == -1)
+            return;
+    }
+
+    // let the kernel send all frames that were handed over, also those that it could not send last time
+    if (count > 0 || sendPending_) {
+        int result = ::send(socket_, nullptr, 0, MSG_DONTWAIT);
+
+        // retry when the kernel signals free space (e.g. on ENOBUFS when the queue of the device is full)
+        sendPending_ = result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS);
+    }
+}
+
+void PacketSocket_Linux::release(int block) {
+    if (--references_[block] > 0)
+        return;
+
+    // return the block to the kernel unless it is the current block and still has frames to deliver
+    if (block == block_ && frameCount_ > 0)
+        return;
+    auto &desc = *(tpacket_block_desc *)(ring_ + size_t(block) * blockSize_);
+    storeStatus(desc.hdr.bh1.block_status, TP_STATUS_KERNEL);
+}
+
+
+// PacketSocket_Linux::Buffer
+
+PacketSocket_Linux::Buffer::Buffer(PacketSocket_Linux &device, int size)
+    : coco::Buffer(&header_, sizeof(header_), 0, size > 0 ? new uint8_t[size] : nullptr, size, device.st.state)
+    , device_(device), memory_(data_), memorySize_(size)
+{
+    device.buffers_.add(*this);
+}
+
+PacketSocket_Linux::Buffer::~Buffer() {
+    if (device_.socket_ != -1)
+        release();
+    delete [] memory_;
+}
+
+bool PacketSocket_Linux::Buffer::start(Op op) {
+    if (st.state != State::READY) {
+        assert(st.state != State::BUSY);
+        return false;
+    }
+
+    // check if READ or WRITE flag is set
+    assert((op & Op::READ_WRITE) != 0);
+
+    // add to list of pending transfers, a write keeps its frame until it is copied into the send ring
+    if ((op & Op::WRITE) == 0) {
+        release();
+        device_.receives_.add(*this);
+    } else {
+        device_.sends_.add(*this);
+    }
+
+    // set state
+    setBusy();
+
+    // transfer in the next loop iteration if the rings are ready
+    device_.update();
+
+    return true;
+}
+
+bool PacketSocket_Linux::Buffer::cancel() {
+    if (st.state != State::BUSY)
+        return false;
+
+    // remove from list of active transfers
+    remove2();
+
+    // cancelled: return zero size
+    setReady(0);
+
+    return true;
+}
+
+void PacketSocket_Linux::Buffer::release() {
+    if (block_ == -1)
+        return;
+    device_.release(block_);
+    block_ = -1;
+    data_ = memory_;
+    capacity_ = memorySize_;
+}
+
+} // namespace coco
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <coco/BufferDevice.hpp>
+#include <coco/IntrusiveList.hpp>
+#include <coco/platform/Loop_native.hpp>
+#include <cstdint>
+#include <vector>
+
+
+namespace coco {
+
+/// @brief Packet socket on Linux (AF_PACKET) that captures and injects link layer frames through memory-mapped
+/// TPACKET_V3 rings, e.g. for monitoring all traffic of a network interface.
+/// The kernel writes received frames into blocks of the receive ring and hands over a block when it is full or when
+/// the block timeout expires. A read buffer then gets pointed directly at the next frame in the ring, there is no
+/// system call and no copy per frame. The frame stays valid until the buffer is started again, cancelled or
+/// destroyed; a block returns to the kernel when all its frames were delivered and released. Buffers that hold frames
+/// for a long time therefore stall the ring and the kernel drops frames (see getStatistics()).
+///
+/// Write buffers are copied into the next free frame of the send ring. All buffers started in the same loop iteration
+/// get sent by one send() call. A received frame can be forwarded by starting the buffer with Op::WRITE without
+/// copying it into the buffer first.
+/// Needs CAP_NET_RAW.
+class PacketSocket_Linux : public BufferDevice, public Loop_Linux::CompletionHandler {
+public:
+    /// @brief Configuration of the rings
+    ///
+    struct Config {
+        // number and size of the blocks of the receive ring, the block size must be a multiple of the page size and
+        // limits the size of a received frame
+        int blockCount = 64;
+        int blockSize = 1 << 18;
+
+        // time in milliseconds after which the kernel hands over a block that is not full, 0 for a default timeout
+        // that the kernel derives from the link speed
+        int blockTimeout = 1;
+
+        // number and size of the frames of the send ring, 0 frames to only capture. The frame size must be a
+        // multiple of 16 and includes a header of 48 bytes
+        int frameCount = 256;
+        int frameSize = 2048;
+
+        // receive frames that are not addressed to this host
+        bool promiscuous = false;
+
+        // do not capture outgoing frames, including the frames sent by this socket
+        bool ignoreOutgoing = false;
+    };
+
+    /// @brief Header of a buffer, set when a frame is received
+    ///
+    struct Header {
+        // index of the network interface
+        int interfaceIndex;
+
+        // link layer protocol, e.g. ETH_P_IP
+        uint16_t protocol;
+
+        // PACKET_HOST, PACKET_BROADCAST, PACKET_MULTICAST, PACKET_OTHERHOST or PACKET_OUTGOING
+        uint8_t packetType;
+
+        // length of the frame on the wire, greater than the buffer size if the frame was truncated
+        int length;
+
+        // receive time in nanoseconds since the epoch (CLOCK_REALTIME)
+        uint64_t timestamp;
+    };
+
+    /// @brief Statistics of the receive ring, see PACKET_STATISTICS
+    ///
+    struct Statistics {
+        // number of received and dropped frames since the last call to getStatistics()
+        uint32_t packets;
+        uint32_t drops;
+
+        // number of times the ring was full
+        uint32_t freezes;
+    };
+
+    /// @brief Constructor.
+    /// @param loop event loop
+    PacketSocket_Linux(Loop_Linux &loop);
+
+    ~PacketSocket_Linux() override;
+
+    /// @brief Open the socket, map the rings and bind to a network interface.
+    /// @param interfaceIndex index of the network interface, e.g. if_nametoindex("lo"), or 0 for all interfaces
+    /// @param config configuration of the rings
+    /// @return true if successful
+    bool open(int interfaceIndex, const Config &config);
+    bool open(int interfaceIndex) {return open(interfaceIndex, Config());}
+
+    /// @brief Get statistics of the receive ring and reset them.
+    /// @return statistics
+    Statistics getStatistics();
+
+    // BufferDevice methods
+    class Buffer;
+    int getBufferCount() override;
+    Buffer &getBuffer(int index) override;
+
+    // Device methods
+    void close() override;
+
+
+    /// @brief Buffer for receiving frames from the ring and for sending frames.
+    ///
+    class Buffer : public coco::Buffer, public IntrusiveListNode, public IntrusiveListNode2 {
+        friend class PacketSocket_Linux;
+    public:
+        /// @brief Constructor.
+        /// @param device packet socket
+        /// @param size size of own memory for frames to send, 0 for a buffer that only receives or forwards
+        Buffer(PacketSocket_Linux &device, int size = 0);
+
+        ~Buffer() override;
+
+        // Buffer methods
+        bool start(Op op) override;
+        bool cancel() override;
+
+    protected:
+        // return the frame to the ring and point the buffer to its own memory again
+        void release();
+
+        PacketSocket_Linux &device_;
+
+        // own memory
+        uint8_t *memory_;
+        int memorySize_;
+
+        // block of the receive ring that contains the frame, -1 if the buffer points to its own memory
+        int block_ = -1;
+
+        Header header_ = {};
+    };
+
+protected:
+    void handle(epoll_event &event) override;
+
+    // request an event from the loop if the rings are ready for a pending transfer
+    void update();
+
+    // check if the next block of the receive ring or the next frame of the send ring is owned by user space
+    bool receiveReady();
+    bool sendReady();
+
+    // transfer as many pending buffers as the rings allow
+    void receive();
+    void send();
+
+    // release a reference to a block of the receive ring, returns it to the kernel if it is not referenced anymore
+    void release(int block);
+
+    Loop_Linux &loop_;
+
+    // socket handle
+    int socket_ = -1;
+
+    // set when epoll was re-armed to report the current readiness in the next loop iteration
+    bool updating_ = false;
+
+    // mapped rings, the send ring follows the receive ring
+    uint8_t *ring_ = nullptr;
+    size_t ringSize_ = 0;
+
+    // receive ring
+    int blockCount_;
+    int blockSize_;
+    std::vector<int> references_;
+
+    // current block and next frame in the current block, frameCount_ is 0 if the block is not handed over yet
+    int block_ = 0;
+    uint8_t *frame_;
+    int frameCount_ = 0;
+
+    // send ring
+    uint8_t *sendRing_;
+    int framesPerBlock_;
+    int sendBlockSize_;
+    int sendFrameCount_ = 0;
+    int sendFrameSize_;
+    int sendIndex_ = 0;
+
+    // frames were queued but the kernel could not send all of them
+    bool sendPending_ = false;
+
+    // list of buffers
+    IntrusiveList<Buffer> buffers_;
+
+    // pending transfers
+    IntrusiveList2<Buffer> receives_;
+    IntrusiveList2<Buffer> sends_;
+};
+
+} // namespace coco
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <coco/IpSocket.hpp>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+
+namespace coco {
+
+// endpoints are passed to the socket API unchanged
+static_assert(ip::v4::PROTOCOL_ID == AF_INET && ip::v6::PROTOCOL_ID == AF_INET6);
+
+/// @brief Helpers for the options of UDP and IP sockets (see IpSocket::Options) on Linux.
+///
+namespace socketOptions {
+
+/// @brief Enable busy polling of the device queue when the socket receives (SO_BUSY_POLL) and prefer busy polling over
+/// interrupts for the device queue (SO_PREFER_BUSY_POLL, Linux 5.11). Only has an effect if the network device
+/// supports NAPI, not e.g. on loopback. A time greater than /proc/sys/net/core/busy_read requires CAP_NET_ADMIN.
+/// @param socket socket handle
+/// @param time time in microseconds to poll before waiting, 0 does nothing
+/// @return true if busy polling was enabled
+inline bool setBusyPoll(int socket, int time) {
+    if (time <= 0)
+        return false;
+    if (setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &time, sizeof(time)) == -1)
+        return false;
+#ifdef SO_PREFER_BUSY_POLL
+    int one = 1;
+    setsockopt(socket, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one));
+#endif
+    return true;
+}
+
+/// @brief Set the options on a socket before it gets connected. Options that the kernel does not support are ignored.
+/// With IpSocket::Options::Flags::FAST_OPEN, connect() succeeds immediately without sending the SYN and the first
+/// send carries the data with the SYN (TCP_FASTOPEN_CONNECT, Linux 4.11). Fast Open also has to be enabled for
+/// clients in /proc/sys/net/ipv4/tcp_fastopen (bit 0, enabled by default).
+/// @param socket socket handle
+/// @param type socket type, the TCP options are only set for SOCK_STREAM
+/// @param options options
+inline void set(int socket, int type, const IpSocket::Options &options) {
+    using Flags = IpSocket::Options::Flags;
+
+    // buffer sizes (before connecting, the receive buffer size determines the window scale of TCP)
+    if (options.receiveBufferSize > 0)
+        setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &options.receiveBufferSize, sizeof(int));
+    if (options.sendBufferSize > 0)
+        setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &options.sendBufferSize, sizeof(int));
+
+    setBusyPoll(socket, options.busyPollTime);
+
+    if (type != SOCK_STREAM)
+        return;
+    int one = 1;
+    if ((options.flags & Flags::NO_DELAY) != 0)
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if ((options.flags & Flags::QUICK_ACK) != 0)
+        setsockopt(socket, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+    if ((options.flags & Flags::FAST_OPEN) != 0)
+        setsockopt(socket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &one, sizeof(one));
+    if (options.userTimeout > 0)
+        setsockopt(socket, IPPROTO_TCP, TCP_USER_TIMEOUT, &options.userTimeout, sizeof(int));
+}
+
+} // namespace socketOptions
+} // namespace coco
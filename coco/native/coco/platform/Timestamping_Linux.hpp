@@ -0,0 +1,108 @@
+#pragma once
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+
+
+namespace coco {
+
+/// @brief Helpers for kernel and hardware timestamps of sockets (SO_TIMESTAMPING) on Linux.
+/// Received data carries its timestamp in a control message. Transmit timestamps are reported on the error queue of
+/// the socket with a key that counts the sent messages (UDP) or bytes (TCP) since timestamping was enabled.
+/// Hardware timestamps are used when the network device supports them and timestamping is enabled on the device
+/// (SIOCSHWTSTAMP, e.g. with hwstamp_ctl), otherwise software timestamps taken by the kernel.
+namespace timestamping {
+
+/// @brief Space for the control message that carries the timestamps of received data
+constexpr int CONTROL_SIZE = CMSG_SPACE(sizeof(scm_timestamping));
+
+/// @brief Time in nanoseconds that a sent datagram waits for its transmit timestamp. The kernel reports nothing for a
+/// datagram that was dropped before it reached the network device (e.g. by the queueing discipline)
+constexpr int64_t TRANSMIT_TIMEOUT = 100000000;
+
+/// @brief Get the time of the monotonic clock, the clock of the transmit timeout.
+/// @return time in nanoseconds
+inline int64_t now() {
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return int64_t(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+/// @brief Enable timestamps on a socket. A TCP socket must be connected.
+/// @param socket socket handle
+/// @return true if successful
+inline bool enable(int socket) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE
+        | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_TX_HARDWARE
+        | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RAW_HARDWARE
+        | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    return setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+}
+
+// convert the hardware timestamp if present, else the software timestamp to nanoseconds
+inline uint64_t toNanoseconds(const scm_timestamping &t) {
+    auto &ts = (t.ts[2].tv_sec != 0 || t.ts[2].tv_nsec != 0) ? t.ts[2] : t.ts[0];
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/// @brief Get the timestamp of received data.
+/// @param message message with the control data from recvmsg()
+/// @return time in nanoseconds since the epoch (CLOCK_REALTIME), 0 if the message has no timestamp
+inline uint64_t get(const msghdr &message) {
+    for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR((msghdr *)&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+            return toNanoseconds(*(scm_timestamping *)CMSG_DATA(cmsg));
+    }
+    return 0;
+}
+
+/// @brief Get a transmit timestamp from a message that was read from the error queue.
+/// @param message message with the control data from recvmsg() with MSG_ERRQUEUE
+/// @param key key of the last message (UDP) or byte (TCP) that was sent when the timestamp was taken
+/// @param timestamp time in nanoseconds since the epoch (CLOCK_REALTIME)
+/// @return true if the message reports that the data was handed to the network device
+inline bool getTransmit(const msghdr &message, uint32_t &key, uint64_t &timestamp) {
+    bool found = false;
+    timestamp = 0;
+    for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR((msghdr *)&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            timestamp = toNanoseconds(*(scm_timestamping *)CMSG_DATA(cmsg));
+        } else if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+            || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+        {
+            auto &error = *(sock_extended_err *)CMSG_DATA(cmsg);
+            if (error.ee_errno == ENOMSG && error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING
+                && error.ee_info == SCM_TSTAMP_SND)
+            {
+                key = error.ee_data;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+/// @brief Read all transmit timestamps from the error queue of a socket.
+/// @param socket socket handle
+/// @param function function that gets called with key and timestamp of each transmit timestamp
+template <typename F>
+void readTransmit(int socket, F &&function) {
+    alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(scm_timestamping))
+        + CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+    msghdr message = {.msg_control = control, .msg_controllen = sizeof(control)};
+    while (recvmsg(socket, &message, MSG_ERRQUEUE | MSG_DONTWAIT) != -1) {
+        uint32_t key;
+        uint64_t timestamp;
+        if (getTransmit(message, key, timestamp))
+            function(key, timestamp);
+        message.msg_controllen = sizeof(control);
+    }
+}
+
+} // namespace timestamping
+} // namespace coco
@@ -0,0 +1,72 @@
+#include "UdpSocketGroup_Linux.hpp"
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <iterator>
+
+
+namespace coco {
+
+UdpSocketGroup_Linux::UdpSocketGroup_Linux(std::span<Loop_Linux * const> loops) {
+    for (auto loop : loops) {
+        sockets_.push_back(std::make_unique<UdpSocket_native>(*loop));
+    }
+}
+
+UdpSocketGroup_Linux::~UdpSocketGroup_Linux() {
+}
+
+bool UdpSocketGroup_Linux::open(uint16_t protocolId, int localPort, Flags flags, UdpSocket::Flags socketFlags) {
+    bool steer = (flags & Flags::STEER_BY_CPU) != 0;
+    int port = localPort;
+    for (int i = 0; i < size(); ++i) {
+        auto &socket = *sockets_[i];
+        if (!socket.open(protocolId, port, socketFlags | UdpSocket::Flags::REUSE_PORT)) {
+            close();
+            return false;
+        }
+
+        // the other sockets use the port that was chosen for the first socket
+        if (port == 0) {
+            sockaddr_in6 address = {};
+            socklen_t size = sizeof(address);
+            getsockname(socket.socket_, (sockaddr *)&address, &size);
+            port = ntohs(address.sin6_port);
+        }
+
+        // the worker of socket i is expected to run on CPU i
+        if (steer) {
+            int cpu = i;
+            if (setsockopt(socket.socket_, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1) {
+                close();
+                return false;
+            }
+        }
+    }
+    localPort_ = port;
+
+    if (steer && size() > 0) {
+        // the program returns the index of the socket in the group, the sockets are in the order in which they were bound
+        sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, uint32_t(SKF_AD_OFF + SKF_AD_CPU)},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, uint32_t(size())},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+        sock_fprog program = {.len = std::size(code), .filter = code};
+        if (setsockopt(sockets_[0]->socket_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1) {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void UdpSocketGroup_Linux::close() {
+    for (auto &socket : sockets_) {
+        socket->close();
+    }
+    localPort_ = 0;
+}
+
+} // namespace coco
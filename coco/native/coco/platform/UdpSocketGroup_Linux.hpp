@@ -0,0 +1,81 @@
+#pragma once
+
+#include <coco/enum.hpp>
+#include <coco/platform/UdpSocket_native.hpp>
+#include <memory>
+#include <span>
+#include <vector>
+
+
+namespace coco {
+
+/// @brief Group of UDP sockets on Linux that share one local port using SO_REUSEPORT.
+/// There is one socket per event loop so that each worker thread with its own loop receives a share of the datagrams.
+/// By default the kernel selects the socket by a hash of the sender endpoint. With Flags::STEER_BY_CPU a classic BPF
+/// program selects the socket by the CPU that received the datagram, so the datagram stays on its CPU if the worker
+/// thread of socket i runs on CPU i.
+class UdpSocketGroup_Linux {
+public:
+    /// @brief Flags for opening the group
+    ///
+    enum class Flags {
+        NONE = 0,
+
+        /// @brief Select the socket by the CPU that received the datagram (socket index is CPU modulo socket count)
+        STEER_BY_CPU = 1,
+    };
+
+    /// @brief Constructor.
+    /// @param loops event loops, one per worker thread
+    UdpSocketGroup_Linux(std::span<Loop_Linux * const> loops);
+
+    ~UdpSocketGroup_Linux();
+
+    /// @brief Get the number of sockets.
+    /// @return number of sockets
+    int size() const {return int(sockets_.size());}
+
+    /// @brief Get the socket of a worker.
+    /// @param index index of the event loop that was passed to the constructor
+    /// @return socket
+    UdpSocket_native &operator [](int index) {return *sockets_[index];}
+
+    /// @brief Open all sockets on the same local port.
+    /// The sockets get opened from the calling thread, therefore call before the event loops run.
+    /// @param protocolId Protocol id such as ip::v4::PROTOCOL_ID or ip::v6::PROTOCOL_ID
+    /// @param localPort Local port number (0 = any, all sockets use the port that gets chosen for the first socket)
+    /// @param flags Flags such as Flags::STEER_BY_CPU
+    /// @param socketFlags Flags for opening the sockets such as UdpSocket::Flags::GRO
+    /// @return true if successful
+    bool open(uint16_t protocolId, int localPort, Flags flags = Flags::NONE,
+        UdpSocket::Flags socketFlags = UdpSocket::Flags::NONE);
+
+    /// @brief Close all sockets.
+    ///
+    void close();
+
+    /// @brief Filter the received datagrams of all sockets by the address of the sender.
+    /// @param accessList Access list, has to stay valid while it is set, nullptr to receive from all senders
+    void setAccessList(const ip::AccessList *accessList) {
+        for (auto &socket : sockets_)
+            socket->setAccessList(accessList);
+    }
+
+    /// @brief Busy poll the network device when the sockets receive, set before opening the group.
+    /// @param time Time in microseconds to poll before waiting, 0 to disable
+    void setBusyPoll(int time) {
+        for (auto &socket : sockets_)
+            socket->setBusyPoll(time);
+    }
+
+    /// @brief Get the local port after the group was opened.
+    /// @return local port
+    int getLocalPort() const {return localPort_;}
+
+protected:
+    std::vector<std::unique_ptr<UdpSocket_native>> sockets_;
+    int localPort_ = 0;
+};
+COCO_ENUM(UdpSocketGroup_Linux::Flags)
+
+} // namespace coco
@@ -0,0 +1,713 @@
+#include "UdpSocket_IoUring.hpp"
+#include "SocketOptions_Linux.hpp"
+#include <netinet/udp.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+
+
+namespace coco {
+
+// maximum number of segments and size of a message for UDP segmentation offload
+constexpr int MAX_SEGMENTS = 64;
+constexpr int MAX_GSO_SIZE = 65000;
+
+// create a vector for vectored I/O
+static iovec toVector(uint8_t *data, int size) {
+    return {data, size_t(size)};
+}
+
+// get segment size of datagrams received with generic receive offload
+static int getSegmentSize(msghdr &message) {
+    for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+            return *(int *)CMSG_DATA(cmsg);
+    }
+    return 0;
+}
+
+// get number of bytes to send per message
+static int getChunkSize(int size, int segmentSize, bool gso) {
+    if (segmentSize <= 0 || segmentSize >= size)
+        return size;
+    if (!gso)
+        return segmentSize;
+    return std::max(std::min(MAX_SEGMENTS, MAX_GSO_SIZE / segmentSize), 1) * segmentSize;
+}
+
+UdpSocket_IoUring::UdpSocket_IoUring(IoUring_Linux &ring)
+    : UdpSocket(State::DISABLED)
+    , ring_(ring)
+{
+}
+
+UdpSocket_IoUring::UdpSocket_IoUring(IoUring_Linux::BufferRing &bufferRing)
+    : UdpSocket_IoUring(bufferRing.ring())
+{
+    bufferRing_ = &bufferRing;
+}
+
+UdpSocket_IoUring::~UdpSocket_IoUring() {
+    // close and wait for the completions of the cancelled operations which get handled as for a closed socket, the
+    // kernel must not access the members of the socket or the memory of its buffers after they were destroyed
+    close();
+    for (auto &buffer : buffers_)
+        ring_.drain(buffer);
+    ring_.drain(receiveHandler_);
+    ring_.drain(deliverHandler_);
+    ring_.drain(errorHandler_);
+    ring_.drain(timeoutHandler_);
+}
+
+bool UdpSocket_IoUring::open(uint16_t protocolId, int localPort, Flags flags) {
+    if (socket_ != -1 || !ring_.valid())
+        return false;
+
+    // create socket
+    int socket = ::socket(protocolId, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (socket == -1)
+        return false;
+
+    // reuse address/port
+    // https://stackoverflow.com/questions/14388706/how-do-so-reuseaddr-and-so-reuseport-differ
+    int reuse = 1;
+    if (setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == -1
+        || ((flags & Flags::REUSE_PORT) != 0 && setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) == -1))
+    {
+        ::close(socket);
+        return false;
+    }
+
+    // dual-stack: receive and send IPv4 datagrams on the IPv6 socket, has to be set before binding
+    dualStack_ = (flags & Flags::DUAL_STACK) != 0 && protocolId == ip::v6::PROTOCOL_ID;
+    int v6Only = 0;
+    if (dualStack_ && setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, &v6Only, sizeof(v6Only)) == -1) {
+        ::close(socket);
+        return false;
+    }
+
+    // bind to local port
+    sockaddr_in6 ep = {.sin6_family = protocolId, .sin6_port = htons(localPort)};
+    if (bind(socket, (struct sockaddr*)&ep, sizeof(ep)) == -1) {
+        ::close(socket);
+        return false;
+    }
+
+    // check if UDP segmentation offload is supported
+    int segmentSize;
+    socklen_t size = sizeof(segmentSize);
+    gso_ = getsockopt(socket, SOL_UDP, UDP_SEGMENT, &segmentSize, &size) == 0;
+
+    // enable generic receive offload
+    int gro = 1;
+    gro_ = (flags & Flags::GRO) != 0 && setsockopt(socket, SOL_UDP, UDP_GRO, &gro, sizeof(gro)) == 0;
+
+    // enable timestamps
+    timestamps_ = (flags & Flags::TIMESTAMPS) != 0 && timestamping::enable(socket);
+    key_ = 0;
+
+    // let the kernel report dropped datagrams for the statistics
+    int overflow = 1;
+    overflow_ = statistics_ != nullptr && setsockopt(socket, SOL_SOCKET, SO_RXQ_OVFL, &overflow, sizeof(overflow)) == 0;
+    drops_ = 0;
+
+    // busy poll the network device when receiving
+    socketOptions::setBusyPoll(socket, busyPollTime_);
+
+    socket_ = socket;
+
+    // space for the sender endpoint and the control data that the multishot receive reserves in each block
+    multishotMessage_ = {.msg_namelen = sizeof(ip::Endpoint),
+        .msg_controllen = (gro_ ? CMSG_SPACE(sizeof(int)) : 0) + (overflow_ ? CMSG_SPACE(sizeof(uint32_t)) : 0)
+            + (timestamps_ ? timestamping::CONTROL_SIZE : 0)};
+
+    // watch the error queue for transmit timestamps
+    if (timestamps_)
+        poll();
+
+    // set state
+    st.set(State::READY);
+
+    // enable buffers
+    for (auto &buffer : buffers_) {
+        buffer.setReady(0);
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_OPENING | Events::ENTER_READY);
+
+    return true;
+}
+
+bool UdpSocket_IoUring::join(ip::v6::Address const &multicastGroup) {
+    // join multicast group
+    struct ipv6_mreq group;
+    std::copy(multicastGroup.u8, multicastGroup.u8 + 16, group.ipv6mr_multiaddr.s6_addr);
+    group.ipv6mr_interface = 0;
+    int r = setsockopt(socket_, IPPROTO_IPV6, IPV6_JOIN_GROUP, &group, sizeof(group));
+    if (r < 0)
+        return false;
+    return true;
+}
+
+int UdpSocket_IoUring::getBufferCount() {
+    return buffers_.count();
+}
+
+UdpSocket_IoUring::Buffer &UdpSocket_IoUring::getBuffer(int index) {
+    return buffers_.get(index);
+}
+
+void UdpSocket_IoUring::close() {
+    if (socket_ == -1)
+        return;
+
+    // cancel pending transfers, their completions are ignored when they arrive (see Buffer::handle())
+    for (auto &buffer : buffers_) {
+        if (buffer.completions_ > 0) {
+            ring_.cancel(&buffer);
+            buffer.stale_ = true;
+        }
+    }
+    while (!transfers_.empty())
+        transfers_.front().remove2();
+    while (!transmits_.empty()) {
+        auto &buffer = transmits_.front();
+        buffer.stamping_ = false;
+        buffer.remove2();
+    }
+    if (polling_) {
+        ring_.cancel(&errorHandler_);
+        polling_ = false;
+    }
+    if (timeouts_ > 0)
+        ring_.cancel(&timeoutHandler_);
+
+    // cancel multishot receive, blocks that arrive until the cancellation completes are returned to the ring
+    if (multishot_)
+        ring_.cancel(&receiveHandler_);
+    while (!receives_.empty())
+        receives_.front().remove2();
+    if (bufferRing_ != nullptr) {
+        IntrusiveListNode::remove();
+        bufferRing_->clear(received_);
+    }
+
+    // close socket, the kernel has to pick up the entries that refer to it before a new socket may get the same handle
+    ring_.flush();
+    ::close(socket_);
+    socket_ = -1;
+
+    // set state
+    st.set(State::DISABLED);
+
+    // disable buffers
+    for (auto &buffer : buffers_) {
+        if (statistics_ != nullptr && buffer.busy())
+            statistics_->finished();
+        buffer.setDisabled();
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_CLOSING | Events::ENTER_DISABLED);
+}
+
+void UdpSocket_IoUring::resume() {
+    // memory was returned to the buffer ring
+    if (socket_ != -1)
+        receive();
+}
+
+void UdpSocket_IoUring::receive() {
+    if (receives_.empty())
+        return;
+
+    if (!received_.empty()) {
+        // hand over received blocks in the next loop iteration
+        if (!delivering_) {
+            auto &sqe = ring_.get(&deliverHandler_);
+            sqe.opcode = IORING_OP_NOP;
+            ring_.commit();
+            delivering_ = true;
+        }
+    } else if (!multishot_) {
+        // one multishot receive takes a block from the buffer ring for each datagram
+        auto &sqe = ring_.get(&receiveHandler_);
+        sqe.opcode = IORING_OP_RECVMSG;
+        sqe.fd = socket_;
+        sqe.addr = uint64_t(&multishotMessage_);
+        sqe.len = 1;
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = bufferRing_->group();
+        ring_.commit();
+        multishot_ = true;
+    }
+}
+
+void UdpSocket_IoUring::deliver() {
+    while (!receives_.empty() && !received_.empty()) {
+        auto &buffer = receives_.front();
+        int id = bufferRing_->pop(received_);
+        int size = bufferRing_->size(id);
+        uint8_t *data = bufferRing_->data(id);
+
+        // the block starts with the result of the receive, followed by the reserved space for endpoint and control data
+        auto &out = *(io_uring_recvmsg_out *)data;
+        uint8_t *name = data + sizeof(io_uring_recvmsg_out);
+        uint8_t *control = name + multishotMessage_.msg_namelen;
+        uint8_t *payload = control + multishotMessage_.msg_controllen;
+        int offset = payload - data;
+
+        buffer.header_ = {};
+        std::copy(name, name + std::min(out.namelen, multishotMessage_.msg_namelen), (uint8_t *)&buffer.header_.endpoint);
+        unmap(buffer.header_.endpoint);
+        if (!accept(buffer.header_.endpoint)) {
+            // drop datagram from denied sender and return the block to the ring
+            bufferRing_->add(id);
+            continue;
+        }
+        if (gro_ || overflow_ || timestamps_) {
+            msghdr message = {.msg_control = control, .msg_controllen = out.controllen};
+            buffer.header_.segmentSize = gro_ ? getSegmentSize(message) : 0;
+            buffer.header_.timestamp = timestamps_ ? timestamping::get(message) : 0;
+            if (overflow_)
+                drop(message);
+        }
+
+        // the buffer points into the block until it gets started again
+        buffer.blockId_ = id;
+        buffer.data_ = payload;
+        buffer.capacity_ = bufferRing_->blockSize() - offset;
+
+        // remove from list of active transfers
+        buffer.remove2();
+
+        // transfer finished (the datagram is truncated if it does not fit into the block)
+        finish(buffer, std::min(int(out.payloadlen), size - offset));
+    }
+}
+
+void UdpSocket_IoUring::handleReceive(const io_uring_cqe &cqe) {
+    // the kernel ends the multishot receive on error or when it can't post more completions
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    if (!more)
+        multishot_ = false;
+
+    // queue the received block, also if no buffer is waiting
+    if ((cqe.flags & IORING_CQE_F_BUFFER) != 0)
+        bufferRing_->push(received_, cqe.flags >> IORING_CQE_BUFFER_SHIFT, cqe.res);
+
+    if (socket_ == -1) {
+        // closed: return the block to the ring
+        bufferRing_->clear(received_);
+        return;
+    }
+
+    deliver();
+
+    if (!more) {
+        if (cqe.res == -ENOBUFS) {
+            // the buffer ring ran empty: continue when memory gets returned
+            bufferRing_->wait(*this);
+        } else if (cqe.res < 0 && cqe.res != -ECANCELED) {
+            // "real" error: return zero size
+            while (!receives_.empty()) {
+                auto &buffer = receives_.front();
+                buffer.remove2();
+                fail(buffer, -cqe.res);
+            }
+        } else {
+            receive();
+        }
+    }
+}
+
+void UdpSocket_IoUring::handleDeliver(const io_uring_cqe &cqe) {
+    delivering_ = false;
+    if (socket_ == -1)
+        return;
+    deliver();
+
+    // continue receiving if buffers are still waiting
+    receive();
+}
+
+void UdpSocket_IoUring::poll() {
+    // one multishot poll reports each time the error queue becomes non-empty
+    auto &sqe = ring_.get(&errorHandler_);
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = socket_;
+    sqe.poll32_events = POLLERR;
+    sqe.len = IORING_POLL_ADD_MULTI;
+    ring_.commit();
+    polling_ = true;
+}
+
+void UdpSocket_IoUring::handleError(const io_uring_cqe &cqe) {
+    // ignore the cancellation by close()
+    if (cqe.res == -ECANCELED)
+        return;
+
+    // the kernel ends the multishot poll on error or when it can't post more completions
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+        polling_ = false;
+    if (socket_ == -1)
+        return;
+
+    timestamping::readTransmit(socket_, [this](uint32_t key, uint64_t timestamp) {
+        // the kernel reports in the order of sending, a buffer whose report is missing (e.g. the datagram was
+        // dropped before reaching the network device) finishes without timestamp with the next report
+        while (!transmits_.empty()) {
+            auto &buffer = transmits_.front();
+            if (int32_t(buffer.key_ - key) > 0)
+                break;
+
+            // remove from list of buffers waiting for their timestamp
+            buffer.stamping_ = false;
+            buffer.remove2();
+
+            // transfer finished
+            buffer.header_.timestamp = buffer.key_ == key ? timestamp : 0;
+            finish(buffer, buffer.transferred_);
+        }
+    });
+
+    if (!polling_ && socket_ != -1)
+        poll();
+}
+
+void UdpSocket_IoUring::arm() {
+    if (timeouts_ > 0 || socket_ == -1 || transmits_.empty())
+        return;
+
+    // expire at the deadline of the oldest buffer, the buffers wait in the order of sending
+    int64_t deadline = transmits_.front().deadline_;
+    timeout_ = {.tv_sec = deadline / 1000000000, .tv_nsec = deadline % 1000000000};
+    auto &sqe = ring_.get(&timeoutHandler_);
+    sqe.opcode = IORING_OP_TIMEOUT;
+    sqe.addr = uint64_t(uintptr_t(&timeout_));
+    sqe.len = 1;
+    sqe.timeout_flags = IORING_TIMEOUT_ABS;
+    ring_.commit();
+    ++timeouts_;
+}
+
+void UdpSocket_IoUring::handleTimeout(const io_uring_cqe &cqe) {
+    // expired (-ETIME) or cancelled by close(), a timeout that was cancelled before the socket was opened again only
+    // delays the timeout of the new socket
+    --timeouts_;
+
+    // the datagram of a buffer whose report did not arrive in time counts as sent
+    int64_t now = timestamping::now();
+    while (!transmits_.empty()) {
+        auto &buffer = transmits_.front();
+        if (buffer.deadline_ > now)
+            break;
+
+        // remove from list of buffers waiting for their timestamp
+        buffer.stamping_ = false;
+        buffer.remove2();
+
+        // transfer finished without timestamp
+        buffer.header_.timestamp = 0;
+        finish(buffer, buffer.transferred_);
+    }
+
+    arm();
+}
+
+void UdpSocket_IoUring::finish(Buffer &buffer, int size) {
+    if (statistics_ != nullptr) {
+        int count = getDatagramCount(size, buffer.header_.segmentSize);
+        if ((buffer.op_ & Buffer::Op::WRITE) == 0)
+            statistics_->received(count, size, buffer.started_);
+        else
+            statistics_->sent(count, size, buffer.started_);
+    }
+    buffer.setReady(buffer.split(size, (buffer.op_ & Buffer::Op::WRITE) == 0 ? buffer.capacity_ : buffer.size_));
+}
+
+void UdpSocket_IoUring::fail(Buffer &buffer, int error) {
+    if (statistics_ != nullptr) {
+        // a cancelled transfer is no error
+        if (error != ECANCELED)
+            statistics_->failed(SocketStatistics::classify(error));
+        statistics_->finished();
+    }
+    buffer.setReady(0);
+}
+
+void UdpSocket_IoUring::drop(msghdr &message) {
+    // the kernel reports the total number of dropped datagrams with each datagram after the first drop
+    for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t drops = *(uint32_t *)CMSG_DATA(cmsg);
+            statistics_->dropped(drops - drops_);
+            drops_ = drops;
+        }
+    }
+}
+
+
+// UdpSocket_IoUring::Buffer
+
+UdpSocket_IoUring::Buffer::Buffer(UdpSocket_IoUring &device, int size)
+    : Buffer(device, new uint8_t[size], size)
+{
+    ownsData_ = true;
+}
+
+UdpSocket_IoUring::Buffer::Buffer(UdpSocket_IoUring &device, BufferPool &pool)
+    : Buffer(device, pool.allocate(), pool.blockSize())
+{
+    pool_ = &pool;
+    if (data_ == nullptr)
+        capacity_ = 0;
+}
+
+UdpSocket_IoUring::Buffer::Buffer(UdpSocket_IoUring &device, uint8_t *data, int size)
+    : coco::Buffer(&header_, sizeof(header_), 0, data, size, device.st.state)
+    , device_(device)
+{
+    device.buffers_.add(*this);
+}
+
+UdpSocket_IoUring::Buffer::Buffer(UdpSocket_IoUring &device)
+    : Buffer(device, nullptr, 0)
+{
+    fromRing_ = true;
+}
+
+UdpSocket_IoUring::Buffer::~Buffer() {
+    if (completions_ > 0) {
+        // ignore the completions of the pending transfer (see handle()) and wait for them, the kernel must not access
+        // the memory after it was freed
+        stale_ = true;
+        setDisabled();
+        device_.ring_.drain(*this);
+    }
+    remove2();
+    release();
+    if (pool_ != nullptr) {
+        if (data_ != nullptr)
+            pool_->free(data_);
+    } else if (ownsData_) {
+        delete [] data_;
+    }
+}
+
+bool UdpSocket_IoUring::Buffer::start(Op op) {
+    if (st.state != State::READY) {
+        assert(st.state != State::BUSY);
+        return false;
+    }
+
+    // check if READ or WRITE flag is set
+    assert((op & Op::READ_WRITE) != 0);
+    op_ = op;
+    transferred_ = 0;
+    chainSize_ = 0;
+    if (device_.statistics_ != nullptr)
+        started_ = device_.statistics_->start();
+
+    // a chain is sent as one datagram, buffers without own memory can't receive into a chain
+    assert(chain_.empty() || ((op & Op::WRITE) == 0 ? !fromRing_ : header_.segmentSize <= 0));
+
+    if (fromRing_ && (op & Op::WRITE) == 0) {
+        // return the block of the previous read to the ring and wait for the next datagram
+        release();
+        device_.receives_.add(*this);
+
+        // set state
+        setBusy();
+
+        // receive into the buffer ring if device is ready
+        if (device_.st.state == Device::State::READY)
+            device_.receive();
+
+        return true;
+    }
+
+    // add to list of pending transfers
+    device_.transfers_.add(*this);
+
+    // start if device is ready, a transfer of the buffer that was cancelled by closing the socket has to complete first
+    if (device_.st.state == Device::State::READY && !stale_)
+        start();
+
+    // set state
+    setBusy();
+
+    return true;
+}
+
+bool UdpSocket_IoUring::Buffer::cancel() {
+    if (st.state != State::BUSY)
+        return false;
+
+    if (stamping_) {
+        // remove from list of buffers waiting for their timestamp
+        stamping_ = false;
+        remove2();
+
+        // cancelled: the data was sent, return its size without timestamp
+        header_.timestamp = 0;
+        device_.finish(*this, transferred_);
+
+        return true;
+    }
+
+    if (fromRing_ && (op_ & Op::WRITE) == 0) {
+        // remove from list of buffers waiting for the buffer ring
+        remove2();
+
+        // cancelled: return zero size
+        device_.fail(*this, ECANCELED);
+
+        return true;
+    }
+
+    if (stale_) {
+        // not submitted yet: remove from list of pending transfers
+        remove2();
+
+        // cancelled: return zero size
+        device_.fail(*this, ECANCELED);
+
+        return true;
+    }
+
+    // the completion arrives with -ECANCELED
+    device_.ring_.cancel(this);
+
+    return true;
+}
+
+void UdpSocket_IoUring::Buffer::start() {
+    // message header that stays valid until the completion arrives
+    message_ = {.msg_name = &header_.endpoint, .msg_namelen = sizeof(ip::Endpoint), .msg_iov = vectors_, .msg_iovlen = 1};
+    if ((op_ & Op::WRITE) != 0)
+        message_.msg_name = device_.map(header_.endpoint, receiver_);
+    if ((op_ & Op::WRITE) == 0) {
+        // receive into the buffer followed by its chain
+        message_.msg_iovlen = getVectors(vectors_, data_, capacity_, 0, toVector);
+        if (device_.gro_ || device_.overflow_ || device_.timestamps_) {
+            // receive segment size of coalesced datagrams, number of dropped datagrams and timestamp
+            message_.msg_control = control_;
+            message_.msg_controllen = sizeof(control_);
+        }
+    } else if (!chain_.empty()) {
+        // send one datagram from the buffer followed by its chain
+        message_.msg_iovlen = getVectors(vectors_, data_, size_, 0, toVector);
+    } else {
+        // send next message
+        int segmentSize = header_.segmentSize;
+        int size = std::min(getChunkSize(size_, segmentSize, device_.gso_), size_ - transferred_);
+        vectors_[0] = {data_ + transferred_, size_t(size)};
+        if (size > segmentSize && segmentSize > 0) {
+            // let the kernel split the message into datagrams of segment size
+            message_.msg_control = control_;
+            message_.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            auto cmsg = CMSG_FIRSTHDR(&message_);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            *(uint16_t *)CMSG_DATA(cmsg) = segmentSize;
+        }
+    }
+
+    auto &sqe = device_.ring_.get(this);
+    sqe.opcode = (op_ & Op::WRITE) == 0 ? IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+    sqe.fd = device_.socket_;
+    sqe.addr = uint64_t(&message_);
+    sqe.len = 1;
+    device_.ring_.commit();
+    ++completions_;
+}
+
+void UdpSocket_IoUring::Buffer::handle(const io_uring_cqe &cqe) {
+    --completions_;
+
+    // ignore the completion of a transfer that was cancelled by closing the socket, a transfer that was started again
+    // in the meantime (after reopening the socket) gets submitted now
+    if (stale_) {
+        stale_ = false;
+        if (st.state == State::BUSY && device_.st.state == Device::State::READY)
+            start();
+        return;
+    }
+
+    if ((op_ & Op::WRITE) == 0) {
+        if (cqe.res >= 0) {
+            device_.unmap(header_.endpoint);
+            if (!device_.accept(header_.endpoint)) {
+                // drop datagram from denied sender and receive again
+                start();
+                return;
+            }
+        }
+
+        // "real" error or cancelled (-ECANCELED): return zero size, the control data was not written
+        transferred_ = std::max(cqe.res, 0);
+        if (cqe.res >= 0) {
+            header_.segmentSize = device_.gro_ ? getSegmentSize(message_) : 0;
+            header_.timestamp = device_.timestamps_ ? timestamping::get(message_) : 0;
+            if (device_.overflow_)
+                device_.drop(message_);
+        } else {
+            header_.segmentSize = 0;
+            header_.timestamp = 0;
+        }
+    } else if (cqe.res >= 0) {
+        // each sent message gets a key for its transmit timestamp
+        key_ = device_.key_++;
+
+        // send next message if the buffer needs multiple messages
+        transferred_ += cqe.res;
+        if (transferred_ < size_) {
+            start();
+            return;
+        }
+
+        if (device_.timestamps_) {
+            // wait for the transmit timestamp of the last message, at most until the timeout
+            remove2();
+            stamping_ = true;
+            deadline_ = timestamping::now() + timestamping::TRANSMIT_TIMEOUT;
+            device_.transmits_.add(*this);
+            device_.arm();
+            return;
+        }
+    } else if (cqe.res == -EIO && device_.gso_) {
+        // segmentation offload is not possible (e.g. no checksum offload on the device): split in user space
+        device_.gso_ = false;
+        start();
+        return;
+    } else {
+        // "real" error or cancelled (-ECANCELED): return zero size
+        transferred_ = 0;
+    }
+
+    // remove from list of active transfers
+    remove2();
+
+    // transfer finished
+    if (cqe.res < 0)
+        device_.fail(*this, -cqe.res);
+    else
+        device_.finish(*this, transferred_);
+}
+
+void UdpSocket_IoUring::Buffer::release() {
+    // return the block that holds the received data to the buffer ring
+    if (blockId_ != -1) {
+        device_.bufferRing_->add(blockId_);
+        blockId_ = -1;
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+}
+
+} // namespace coco
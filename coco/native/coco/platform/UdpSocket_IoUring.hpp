@@ -0,0 +1,203 @@
+#pragma once
+
+#include <coco/UdpSocket.hpp>
+#include <coco/BufferPool.hpp>
+#include <coco/IntrusiveList.hpp>
+#include <coco/platform/IoUring_Linux.hpp>
+#include <coco/platform/Timestamping_Linux.hpp>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+namespace coco {
+
+/// @brief UDP socket on Linux using io_uring.
+/// Each started buffer becomes a submission queue entry and gets finished by its completion queue entry.
+/// Buffers with segment size are sent using UDP segmentation offload (GSO) or one datagram after the other if GSO is
+/// not available. With Flags::GRO, a read buffer may receive multiple datagrams from the same sender.
+/// When constructed with a buffer ring, buffers without own memory receive using one multishot receive per socket and
+/// get the memory from the ring when a datagram arrives. The memory is returned to the ring when the buffer is read again.
+/// With Flags::TIMESTAMPS, a sent buffer waits for its transmit timestamp which a multishot poll picks up from the
+/// error queue of the socket, at most until a timeout operation completes.
+/// Destroying the socket or a buffer cancels the pending operations and blocks until their completions have arrived.
+class UdpSocket_IoUring : public UdpSocket, public IoUring_Linux::BufferRing::Receiver {
+    friend class UdpSocketGroup_Linux;
+public:
+    /// @brief Constructor using the default ring of the event loop.
+    /// @param loop event loop
+    UdpSocket_IoUring(Loop_Linux &loop) : UdpSocket_IoUring(IoUring_Linux::get(loop)) {}
+
+    /// @brief Constructor.
+    /// @param ring io_uring, e.g. with IoUring_Linux::Flags::SQPOLL for latency-critical sockets
+    UdpSocket_IoUring(IoUring_Linux &ring);
+
+    /// @brief Constructor for receiving into a shared buffer ring.
+    /// @param bufferRing buffer ring, the block size has to include the space for the sender endpoint and control data
+    UdpSocket_IoUring(IoUring_Linux::BufferRing &bufferRing);
+
+    ~UdpSocket_IoUring() override;
+
+    // UdpSocket methods
+    bool open(uint16_t protocolId, int localPort, Flags flags = Flags::NONE) override;
+    bool join(ip::v6::Address const &multicastGroup) override;
+
+    // BufferDevice methods
+    class Buffer;
+    int getBufferCount() override;
+    Buffer &getBuffer(int index) override;
+
+    // Device methods
+    void close() override;
+
+
+    /// @brief Buffer for transferring data to/from a UDP socket.
+    ///
+    class Buffer : public coco::Buffer, public BufferChain, public IntrusiveListNode, public IntrusiveListNode2, public IoUring_Linux::Handler {
+        friend class UdpSocket_IoUring;
+    public:
+        Buffer(UdpSocket_IoUring &device, int size);
+
+        /// @brief Constructor that takes the memory from a pool.
+        /// @param device socket
+        /// @param pool pool of memory blocks, the capacity is the block size (0 if the pool is exhausted)
+        Buffer(UdpSocket_IoUring &device, BufferPool &pool);
+
+        /// @brief Constructor that wraps caller-provided memory, e.g. a mmap'd region.
+        /// @param device socket
+        /// @param data memory, has to stay valid until the buffer is destroyed
+        /// @param size size of the memory
+        Buffer(UdpSocket_IoUring &device, uint8_t *data, int size);
+
+        /// @brief Constructor for a buffer without own memory that receives into the buffer ring of the socket.
+        /// After reading, data() points into the ring and stays valid until the buffer is started again.
+        /// @param device socket that was constructed with a buffer ring
+        Buffer(UdpSocket_IoUring &device);
+
+        ~Buffer() override;
+
+        // Buffer methods
+        bool start(Op op) override;
+        bool cancel() override;
+
+    protected:
+        void start();
+        void handle(const io_uring_cqe &cqe) override;
+        void release();
+
+        UdpSocket_IoUring &device_;
+
+        // memory is either owned, taken from a pool, provided by the caller or taken from the buffer ring
+        BufferPool *pool_ = nullptr;
+        bool ownsData_ = false;
+        bool fromRing_ = false;
+
+        // block of the buffer ring that holds the received data
+        int blockId_ = -1;
+
+        Header header_ = {};
+        iovec vectors_[BufferChain::MAX_COUNT + 1];
+        msghdr message_;
+
+        // IPv4-mapped address of an IPv4 receiver on a dual-stack socket
+        ip::v6::Endpoint receiver_;
+
+        alignas(cmsghdr) uint8_t control_[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint32_t))
+            + timestamping::CONTROL_SIZE];
+        Op op_;
+
+        // number of bytes already sent (a buffer with segment size may need multiple messages)
+        int transferred_;
+
+        // number of submitted operations whose completion has not arrived, and true if the completion belongs to a
+        // transfer that was cancelled by closing the socket
+        int completions_ = 0;
+        bool stale_ = false;
+
+        // true while a sent buffer waits for its transmit timestamp, key of its last message and time after which it
+        // finishes without timestamp
+        bool stamping_ = false;
+        uint32_t key_;
+        int64_t deadline_;
+
+        // start time for the statistics
+        uint64_t started_;
+    };
+
+protected:
+    void resume() override;
+    void receive();
+    void deliver();
+    void handleReceive(const io_uring_cqe &cqe);
+    void handleDeliver(const io_uring_cqe &cqe);
+    void poll();
+    void handleError(const io_uring_cqe &cqe);
+
+    // finish the sent buffers whose transmit timestamp did not arrive in time, submit the timeout for the next one
+    void arm();
+    void handleTimeout(const io_uring_cqe &cqe);
+
+    // finish a transfer and update the statistics
+    void finish(Buffer &buffer, int size);
+    void fail(Buffer &buffer, int error);
+
+    // count the datagrams that the kernel has dropped, reported in the control data of a received datagram
+    void drop(msghdr &message);
+
+    // constructor that shares the ownership of the default ring of the event loop
+    UdpSocket_IoUring(std::shared_ptr<IoUring_Linux> ring) : UdpSocket_IoUring(*ring) {defaultRing_ = std::move(ring);}
+
+    // default ring that is owned together with the other sockets of the loop, destroyed after all other members
+    std::shared_ptr<IoUring_Linux> defaultRing_;
+    IoUring_Linux &ring_;
+
+    // socket handle
+    int socket_ = -1;
+
+    // true if the socket supports UDP segmentation offload (UDP_SEGMENT)
+    bool gso_ = false;
+
+    // true if generic receive offload is enabled (UDP_GRO)
+    bool gro_ = false;
+
+    // true if the kernel reports the number of dropped datagrams (SO_RXQ_OVFL), last reported number
+    bool overflow_ = false;
+    uint32_t drops_ = 0;
+
+    // true if timestamps are enabled (SO_TIMESTAMPING), key of the next sent message
+    bool timestamps_ = false;
+    uint32_t key_ = 0;
+
+    // list of buffers
+    IntrusiveList<Buffer> buffers_;
+
+    // pending transfers
+    IntrusiveList2<Buffer> transfers_;
+
+    // sent buffers waiting for their transmit timestamp and multishot poll for the error queue that reports them
+    IntrusiveList2<Buffer> transmits_;
+    IoUring_Linux::MemberHandler<UdpSocket_IoUring, &UdpSocket_IoUring::handleError> errorHandler_{*this};
+    bool polling_ = false;
+
+    // timeout that finishes the sent buffers whose report is missing, number of submitted timeouts
+    IoUring_Linux::MemberHandler<UdpSocket_IoUring, &UdpSocket_IoUring::handleTimeout> timeoutHandler_{*this};
+    __kernel_timespec timeout_;
+    int timeouts_ = 0;
+
+    // buffer ring for receiving with multishot receive
+    IoUring_Linux::BufferRing *bufferRing_ = nullptr;
+    msghdr multishotMessage_ = {};
+    IoUring_Linux::MemberHandler<UdpSocket_IoUring, &UdpSocket_IoUring::handleReceive> receiveHandler_{*this};
+    IoUring_Linux::MemberHandler<UdpSocket_IoUring, &UdpSocket_IoUring::handleDeliver> deliverHandler_{*this};
+
+    // true while the multishot receive is active
+    bool multishot_ = false;
+
+    // true while delivery of received blocks is scheduled for the next loop iteration
+    bool delivering_ = false;
+
+    // buffers waiting for data from the buffer ring and received blocks waiting for a buffer
+    IntrusiveList2<Buffer> receives_;
+    IoUring_Linux::BufferRing::Queue received_;
+};
+
+} // namespace coco
@@ -0,0 +1,638 @@
+#include "UdpSocket_Linux.hpp"
+#include "SocketOptions_Linux.hpp"
+#include "Timestamping_Linux.hpp"
+#include <netinet/udp.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <algorithm>
+
+
+namespace coco {
+
+// maximum number of datagrams per recvmmsg() or sendmmsg() call
+constexpr int MAX_BATCH = 64;
+
+// maximum number of segments and size of a message for UDP segmentation offload
+constexpr int MAX_SEGMENTS = 64;
+constexpr int MAX_GSO_SIZE = 65000;
+
+// create a vector for vectored I/O
+static iovec toVector(uint8_t *data, int size) {
+    return {data, size_t(size)};
+}
+
+// get segment size of datagrams received with generic receive offload
+static int getSegmentSize(msghdr &message) {
+    for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+            return *(int *)CMSG_DATA(cmsg);
+    }
+    return 0;
+}
+
+// get number of bytes to send per message
+static int getChunkSize(int size, int segmentSize, bool gso) {
+    if (segmentSize <= 0 || segmentSize >= size)
+        return size;
+    if (!gso)
+        return segmentSize;
+    return std::max(std::min(MAX_SEGMENTS, MAX_GSO_SIZE / segmentSize), 1) * segmentSize;
+}
+
+UdpSocket_Linux::UdpSocket_Linux(Loop_Linux &loop)
+    : UdpSocket(State::DISABLED)
+    , loop_(loop)
+{
+}
+
+UdpSocket_Linux::~UdpSocket_Linux() {
+    if (socket_ != -1)
+        ::close(socket_);
+    closeTimer();
+}
+
+bool UdpSocket_Linux::open(uint16_t protocolId, int localPort, Flags flags) {
+    if (socket_ != -1)
+        return false;
+
+    // create non-blocking socket
+    int socket = ::socket(protocolId, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (socket == -1)
+        return false;
+
+    // reuse address/port
+    // https://stackoverflow.com/questions/14388706/how-do-so-reuseaddr-and-so-reuseport-differ
+    int reuse = 1;
+    if (setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == -1
+        || ((flags & Flags::REUSE_PORT) != 0 && setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) == -1))
+    {
+        ::close(socket);
+        return false;
+    }
+
+    // dual-stack: receive and send IPv4 datagrams on the IPv6 socket, has to be set before binding
+    dualStack_ = (flags & Flags::DUAL_STACK) != 0 && protocolId == ip::v6::PROTOCOL_ID;
+    int v6Only = 0;
+    if (dualStack_ && setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, &v6Only, sizeof(v6Only)) == -1) {
+        ::close(socket);
+        return false;
+    }
+
+    // bind to local port
+    sockaddr_in6 ep = {.sin6_family = protocolId, .sin6_port = htons(localPort)};
+    if (bind(socket, (struct sockaddr*)&ep, sizeof(ep)) == -1) {
+        ::close(socket);
+        return false;
+    }
+
+    // check if UDP segmentation offload is supported
+    int segmentSize;
+    socklen_t size = sizeof(segmentSize);
+    gso_ = getsockopt(socket, SOL_UDP, UDP_SEGMENT, &segmentSize, &size) == 0;
+
+    // enable generic receive offload
+    int gro = 1;
+    gro_ = (flags & Flags::GRO) != 0 && setsockopt(socket, SOL_UDP, UDP_GRO, &gro, sizeof(gro)) == 0;
+
+    // enable timestamps, they need the timer for transmit timestamps that are not reported
+    timestamps_ = (flags & Flags::TIMESTAMPS) != 0 && openTimer() && timestamping::enable(socket);
+    if (!timestamps_)
+        closeTimer();
+    key_ = 0;
+
+    // let the kernel report dropped datagrams for the statistics
+    int overflow = 1;
+    overflow_ = statistics_ != nullptr && setsockopt(socket, SOL_SOCKET, SO_RXQ_OVFL, &overflow, sizeof(overflow)) == 0;
+    drops_ = 0;
+
+    // busy poll the network device when receiving
+    socketOptions::setBusyPoll(socket, busyPollTime_);
+
+    // add socket to epoll of event loop (edge-triggered)
+    Loop_Linux::CompletionHandler *handler = this;
+    epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLET, .data = {.ptr = handler}};
+    if (epoll_ctl(loop_.epollQueue, EPOLL_CTL_ADD, socket, &event) == -1) {
+        ::close(socket);
+        closeTimer();
+        return false;
+    }
+    socket_ = socket;
+
+    // the initial state gets reported by epoll
+    readable_ = false;
+    writable_ = false;
+    updating_ = true;
+
+    // set state
+    st.set(State::READY);
+
+    // enable buffers
+    for (auto &buffer : buffers_) {
+        buffer.setReady(0);
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_OPENING | Events::ENTER_READY);
+
+    return true;
+}
+
+bool UdpSocket_Linux::join(ip::v6::Address const &multicastGroup) {
+    // join multicast group
+    struct ipv6_mreq group;
+    std::copy(multicastGroup.u8, multicastGroup.u8 + 16, group.ipv6mr_multiaddr.s6_addr);
+    group.ipv6mr_interface = 0;
+    int r = setsockopt(socket_, IPPROTO_IPV6, IPV6_JOIN_GROUP, &group, sizeof(group));
+    if (r < 0)
+        return false;
+    return true;
+}
+
+int UdpSocket_Linux::getBufferCount() {
+    return buffers_.count();
+}
+
+UdpSocket_Linux::Buffer &UdpSocket_Linux::getBuffer(int index) {
+    return buffers_.get(index);
+}
+
+void UdpSocket_Linux::close() {
+    if (socket_ == -1)
+        return;
+
+    // close socket and timer (also removes them from epoll)
+    ::close(socket_);
+    socket_ = -1;
+    closeTimer();
+
+    // drop pending transfers
+    while (!receives_.empty())
+        receives_.front().remove2();
+    while (!sends_.empty())
+        sends_.front().remove2();
+    while (!transmits_.empty())
+        transmits_.front().remove2();
+
+    // set state
+    st.set(State::DISABLED);
+
+    // disable buffers
+    for (auto &buffer : buffers_) {
+        if (statistics_ != nullptr && buffer.busy())
+            statistics_->finished();
+        buffer.completed_ = -1;
+        buffer.setDisabled();
+    }
+
+    // resume all coroutines waiting for state change
+    st.notify(Events::ENTER_CLOSING | Events::ENTER_DISABLED);
+}
+
+void UdpSocket_Linux::handle(epoll_event &event) {
+    updating_ = false;
+
+    // transmit timestamps are reported as error
+    if ((event.events & EPOLLERR) != 0 && timestamps_)
+        stamp();
+
+    // errors (e.g. ICMP port unreachable) are reported by the next receive or send
+    if ((event.events & (EPOLLIN | EPOLLERR)) != 0)
+        readable_ = true;
+    if ((event.events & (EPOLLOUT | EPOLLERR)) != 0)
+        writable_ = true;
+
+    receive();
+    send();
+}
+
+void UdpSocket_Linux::update() {
+    if (updating_ || socket_ == -1)
+        return;
+    if ((readable_ && !receives_.empty()) || (writable_ && !sends_.empty())) {
+        // modifying an edge-triggered file descriptor reports its current readiness again
+        Loop_Linux::CompletionHandler *handler = this;
+        epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLET, .data = {.ptr = handler}};
+        epoll_ctl(loop_.epollQueue, EPOLL_CTL_MOD, socket_, &event);
+        updating_ = true;
+    }
+}
+
+void UdpSocket_Linux::receive() {
+    while (readable_ && !receives_.empty()) {
+        // collect pending receive buffers
+        Buffer *buffers[MAX_BATCH];
+        iovec vectors[MAX_BATCH][BufferChain::MAX_COUNT + 1];
+        mmsghdr messages[MAX_BATCH];
+        alignas(cmsghdr) uint8_t controls[MAX_BATCH][CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint32_t))
+            + timestamping::CONTROL_SIZE];
+        int count = 0;
+        for (auto &buffer : receives_) {
+            buffers[count] = &buffer;
+            int vectorCount = buffer.getVectors(vectors[count], buffer.data_, buffer.capacity_, 0, toVector);
+            auto &message = messages[count].msg_hdr;
+            message = {.msg_name = &buffer.header_.endpoint, .msg_namelen = sizeof(ip::Endpoint),
+                .msg_iov = vectors[count], .msg_iovlen = size_t(vectorCount)};
+            if (gro_ || overflow_ || timestamps_) {
+                // receive segment size of coalesced datagrams, number of dropped datagrams and timestamp
+                message.msg_control = controls[count];
+                message.msg_controllen = sizeof(controls[count]);
+            }
+            if (++count == MAX_BATCH)
+                break;
+        }
+
+        // receive a batch of datagrams
+        int result = recvmmsg(socket_, messages, count, MSG_DONTWAIT, nullptr);
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // wait for next edge
+                readable_ = false;
+                break;
+            }
+
+            // "real" error (e.g. ECONNREFUSED if nobody listens on the other end): return zero size
+            auto &buffer = *buffers[0];
+            buffer.remove2();
+            fail(buffer, errno);
+            continue;
+        }
+        receiveBatch_.add(result);
+
+        // count dropped datagrams
+        if (overflow_) {
+            for (int i = 0; i < result; ++i)
+                drop(messages[i].msg_hdr);
+        }
+
+        // the receive queue of the socket is empty if less datagrams than buffers were received
+        if (result < count)
+            readable_ = false;
+
+        // report IPv4 senders of a dual-stack socket as IPv4 endpoints
+        if (dualStack_) {
+            for (int i = 0; i < result; ++i)
+                unmap(buffers[i]->header_.endpoint);
+        }
+
+        // check the senders against the access list in one batch
+        bool allowed[MAX_BATCH];
+        if (accessList_ != nullptr) {
+            const ip::Endpoint *senders[MAX_BATCH];
+            for (int i = 0; i < result; ++i)
+                senders[i] = &buffers[i]->header_.endpoint;
+            accessList_->allowed({senders, size_t(result)}, allowed);
+        }
+
+        // take the received buffers from the list of active transfers before any coroutine gets resumed, a buffer
+        // that a resumed coroutine cancels then completes with its datagram instead of losing it (see cancel())
+        for (int i = 0; i < result; ++i) {
+            auto &buffer = *buffers[i];
+
+            // remove from list of active transfers
+            buffer.remove2();
+
+            if (accessList_ != nullptr && !allowed[i]) {
+                // drop datagram from denied sender, the buffer receives again
+                receives_.add(buffer);
+                continue;
+            }
+
+            buffer.header_.segmentSize = gro_ ? getSegmentSize(messages[i].msg_hdr) : 0;
+            buffer.header_.timestamp = timestamps_ ? timestamping::get(messages[i].msg_hdr) : 0;
+            buffer.completed_ = messages[i].msg_len;
+        }
+
+        for (int i = 0; i < result; ++i) {
+            auto &buffer = *buffers[i];
+
+            // skip buffers that were denied, or completed by cancel() or close() in a coroutine resumed in this loop
+            int size = buffer.completed_;
+            if (size < 0)
+                continue;
+
+            // transfer finished
+            buffer.completed_ = -1;
+            finish(buffer, size);
+        }
+    }
+}
+
+void UdpSocket_Linux::send() {
+    while (writable_ && !sends_.empty()) {
+        // collect pending send buffers, a buffer with segment size may need multiple messages
+        Buffer *buffers[MAX_BATCH];
+        iovec vectors[MAX_BATCH][BufferChain::MAX_COUNT + 1];
+        mmsghdr messages[MAX_BATCH];
+        ip::v6::Endpoint receivers[MAX_BATCH];
+        alignas(cmsghdr) uint8_t controls[MAX_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+        int count = 0;
+        for (auto &buffer : sends_) {
+            if (!buffer.chain_.empty()) {
+                // one datagram from the data of the buffer followed by its chain
+                buffers[count] = &buffer;
+                int vectorCount = buffer.getVectors(vectors[count], buffer.data_, buffer.size_, 0, toVector);
+                messages[count].msg_hdr = {.msg_name = map(buffer.header_.endpoint, receivers[count]),
+                    .msg_namelen = sizeof(ip::Endpoint),
+                    .msg_iov = vectors[count], .msg_iovlen = size_t(vectorCount)};
+                if (++count == MAX_BATCH)
+                    break;
+                continue;
+            }
+            int segmentSize = buffer.header_.segmentSize;
+            int chunkSize = getChunkSize(buffer.size_, segmentSize, gso_);
+            int offset = buffer.transferred_;
+            do {
+                int size = std::min(chunkSize, buffer.size_ - offset);
+                buffers[count] = &buffer;
+                vectors[count][0] = {buffer.data_ + offset, size_t(size)};
+                auto &message = messages[count].msg_hdr;
+                message = {.msg_name = map(buffer.header_.endpoint, receivers[count]),
+                    .msg_namelen = sizeof(ip::Endpoint), .msg_iov = vectors[count], .msg_iovlen = 1};
+                if (size > segmentSize && segmentSize > 0) {
+                    // let the kernel split the message into datagrams of segment size
+                    message.msg_control = controls[count];
+                    message.msg_controllen = sizeof(controls[count]);
+                    auto cmsg = CMSG_FIRSTHDR(&message);
+                    cmsg->cmsg_level = SOL_UDP;
+                    cmsg->cmsg_type = UDP_SEGMENT;
+                    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                    *(uint16_t *)CMSG_DATA(cmsg) = segmentSize;
+                }
+                offset += size;
+                ++count;
+            } while (offset < buffer.size_ && count < MAX_BATCH);
+            if (count == MAX_BATCH)
+                break;
+        }
+
+        // send a batch of messages, the rest is sent in the next iteration if not all messages were sent
+        int result = sendmmsg(socket_, messages, count, MSG_DONTWAIT);
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // wait for next edge
+                writable_ = false;
+                break;
+            }
+            if (errno == EIO && gso_) {
+                // segmentation offload is not possible (e.g. no checksum offload on the device): split in user space
+                gso_ = false;
+                continue;
+            }
+
+            // "real" error: return zero size
+            auto &buffer = *buffers[0];
+            buffer.remove2();
+            fail(buffer, errno);
+            continue;
+        }
+        sendBatch_.add(result);
+
+        // take the sent buffers from the list of active transfers before any coroutine gets resumed, a buffer that a
+        // resumed coroutine cancels then completes with the size of its sent data (see cancel())
+        int64_t deadline = timestamps_ ? timestamping::now() + timestamping::TRANSMIT_TIMEOUT : 0;
+        for (int i = 0; i < result; ++i) {
+            auto &buffer = *buffers[i];
+
+            // check if more messages of this buffer are pending
+            buffer.transferred_ += messages[i].msg_len;
+            if (buffer.transferred_ < buffer.size_)
+                continue;
+
+            // remove from list of active transfers
+            buffer.remove2();
+
+            if (timestamps_) {
+                // wait for the transmit timestamp of the last message until the deadline
+                buffer.key_ = key_ + i;
+                buffer.deadline_ = deadline;
+                transmits_.add(buffer);
+                continue;
+            }
+            buffer.completed_ = buffer.transferred_;
+        }
+
+        // each sent message gets a key for its transmit timestamp
+        key_ += result;
+
+        for (int i = 0; i < result; ++i) {
+            auto &buffer = *buffers[i];
+
+            // skip buffers with pending messages or timestamp, or completed by cancel() or close() in a coroutine
+            // resumed in this loop
+            int size = buffer.completed_;
+            if (size < 0)
+                continue;
+
+            // transfer finished
+            buffer.completed_ = -1;
+            finish(buffer, size);
+        }
+
+        // finish the buffers without timestamp if their reports are missing
+        arm();
+    }
+}
+
+void UdpSocket_Linux::stamp() {
+    timestamping::readTransmit(socket_, [this](uint32_t key, uint64_t timestamp) {
+        // the kernel reports in the order of sending, a buffer whose report is missing (e.g. the datagram was
+        // dropped before reaching the network device) finishes without timestamp with the next report
+        while (!transmits_.empty()) {
+            auto &buffer = transmits_.front();
+            if (int32_t(buffer.key_ - key) > 0)
+                break;
+
+            // remove from list of buffers waiting for their timestamp
+            buffer.remove2();
+
+            // transfer finished
+            buffer.header_.timestamp = buffer.key_ == key ? timestamp : 0;
+            finish(buffer, buffer.transferred_);
+        }
+    });
+}
+
+bool UdpSocket_Linux::openTimer() {
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer == -1)
+        return false;
+
+    // add timer to epoll of event loop
+    Loop_Linux::CompletionHandler *handler = &timer_;
+    epoll_event event = {.events = EPOLLIN, .data = {.ptr = handler}};
+    if (epoll_ctl(loop_.epollQueue, EPOLL_CTL_ADD, timer, &event) == -1) {
+        ::close(timer);
+        return false;
+    }
+    timerFd_ = timer;
+    timing_ = false;
+    return true;
+}
+
+void UdpSocket_Linux::closeTimer() {
+    if (timerFd_ == -1)
+        return;
+    ::close(timerFd_);
+    timerFd_ = -1;
+    timing_ = false;
+}
+
+void UdpSocket_Linux::expire() {
+    // clear the expiration of the timer
+    uint64_t count;
+    (void)!read(timerFd_, &count, sizeof(count));
+    timing_ = false;
+
+    // the datagram of a buffer whose report did not arrive in time counts as sent
+    int64_t now = timestamping::now();
+    while (!transmits_.empty()) {
+        auto &buffer = transmits_.front();
+        if (buffer.deadline_ > now)
+            break;
+
+        // remove from list of buffers waiting for their timestamp
+        buffer.remove2();
+
+        // transfer finished without timestamp
+        buffer.header_.timestamp = 0;
+        finish(buffer, buffer.transferred_);
+    }
+
+    arm();
+}
+
+void UdpSocket_Linux::arm() {
+    if (timing_ || timerFd_ == -1 || transmits_.empty())
+        return;
+
+    // expire at the deadline of the oldest buffer, the buffers wait in the order of sending
+    int64_t deadline = transmits_.front().deadline_;
+    itimerspec time = {.it_value = {.tv_sec = time_t(deadline / 1000000000), .tv_nsec = long(deadline % 1000000000)}};
+    timing_ = timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &time, nullptr) == 0;
+}
+
+void UdpSocket_Linux::finish(Buffer &buffer, int size) {
+    if (statistics_ != nullptr) {
+        int count = getDatagramCount(size, buffer.header_.segmentSize);
+        if ((buffer.op_ & Buffer::Op::WRITE) == 0)
+            statistics_->received(count, size, buffer.started_);
+        else
+            statistics_->sent(count, size, buffer.started_);
+    }
+    buffer.setReady(buffer.split(size, (buffer.op_ & Buffer::Op::WRITE) == 0 ? buffer.capacity_ : buffer.size_));
+}
+
+void UdpSocket_Linux::fail(Buffer &buffer, int error) {
+    if (statistics_ != nullptr) {
+        statistics_->failed(SocketStatistics::classify(error));
+        statistics_->finished();
+    }
+    buffer.setReady(0);
+}
+
+void UdpSocket_Linux::drop(msghdr &message) {
+    // the kernel reports the total number of dropped datagrams with each datagram after the first drop
+    for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t drops = *(uint32_t *)CMSG_DATA(cmsg);
+            statistics_->dropped(drops - drops_);
+            drops_ = drops;
+        }
+    }
+}
+
+
+// UdpSocket_Linux::Buffer
+
+UdpSocket_Linux::Buffer::Buffer(UdpSocket_Linux &device, int size)
+    : Buffer(device, new uint8_t[size], size)
+{
+    ownsData_ = true;
+}
+
+UdpSocket_Linux::Buffer::Buffer(UdpSocket_Linux &device, BufferPool &pool)
+    : Buffer(device, pool.allocate(), pool.blockSize())
+{
+    pool_ = &pool;
+    if (data_ == nullptr)
+        capacity_ = 0;
+}
+
+UdpSocket_Linux::Buffer::Buffer(UdpSocket_Linux &device, uint8_t *data, int size)
+    : coco::Buffer(&header_, sizeof(header_), 0, data, size, device.st.state)
+    , device_(device)
+{
+    device.buffers_.add(*this);
+}
+
+UdpSocket_Linux::Buffer::~Buffer() {
+    if (pool_ != nullptr) {
+        if (data_ != nullptr)
+            pool_->free(data_);
+    } else if (ownsData_) {
+        delete [] data_;
+    }
+}
+
+bool UdpSocket_Linux::Buffer::start(Op op) {
+    if (st.state != State::READY) {
+        assert(st.state != State::BUSY);
+        return false;
+    }
+
+    // check if READ or WRITE flag is set
+    assert((op & Op::READ_WRITE) != 0);
+    op_ = op;
+    transferred_ = 0;
+    chainSize_ = 0;
+    if (device_.statistics_ != nullptr)
+        started_ = device_.statistics_->start();
+
+    // a chain is sent as one datagram
+    assert((op & Op::WRITE) == 0 || chain_.empty() || header_.segmentSize <= 0);
+
+    // add to list of pending transfers
+    if ((op & Op::WRITE) == 0)
+        device_.receives_.add(*this);
+    else
+        device_.sends_.add(*this);
+
+    // set state
+    setBusy();
+
+    // transfer in the next loop iteration if the socket is ready
+    device_.update();
+
+    return true;
+}
+
+bool UdpSocket_Linux::Buffer::cancel() {
+    if (st.state != State::BUSY)
+        return false;
+
+    if (completed_ >= 0) {
+        // the datagram was already received or sent in a batch that has not completed this buffer yet
+        int size = completed_;
+        completed_ = -1;
+        device_.finish(*this, size);
+        return true;
+    }
+
+    // remove from list of active transfers
+    remove2();
+
+    // cancelled: return zero size, or the size of a sent buffer that waits for its transmit timestamp
+    header_.timestamp = 0;
+    if ((op_ & Op::WRITE) != 0 && transferred_ == size_) {
+        device_.finish(*this, transferred_);
+    } else {
+        if (device_.statistics_ != nullptr)
+            device_.statistics_->finished();
+        setReady(0);
+    }
+
+    return true;
+}
+
+} // namespace coco
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <coco/UdpSocket.hpp>
+#include <coco/BufferPool.hpp>
+#include <coco/IntrusiveList.hpp>
+#include <coco/platform/Loop_native.hpp>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+namespace coco {
+
+/// @brief UDP socket on Linux using non-blocking sockets and edge-triggered epoll.
+/// Transfers are started when the event loop reports that the socket is readable or writable.
+/// All pending read buffers are filled by one recvmmsg() call, all write buffers that are started in the same loop
+/// iteration are sent by one sendmmsg() call. Buffers with segment size are sent using UDP segmentation offload (GSO)
+/// or get split into multiple datagrams if GSO is not available. With Flags::GRO, a read buffer may receive multiple
+/// datagrams from the same sender. With Flags::TIMESTAMPS, a sent buffer waits for its transmit timestamp on the
+/// error queue of the socket, at most until a timer (timerfd) expires.
+class UdpSocket_Linux : public UdpSocket, public Loop_Linux::CompletionHandler {
+    friend class UdpSocketGroup_Linux;
+public:
+    /// @brief Constructor.
+    /// @param loop event loop
+    UdpSocket_Linux(Loop_Linux &loop);
+
+    ~UdpSocket_Linux() override;
+
+    // UdpSocket methods
+    bool open(uint16_t protocolId, int localPort, Flags flags = Flags::NONE) override;
+    bool join(ip::v6::Address const &multicastGroup) override;
+
+    // BufferDevice methods
+    class Buffer;
+    int getBufferCount() override;
+    Buffer &getBuffer(int index) override;
+
+    // Device methods
+    void close() override;
+
+    /// @brief Statistics of batched transfers.
+    ///
+    struct BatchStatistics {
+        // number of datagrams transferred by the last batch
+        int last = 0;
+
+        // maximum number of datagrams transferred by one batch
+        int max = 0;
+
+        // number of batches and datagrams, the average batch size is datagrams / batches
+        uint64_t batches = 0;
+        uint64_t datagrams = 0;
+
+        void add(int count) {
+            last = count;
+            max = count > max ? count : max;
+            ++batches;
+            datagrams += count;
+        }
+    };
+
+    /// @brief Get statistics of batched receive. All pending read buffers get filled by one recvmmsg() when the
+    /// socket becomes readable, the batch size shows how many datagrams were received per wakeup.
+    /// @return batch statistics
+    const BatchStatistics &getReceiveBatch() const {return receiveBatch_;}
+
+    /// @brief Get statistics of batched send. Write buffers that get started in the same loop iteration are sent by
+    /// one sendmmsg() to the endpoints in their headers.
+    /// @return batch statistics
+    const BatchStatistics &getSendBatch() const {return sendBatch_;}
+
+
+    /// @brief Buffer for transferring data to/from a UDP socket.
+    ///
+    class Buffer : public coco::Buffer, public BufferChain, public IntrusiveListNode, public IntrusiveListNode2 {
+        friend class UdpSocket_Linux;
+    public:
+        Buffer(UdpSocket_Linux &device, int size);
+
+        /// @brief Constructor that takes the memory from a pool.
+        /// @param device socket
+        /// @param pool pool of memory blocks, the capacity is the block size (0 if the pool is exhausted)
+        Buffer(UdpSocket_Linux &device, BufferPool &pool);
+
+        /// @brief Constructor that wraps caller-provided memory, e.g. a mmap'd region.
+        /// @param device socket
+        /// @param data memory, has to stay valid until the buffer is destroyed
+        /// @param size size of the memory
+        Buffer(UdpSocket_Linux &device, uint8_t *data, int size);
+
+        ~Buffer() override;
+
+        // Buffer methods
+        bool start(Op op) override;
+        bool cancel() override;
+
+    protected:
+        UdpSocket_Linux &device_;
+
+        // memory is either owned, taken from a pool or provided by the caller
+        BufferPool *pool_ = nullptr;
+        bool ownsData_ = false;
+
+        Header header_ = {};
+        Op op_;
+
+        // number of bytes already sent (a buffer with segment size may need multiple messages)
+        int transferred_;
+
+        // size of the datagram received or of the data sent in the current batch until the buffer gets completed, -1
+        // otherwise
+        int completed_ = -1;
+
+        // key of the last message of a sent buffer that waits for its transmit timestamp, time after which it
+        // finishes without timestamp
+        uint32_t key_;
+        int64_t deadline_;
+
+        // start time for the statistics
+        uint64_t started_;
+    };
+
+protected:
+    void handle(epoll_event &event) override;
+
+    // request an event from the loop if the socket is ready for a pending transfer
+    void update();
+
+    // transfer as many pending buffers as possible until the socket would block
+    void receive();
+    void send();
+
+    // read the transmit timestamps from the error queue and finish the buffers that were sent
+    void stamp();
+
+    // create and destroy the timer for sent buffers whose transmit timestamp is missing
+    bool openTimer();
+    void closeTimer();
+
+    // finish the sent buffers whose transmit timestamp did not arrive in time, start the timer for the next one
+    void expire();
+    void arm();
+
+    // forwards the events of the timer
+    class Timer : public Loop_Linux::CompletionHandler {
+    public:
+        Timer(UdpSocket_Linux &socket) : socket_(socket) {}
+        void handle(epoll_event &event) override {socket_.expire();}
+    protected:
+        UdpSocket_Linux &socket_;
+    };
+
+    // finish a transfer and update the statistics
+    void finish(Buffer &buffer, int size);
+    void fail(Buffer &buffer, int error);
+
+    // count the datagrams that the kernel has dropped, reported in the control data of a received datagram
+    void drop(msghdr &message);
+
+    Loop_Linux &loop_;
+
+    // socket handle
+    int socket_ = -1;
+
+    // true if the socket supports UDP segmentation offload (UDP_SEGMENT)
+    bool gso_ = false;
+
+    // true if generic receive offload is enabled (UDP_GRO)
+    bool gro_ = false;
+
+    // true if the kernel reports the number of dropped datagrams (SO_RXQ_OVFL), last reported number
+    bool overflow_ = false;
+    uint32_t drops_ = 0;
+
+    // true if timestamps are enabled (SO_TIMESTAMPING), key of the next sent message
+    bool timestamps_ = false;
+    uint32_t key_ = 0;
+
+    // readiness of the socket, cleared when an operation would block (edge-triggered epoll)
+    bool readable_ = false;
+    bool writable_ = false;
+
+    // set when epoll was re-armed to report the current readiness in the next loop iteration
+    bool updating_ = false;
+
+    // statistics
+    BatchStatistics receiveBatch_;
+    BatchStatistics sendBatch_;
+
+    // list of buffers
+    IntrusiveList<Buffer> buffers_;
+
+    // pending transfers
+    IntrusiveList2<Buffer> receives_;
+    IntrusiveList2<Buffer> sends_;
+
+    // sent buffers waiting for their transmit timestamp and timer that finishes them when their report is missing
+    IntrusiveList2<Buffer> transmits_;
+    Timer timer_{*this};
+    int timerFd_ = -1;
+    bool timing_ = false;
+};
+
+} // namespace coco
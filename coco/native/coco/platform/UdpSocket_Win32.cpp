@@ -1,9 +1,37 @@
 #include "UdpSocket_Win32.hpp"
+#include <algorithm>
 #include <iostream>
 
 
 namespace coco {
 
+// get the error class of a Winsock error
+static SocketStatistics::Error classify(int error) {
+    switch (error) {
+    case WSAECONNREFUSED:
+    case WSAEHOSTUNREACH:
+    case WSAENETUNREACH:
+        return SocketStatistics::Error::UNREACHABLE;
+    // a UDP socket gets WSAECONNRESET when the destination port is unreachable (ICMP)
+    case WSAECONNRESET:
+    case WSAECONNABORTED:
+        return SocketStatistics::Error::UNREACHABLE;
+    case WSAETIMEDOUT:
+        return SocketStatistics::Error::TIMEOUT;
+    case WSAENOBUFS:
+        return SocketStatistics::Error::NO_BUFFERS;
+    case WSAEMSGSIZE:
+        return SocketStatistics::Error::MESSAGE_SIZE;
+    default:
+        return SocketStatistics::Error::OTHER;
+    }
+}
+
+// get a Winsock vector for vectored transfers
+static WSABUF toVector(uint8_t *data, int size) {
+    return {ULONG(size), (CHAR *)data};
+}
+
 UdpSocket_Win32::UdpSocket_Win32(Loop_Win32 &loop)
     : UdpSocket(State::DISABLED)
     , loop_(loop)
@@ -17,7 +45,7 @@ UdpSocket_Win32::~UdpSocket_Win32() {
     WSACleanup();
 }
 
-bool UdpSocket_Win32::open(uint16_t protocolId, int localPort) {
+bool UdpSocket_Win32::open(uint16_t protocolId, int localPort, Flags flags) {
     if (socket_ != INVALID_SOCKET)
         return false;
 
@@ -37,6 +65,14 @@ bool UdpSocket_Win32::open(uint16_t protocolId, int localPort) {
         return false;
     }
 
+    // dual-stack: receive and send IPv4 datagrams on the IPv6 socket (IPV6_V6ONLY is on by default on Windows)
+    dualStack_ = (flags & Flags::DUAL_STACK) != 0 && protocolId == ip::v6::PROTOCOL_ID;
+    DWORD v6Only = 0;
+    if (dualStack_ && setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&v6Only, sizeof(v6Only)) == SOCKET_ERROR) {
+        closesocket(socket);
+        return false;
+    }
+
     // bind to local port
     sockaddr_in6 ep = {.sin6_family = protocolId, .sin6_port = htons(localPort)};
     if (bind(socket, (struct sockaddr*)&ep, sizeof(ep)) == SOCKET_ERROR) {
@@ -107,6 +143,8 @@ void UdpSocket_Win32::close() {
 
     // disable buffers
     for (auto &buffer : buffers_) {
+        if (statistics_ != nullptr && buffer.busy())
+            statistics_->finished();
         buffer.setDisabled();
     }
 
@@ -115,26 +153,43 @@ void UdpSocket_Win32::close() {
 }
 
 void UdpSocket_Win32::handle(OVERLAPPED *overlapped) {
-    for (auto &buffer : transfers_) {
-        if (overlapped == &buffer.overlapped_) {
-            buffer.handle(overlapped);
-            break;
-        }
-    }
+    // the overlapped structure is the first member of Buffer::Overlapped which points back to the buffer
+    auto &buffer = *reinterpret_cast<Buffer::Overlapped *>(overlapped)->buffer;
+    buffer.handle(overlapped);
 }
 
 
 // UdpSocket_Win32::Buffer
 
 UdpSocket_Win32::Buffer::Buffer(UdpSocket_Win32 &device, int size)
-    : coco::Buffer(&endpoint_, sizeof(endpoint_), 0, new uint8_t[size], size, device.st.state)
+    : Buffer(device, new uint8_t[size], size)
+{
+    ownsData_ = true;
+}
+
+UdpSocket_Win32::Buffer::Buffer(UdpSocket_Win32 &device, BufferPool &pool)
+    : Buffer(device, pool.allocate(), pool.blockSize())
+{
+    pool_ = &pool;
+    if (data_ == nullptr)
+        capacity_ = 0;
+}
+
+UdpSocket_Win32::Buffer::Buffer(UdpSocket_Win32 &device, uint8_t *data, int size)
+    : coco::Buffer(&header_, sizeof(header_), 0, data, size, device.st.state)
     , device_(device)
 {
+    overlapped_.buffer = this;
     device.buffers_.add(*this);
 }
 
 UdpSocket_Win32::Buffer::~Buffer() {
-    delete [] data_;
+    if (pool_ != nullptr) {
+        if (data_ != nullptr)
+            pool_->free(data_);
+    } else if (ownsData_) {
+        delete [] data_;
+    }
 }
 
 bool UdpSocket_Win32::Buffer::start(Op op) {
@@ -146,17 +201,22 @@ bool UdpSocket_Win32::Buffer::start(Op op) {
     // check if READ or WRITE flag is set
     assert((op & Op::READ_WRITE) != 0);
     op_ = op;
+    transferred_ = 0;
+    chainSize_ = 0;
+
+    if (device_.statistics_ != nullptr)
+        started_ = device_.statistics_->start();
 
     // add to list of pending transfers
     device_.transfers_.add(*this);
 
+    // set state (before starting because a "real" error finishes the transfer immediately)
+    setBusy();
+
     // start if device is ready
     if (device_.st.state == Device::State::READY)
         start();
 
-    // set state
-    setBusy();
-
     return true;
 }
 
@@ -164,7 +224,7 @@ bool UdpSocket_Win32::Buffer::cancel() {
     if (st.state != State::BUSY)
         return false;
 
-    auto result = CancelIoEx((HANDLE)device_.socket_, &overlapped_);
+    auto result = CancelIoEx((HANDLE)device_.socket_, &overlapped_.overlapped);
     if (!result) {
         auto e = WSAGetLastError();
         std::cerr << "cancel error " << e << std::endl;
@@ -175,30 +235,42 @@ bool UdpSocket_Win32::Buffer::cancel() {
 
 void UdpSocket_Win32::Buffer::start() {
     // initialize overlapped
-    memset(&overlapped_, 0, sizeof(OVERLAPPED));
+    memset(&overlapped_.overlapped, 0, sizeof(OVERLAPPED));
 
-    // get header
-    CHAR *data = (CHAR *)data_;
+    // vectors for the buffer and its chain (Winsock captures them before returning)
+    WSABUF vectors[MAX_COUNT + 1];
 
     int result;
     if ((op_ & Op::WRITE) == 0) {
         // receive
-        WSABUF buffer{capacity_, data};
+        int count = getVectors(vectors, data_, capacity_, 0, toVector);
         DWORD flags = 0;
-        endpointSize_ = sizeof(endpoint_);
-        result = WSARecvFrom(device_.socket_, &buffer, 1, nullptr, &flags, &endpoint_.generic, &endpointSize_, &overlapped_, nullptr);
+        endpointSize_ = sizeof(header_.endpoint);
+        header_.segmentSize = 0;
+        header_.timestamp = 0;
+        result = WSARecvFrom(device_.socket_, vectors, count, nullptr, &flags, (sockaddr *)&header_.endpoint, &endpointSize_, &overlapped_.overlapped, nullptr);
     } else {
-        // send
-        WSABUF buffer{size_, data};
-        result = WSASendTo(device_.socket_, &buffer, 1, nullptr, 0, &endpoint_.generic, sizeof(endpoint_), &overlapped_, nullptr);
+        int count = 1;
+        if (!chain_.empty()) {
+            // send one datagram from the buffer followed by its chain
+            count = getVectors(vectors, data_, size_, 0, toVector);
+        } else {
+            // send next datagram, a buffer with segment size gets split into datagrams of segment size
+            int segmentSize = header_.segmentSize;
+            int size = size_ - transferred_;
+            if (segmentSize > 0)
+                size = std::min(size, segmentSize);
+            vectors[0] = toVector(data_ + transferred_, size);
+        }
+        auto receiver = (sockaddr *)device_.map(header_.endpoint, receiver_);
+        result = WSASendTo(device_.socket_, vectors, count, nullptr, 0, receiver, sizeof(header_.endpoint), &overlapped_.overlapped, nullptr);
     }
 
     if (result != 0) {
         int error = WSAGetLastError();
         if (error != WSA_IO_PENDING) {
             // "real" error (e.g. if nobody listens on the other end we get WSAECONNRESET = 10054)
-            setReady(0);
-            //return false;
+            finish(0, error);
         }
     }
 }
@@ -209,15 +281,45 @@ void UdpSocket_Win32::Buffer::handle(OVERLAPPED *overlapped) {
     auto result = WSAGetOverlappedResult(device_.socket_, overlapped, &transferred, false, &flags);
     if (!result) {
         // "real" error or cancelled (ERROR_OPERATION_ABORTED): return zero size
-        auto error = WSAGetLastError();
-        transferred = 0;
+        finish(0, WSAGetLastError());
+        return;
+    } else if ((op_ & Op::WRITE) == 0) {
+        device_.unmap(header_.endpoint);
+        if (!device_.accept(header_.endpoint)) {
+            // drop datagram from denied sender and receive again
+            start();
+            return;
+        }
+    } else if (chain_.empty()) {
+        // send next datagram if the buffer needs multiple datagrams
+        transferred_ += transferred;
+        if (transferred_ < size_) {
+            start();
+            return;
+        }
+        transferred = transferred_;
     }
 
+    // transfer finished
+    finish(transferred, 0);
+}
+
+void UdpSocket_Win32::Buffer::finish(int size, int error) {
     // remove from list of active transfers
     remove2();
 
-    // transfer finished
-    setReady(transferred);
+    auto statistics = device_.statistics_;
+    if (statistics != nullptr) {
+        if (error != 0 && error != ERROR_OPERATION_ABORTED)
+            statistics->failed(classify(error));
+        if (size <= 0)
+            statistics->finished();
+        else if ((op_ & Op::WRITE) == 0)
+            statistics->received(1, size, started_);
+        else
+            statistics->sent(getDatagramCount(size, header_.segmentSize), size, started_);
+    }
+    setReady(split(size, (op_ & Op::WRITE) == 0 ? capacity_ : size_));
 }
 
 } // namespace coco
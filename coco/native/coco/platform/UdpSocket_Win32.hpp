@@ -1,6 +1,7 @@
 #pragma once
 
 #include <coco/UdpSocket.hpp>
+#include <coco/BufferPool.hpp>
 #include <coco/IntrusiveList.hpp>
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -20,7 +21,7 @@ public:
     ~UdpSocket_Win32() override;
 
     // UdpSocket methods
-    bool open(uint16_t protocolId, int localPort) override;
+    bool open(uint16_t protocolId, int localPort, Flags flags = Flags::NONE) override;
     bool join(ip::v6::Address const &multicastGroup) override;
 
     // BufferDevice methods
@@ -34,10 +35,22 @@ public:
 
     /// @brief Buffer for transferring data to/from a file.
     ///
-    class Buffer : public coco::Buffer, public IntrusiveListNode, public IntrusiveListNode2 {
+    class Buffer : public coco::Buffer, public BufferChain, public IntrusiveListNode, public IntrusiveListNode2 {
         friend class UdpSocket_Win32;
     public:
         Buffer(UdpSocket_Win32 &device, int size);
+
+        /// @brief Constructor that takes the memory from a pool.
+        /// @param device socket
+        /// @param pool pool of memory blocks, the capacity is the block size (0 if the pool is exhausted)
+        Buffer(UdpSocket_Win32 &device, BufferPool &pool);
+
+        /// @brief Constructor that wraps caller-provided memory, e.g. a mmap'd region.
+        /// @param device socket
+        /// @param data memory, has to stay valid until the buffer is destroyed
+        /// @param size size of the memory
+        Buffer(UdpSocket_Win32 &device, uint8_t *data, int size);
+
         ~Buffer() override;
 
         // Buffer methods
@@ -48,15 +61,35 @@ public:
         void start();
         void handle(OVERLAPPED *overlapped);
 
+        // finish the transfer and update the statistics
+        void finish(int size, int error);
+
+        // overlapped structure that points back to the buffer so that a completion maps directly to its buffer
+        struct Overlapped {
+            OVERLAPPED overlapped;
+            Buffer *buffer;
+        };
+
         UdpSocket_Win32 &device_;
-        union {
-            sockaddr generic;
-            sockaddr_in v4;
-            sockaddr_in6 v6;
-        } endpoint_;
+
+        // memory is either owned, taken from a pool or provided by the caller
+        BufferPool *pool_ = nullptr;
+        bool ownsData_ = false;
+
+        Header header_ = {};
         INT endpointSize_;
-        OVERLAPPED overlapped_;
+
+        // IPv4-mapped address of an IPv4 receiver on a dual-stack socket
+        ip::v6::Endpoint receiver_;
+
+        Overlapped overlapped_;
         Op op_;
+
+        // number of bytes already sent (a buffer with segment size needs one WSASendTo() per datagram)
+        int transferred_;
+
+        // start time for the statistics
+        uint64_t started_;
     };
 
 protected:
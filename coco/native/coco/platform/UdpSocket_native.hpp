@@ -5,4 +5,14 @@
 namespace coco {
 using UdpSocket_native = UdpSocket_Win32;
 }
+#elif defined(__linux__) && defined(COCO_IP_IO_URING)
+#include "UdpSocket_IoUring.hpp"
+namespace coco {
+using UdpSocket_native = UdpSocket_IoUring;
+}
+#elif defined(__linux__)
+#include "UdpSocket_Linux.hpp"
+namespace coco {
+using UdpSocket_native = UdpSocket_Linux;
+}
 #endif
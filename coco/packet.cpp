@@ -0,0 +1,261 @@
+#include "packet.hpp"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COCO_PACKET_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(COCO_PACKET_SSE2) && (defined(__GNUC__) || defined(__clang__))
+// AVX2 kernel gets compiled with a target attribute and selected at runtime
+#define COCO_PACKET_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define COCO_PACKET_NEON
+#include <arm_neon.h>
+#endif
+
+
+namespace coco {
+namespace ip {
+
+namespace {
+
+// kernels sum the data as 16 bit words in native byte order, the one's complement sum is independent of byte order
+// (RFC 1071) and gets swapped once at the end. Each kernel returns a 64 bit sum that still needs to be folded.
+
+inline uint64_t add64(uint64_t sum, uint64_t x) {
+    // end-around carry
+    sum += x;
+    return sum + (sum < x);
+}
+
+uint64_t sumScalar(const uint8_t *data, size_t size, uint64_t sum) {
+    while (size >= 32) {
+        uint64_t x[4];
+        std::memcpy(x, data, 32);
+        sum = add64(sum, x[0]);
+        sum = add64(sum, x[1]);
+        sum = add64(sum, x[2]);
+        sum = add64(sum, x[3]);
+        data += 32;
+        size -= 32;
+    }
+    while (size >= 8) {
+        uint64_t x;
+        std::memcpy(&x, data, 8);
+        sum = add64(sum, x);
+        data += 8;
+        size -= 8;
+    }
+    if (size >= 4) {
+        uint32_t x;
+        std::memcpy(&x, data, 4);
+        sum = add64(sum, x);
+        data += 4;
+        size -= 4;
+    }
+    if (size >= 2) {
+        uint16_t x;
+        std::memcpy(&x, data, 2);
+        sum = add64(sum, x);
+        data += 2;
+        size -= 2;
+    }
+    if (size > 0) {
+        // pad with zero, the byte is the first of a little endian word
+        sum = add64(sum, data[0]);
+    }
+    return sum;
+}
+
+#ifdef COCO_PACKET_SSE2
+uint64_t sumSse2(const uint8_t *data, size_t size, uint64_t sum) {
+    // zero-extend 32 bit words into 64 bit lanes, two accumulators to hide latency. Each lane can add 2^32 words
+    // before it overflows, far more than any packet
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = zero;
+    __m128i acc1 = zero;
+    while (size >= 64) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 48));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(a, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(a, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(b, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(b, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(c, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(c, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(d, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(d, zero));
+        data += 64;
+        size -= 64;
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), _mm_add_epi64(acc0, acc1));
+    sum = add64(sum, lanes[0]);
+    sum = add64(sum, lanes[1]);
+    return sumScalar(data, size, sum);
+}
+#endif
+
+#ifdef COCO_PACKET_AVX2
+__attribute__((target("avx2")))
+uint64_t sumAvx2(const uint8_t *data, size_t size, uint64_t sum) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = zero;
+    __m256i acc1 = zero;
+    while (size >= 128) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 32));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 64));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 96));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(a, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(a, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(b, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(b, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(c, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(c, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(d, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(d, zero));
+        data += 128;
+        size -= 128;
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), _mm256_add_epi64(acc0, acc1));
+    for (uint64_t lane : lanes)
+        sum = add64(sum, lane);
+    return sumSse2(data, size, sum);
+}
+#endif
+
+#ifdef COCO_PACKET_NEON
+uint64_t sumNeon(const uint8_t *data, size_t size, uint64_t sum) {
+    // pairwise add 32 bit words into 64 bit lanes
+    uint64x2_t acc0 = vdupq_n_u64(0);
+    uint64x2_t acc1 = vdupq_n_u64(0);
+    while (size >= 64) {
+        acc0 = vpadalq_u32(acc0, vreinterpretq_u32_u8(vld1q_u8(data)));
+        acc1 = vpadalq_u32(acc1, vreinterpretq_u32_u8(vld1q_u8(data + 16)));
+        acc0 = vpadalq_u32(acc0, vreinterpretq_u32_u8(vld1q_u8(data + 32)));
+        acc1 = vpadalq_u32(acc1, vreinterpretq_u32_u8(vld1q_u8(data + 48)));
+        data += 64;
+        size -= 64;
+    }
+    uint64x2_t acc = vaddq_u64(acc0, acc1);
+    sum = add64(sum, vgetq_lane_u64(acc, 0));
+    sum = add64(sum, vgetq_lane_u64(acc, 1));
+    return sumScalar(data, size, sum);
+}
+#endif
+
+using Kernel = uint64_t (*)(const uint8_t *, size_t, uint64_t);
+
+struct Selected {
+    Kernel kernel;
+    const char *name;
+};
+
+Selected select() {
+#ifdef COCO_PACKET_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return {sumAvx2, "avx2"};
+#endif
+#if defined(COCO_PACKET_SSE2)
+    return {sumSse2, "sse2"};
+#elif defined(COCO_PACKET_NEON)
+    return {sumNeon, "neon"};
+#else
+    return {sumScalar, "scalar"};
+#endif
+}
+
+const Selected &selected() {
+    static const Selected s = select();
+    return s;
+}
+
+// below this size the setup of the SIMD kernels costs more than it saves (e.g. IPv4 and UDP headers)
+constexpr size_t SCALAR_SIZE = 64;
+
+
+// swap bytes of 16 bit words
+void swap16(uint16_t *dst, const uint16_t *src, int count) {
+    int i = 0;
+#if defined(COCO_PACKET_SSE2)
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), x);
+    }
+#elif defined(COCO_PACKET_NEON)
+    for (; i + 8 <= count; i += 8)
+        vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), vrev16q_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(src + i))));
+#endif
+    for (; i < count; ++i)
+        dst[i] = uint16_t(src[i] >> 8 | src[i] << 8);
+}
+
+// swap bytes of 32 bit words
+void swap32(uint32_t *dst, const uint32_t *src, int count) {
+    int i = 0;
+#if defined(COCO_PACKET_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        x = _mm_or_si128(_mm_slli_epi32(x, 16), _mm_srli_epi32(x, 16));
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), x);
+    }
+#elif defined(COCO_PACKET_NEON)
+    for (; i + 4 <= count; i += 4)
+        vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), vrev32q_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(src + i))));
+#endif
+    for (; i < count; ++i)
+        dst[i] = hostToNetwork(src[i]);
+}
+
+} // namespace
+
+
+uint32_t checksumAdd(const void *data, size_t size, uint32_t sum) {
+    auto d = reinterpret_cast<const uint8_t *>(data);
+    uint64_t s = size < SCALAR_SIZE ? sumScalar(d, size, 0) : selected().kernel(d, size, 0);
+
+    // fold to 16 bits
+    s = (s & 0xffffffff) + (s >> 32);
+    s = (s & 0xffffffff) + (s >> 32);
+    s = (s & 0xffff) + (s >> 16);
+    s = (s & 0xffff) + (s >> 16);
+
+    // convert to host byte order so that partial sums can be combined with host values (e.g. of a pseudo header),
+    // little endian host is assumed like in Net16
+    uint32_t x = uint16_t(s >> 8 | s << 8);
+
+    // add to previous sum, fold once to prevent overflow when called repeatedly
+    uint64_t t = uint64_t(sum) + x;
+    return uint32_t((t & 0xffffffff) + (t >> 32));
+}
+
+const char *checksumKernel() {
+    return selected().name;
+}
+
+void hostToNetwork(Net16 *dst, const uint16_t *src, int count) {
+    swap16(reinterpret_cast<uint16_t *>(dst), src, count);
+}
+
+void hostToNetwork(Net32 *dst, const uint32_t *src, int count) {
+    swap32(reinterpret_cast<uint32_t *>(dst), src, count);
+}
+
+void networkToHost(uint16_t *dst, const Net16 *src, int count) {
+    swap16(dst, reinterpret_cast<const uint16_t *>(src), count);
+}
+
+void networkToHost(uint32_t *dst, const Net32 *src, int count) {
+    swap32(dst, reinterpret_cast<const uint32_t *>(src), count);
+}
+
+} // namespace ip
+} // namespace coco
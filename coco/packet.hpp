@@ -0,0 +1,281 @@
+#pragma once
+
+#include "ip.hpp"
+#include <cstddef>
+#include <cstdint>
+
+
+namespace coco {
+namespace ip {
+
+/// @brief Get a header view on packet data without copying.
+/// The data must be aligned to 4 bytes (e.g. the start of a buffer from a BufferPool or the network header of a
+/// packet ring).
+/// @tparam H header type such as ip::v4::Header or ip::udp::Header
+/// @param data packet data
+/// @param size size of the packet data
+/// @return header or nullptr if the data is too short
+template <typename H>
+H *view(void *data, int size) {
+    return size >= int(sizeof(H)) ? reinterpret_cast<H *>(data) : nullptr;
+}
+template <typename H>
+const H *view(const void *data, int size) {
+    return size >= int(sizeof(H)) ? reinterpret_cast<const H *>(data) : nullptr;
+}
+
+
+// checksum
+
+/// @brief Add data to a one's complement sum (RFC 1071) using the fastest kernel of the CPU (AVX2, SSE2, NEON or
+/// scalar). The data must start at an even offset of the checksummed range, an odd size gets padded with zero.
+/// @param data data
+/// @param size size of data in bytes
+/// @param sum partial sum of previous data, e.g. of a pseudo header
+/// @return partial sum that can be passed to checksumAdd() again or to checksumFinish()
+uint32_t checksumAdd(const void *data, size_t size, uint32_t sum = 0);
+
+/// @brief Fold a partial sum to 16 bits and complement it.
+/// @param sum partial sum
+/// @return checksum, e.g. header.checksum = checksumFinish(sum)
+constexpr uint16_t checksumFinish(uint32_t sum) {
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return uint16_t(~sum);
+}
+
+/// @brief Calculate the Internet checksum of data. Verification of data that contains the checksum results in 0.
+/// @param data data
+/// @param size size of data in bytes
+/// @return checksum
+inline uint16_t checksum(const void *data, size_t size) {
+    return checksumFinish(checksumAdd(data, size));
+}
+
+/// @brief Update a checksum when a 16 bit field changes, without recalculating it (RFC 1624).
+/// @param checksum current checksum
+/// @param from old value of the field
+/// @param to new value of the field
+/// @return new checksum
+constexpr uint16_t checksumUpdate(uint16_t checksum, uint16_t from, uint16_t to) {
+    // HC' = ~(~HC + ~m + m')
+    return checksumFinish(uint32_t(uint16_t(~checksum)) + uint16_t(~from) + to);
+}
+
+/// @brief Update a checksum when a 32 bit field changes, e.g. an IPv4 address (NAT).
+/// @param checksum current checksum
+/// @param from old value of the field
+/// @param to new value of the field
+/// @return new checksum
+constexpr uint16_t checksumUpdate(uint16_t checksum, uint32_t from, uint32_t to) {
+    return checksumFinish(uint32_t(uint16_t(~checksum)) + uint16_t(~(from >> 16)) + uint16_t(~from)
+        + (to >> 16) + (to & 0xffff));
+}
+
+/// @brief Get the name of the checksum kernel that was selected for the CPU.
+/// @return "avx2", "sse2", "neon" or "scalar"
+const char *checksumKernel();
+
+
+// bulk byte order conversion, uses SIMD where available
+
+void hostToNetwork(Net16 *dst, const uint16_t *src, int count);
+void hostToNetwork(Net32 *dst, const uint32_t *src, int count);
+void networkToHost(uint16_t *dst, const Net16 *src, int count);
+void networkToHost(uint32_t *dst, const Net32 *src, int count);
+
+
+namespace v4 {
+
+/// @brief IPv4 header (RFC 791), options follow if the header length is greater than 20
+///
+struct Header {
+    // version (4) in the upper 4 bits and header length in 32 bit words in the lower 4 bits
+    uint8_t versionLength;
+    uint8_t typeOfService;
+    Net16 totalLength;
+    Net16 identification;
+
+    // flags in the upper 3 bits and fragment offset in units of 8 bytes
+    Net16 fragment;
+    uint8_t timeToLive;
+    uint8_t protocol;
+    Net16 checksum;
+    Address source;
+    Address destination;
+
+
+    /// @brief Flag "don't fragment" in fragment field
+    static constexpr uint16_t DONT_FRAGMENT = 0x4000;
+
+    /// @brief Flag "more fragments" in fragment field
+    static constexpr uint16_t MORE_FRAGMENTS = 0x2000;
+
+    int version() const {return this->versionLength >> 4;}
+
+    /// @brief Get the header length including options.
+    /// @return header length in bytes
+    int headerLength() const {return (this->versionLength & 15) * 4;}
+
+    /// @brief Set version 4 and the header length.
+    /// @param headerLength header length in bytes including options (multiple of 4)
+    void setHeaderLength(int headerLength = sizeof(Header)) {this->versionLength = 0x40 | (headerLength / 4);}
+
+    /// @brief Set the checksum of the header including options.
+    ///
+    void updateChecksum() {
+        this->checksum = 0;
+        this->checksum = ip::checksum(this, headerLength());
+    }
+
+    /// @brief Verify the header length and the checksum.
+    /// @param size size of the available data, must contain the header including options
+    /// @return true if the header is valid
+    bool valid(int size) const {
+        int length = headerLength();
+        return version() == 4 && length >= int(sizeof(Header)) && length <= size
+            && ip::checksum(this, length) == 0;
+    }
+};
+static_assert(sizeof(Header) == 20);
+
+/// @brief Partial checksum of the pseudo header for UDP and TCP over IPv4.
+/// @param header IPv4 header that contains the addresses and the protocol
+/// @param length length of the UDP or TCP header and payload
+/// @return partial sum for checksumAdd()
+inline uint32_t pseudoHeaderSum(const Header &header, int length) {
+    return checksumAdd(&header.source, 8, uint32_t(header.protocol) + uint32_t(length));
+}
+
+} // namespace v4
+
+
+namespace v6 {
+
+/// @brief IPv6 header (RFC 8200), extension headers follow
+///
+struct Header {
+    // version (6) in the upper 4 bits, 8 bit traffic class and 20 bit flow label
+    Net32 versionClassFlow;
+    Net16 payloadLength;
+    uint8_t nextHeader;
+    uint8_t hopLimit;
+    Address source;
+    Address destination;
+
+
+    int version() const {return uint32_t(this->versionClassFlow) >> 28;}
+    int trafficClass() const {return (uint32_t(this->versionClassFlow) >> 20) & 0xff;}
+    uint32_t flowLabel() const {return uint32_t(this->versionClassFlow) & 0xfffff;}
+
+    /// @brief Set version 6, traffic class and flow label.
+    ///
+    void setVersionClassFlow(int trafficClass = 0, uint32_t flowLabel = 0) {
+        this->versionClassFlow = 0x60000000 | (uint32_t(trafficClass) << 20) | (flowLabel & 0xfffff);
+    }
+
+    /// @brief Verify the version and the payload length.
+    /// @param size size of the available data, must contain the header and the payload
+    /// @return true if the header is valid
+    bool valid(int size) const {
+        return size >= int(sizeof(Header)) && version() == 6 && int(sizeof(Header)) + this->payloadLength <= size;
+    }
+};
+static_assert(sizeof(Header) == 40);
+
+/// @brief Partial checksum of the pseudo header for UDP and TCP over IPv6.
+/// @param header IPv6 header that contains the addresses
+/// @param nextHeader protocol (the next header field of the last extension header)
+/// @param length length of the UDP or TCP header and payload
+/// @return partial sum for checksumAdd()
+inline uint32_t pseudoHeaderSum(const Header &header, uint8_t nextHeader, int length) {
+    return checksumAdd(&header.source, 32, uint32_t(nextHeader) + uint32_t(length & 0xffff) + uint32_t(length >> 16));
+}
+
+} // namespace v6
+
+
+namespace udp {
+
+/// @brief Protocol number of UDP in the IP header
+constexpr uint8_t PROTOCOL = 17;
+
+/// @brief UDP header (RFC 768)
+///
+struct Header {
+    Net16 sourcePort;
+    Net16 destinationPort;
+
+    // length of header and payload
+    Net16 length;
+    Net16 checksum;
+
+
+    /// @brief Set the checksum of header and payload.
+    /// A calculated checksum of 0 is transmitted as 0xffff because 0 means that the sender calculated no checksum.
+    /// @param pseudoHeaderSum partial sum of the pseudo header, see v4::pseudoHeaderSum() or v6::pseudoHeaderSum()
+    /// @param size size of header and payload
+    void updateChecksum(uint32_t pseudoHeaderSum, int size) {
+        this->checksum = 0;
+        uint16_t c = checksumFinish(checksumAdd(this, size, pseudoHeaderSum));
+        this->checksum = c == 0 ? 0xffff : c;
+    }
+};
+static_assert(sizeof(Header) == 8);
+
+} // namespace udp
+
+
+namespace tcp {
+
+/// @brief Protocol number of TCP in the IP header
+constexpr uint8_t PROTOCOL = 6;
+
+/// @brief TCP header (RFC 9293), options follow if the header length is greater than 20
+///
+struct Header {
+    Net16 sourcePort;
+    Net16 destinationPort;
+    Net32 sequenceNumber;
+    Net32 acknowledgementNumber;
+
+    // header length in 32 bit words in the upper 4 bits
+    uint8_t dataOffset;
+    uint8_t flags;
+    Net16 window;
+    Net16 checksum;
+    Net16 urgentPointer;
+
+
+    /// @brief Flags
+    static constexpr uint8_t FIN = 0x01;
+    static constexpr uint8_t SYN = 0x02;
+    static constexpr uint8_t RST = 0x04;
+    static constexpr uint8_t PSH = 0x08;
+    static constexpr uint8_t ACK = 0x10;
+    static constexpr uint8_t URG = 0x20;
+    static constexpr uint8_t ECE = 0x40;
+    static constexpr uint8_t CWR = 0x80;
+
+    /// @brief Get the header length including options.
+    /// @return header length in bytes
+    int headerLength() const {return (this->dataOffset >> 4) * 4;}
+
+    /// @brief Set the header length.
+    /// @param headerLength header length in bytes including options (multiple of 4)
+    void setHeaderLength(int headerLength = sizeof(Header)) {this->dataOffset = (headerLength / 4) << 4;}
+
+    /// @brief Set the checksum of header and payload.
+    /// @param pseudoHeaderSum partial sum of the pseudo header, see v4::pseudoHeaderSum() or v6::pseudoHeaderSum()
+    /// @param size size of header and payload
+    void updateChecksum(uint32_t pseudoHeaderSum, int size) {
+        this->checksum = 0;
+        this->checksum = checksumFinish(checksumAdd(this, size, pseudoHeaderSum));
+    }
+};
+static_assert(sizeof(Header) == 20);
+
+} // namespace tcp
+
+} // namespace ip
+} // namespace coco
@@ -13,7 +13,7 @@ class Project(ConanFile):
     default_options = {
         "platform": None}
     generators = "CMakeDeps", "CMakeToolchain"
-    exports_sources = "conanfile.py", "CMakeLists.txt", "coco/*", "test/*"
+    exports_sources = "conanfile.py", "CMakeLists.txt", "coco/*", "test/*", "benchmark/*"
 
 
     # check if we are cross compiling
@@ -32,6 +32,7 @@ class Project(ConanFile):
         if not self.cross():
             # platform is based on a "normal" operating system such as Windows, MacOS, Linux
             self.test_requires("gtest/1.17.0")
+            self.test_requires("benchmark/1.9.1")
 
     keep_imports = True
     def imports(self):
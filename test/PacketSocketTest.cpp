@@ -0,0 +1,64 @@
+#include <coco/convert.hpp>
+#include <coco/debug.hpp>
+#include "PacketSocketTest.hpp"
+#include <net/if.h>
+
+
+/*
+    PacketSocketTest: Captures all frames on the loopback interface through the receive ring and injects an Ethernet
+    frame with a local experimental EtherType once per second through the send ring. Needs CAP_NET_RAW, e.g. run with
+    sudo. Generate more traffic with e.g. ping 127.0.0.1.
+    The sender toggles the red LED, the receiver toggles the green LED.
+*/
+
+// local experimental EtherType (IEEE 802)
+constexpr uint16_t ETHER_TYPE = 0x88b5;
+
+Coroutine sender(Loop &loop, Buffer &buffer) {
+    // broadcast destination, locally administered source, EtherType, payload
+    const uint8_t frame[] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x01,
+        ETHER_TYPE >> 8, ETHER_TYPE & 0xff,
+        'c', 'o', 'c', 'o', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    while (true) {
+        co_await buffer.writeArray(frame);
+        debug::toggleRed();
+        debug::out << "Sent " << dec(buffer.size()) << '\n';
+        co_await loop.sleep(1s);
+    }
+}
+
+Coroutine receiver(Loop &loop, Buffer &buffer) {
+    while (true) {
+        // the buffer points into the receive ring until it is started again
+        co_await buffer.read();
+        auto &header = buffer.header<PacketSocket_Linux::Header>();
+        debug::toggleGreen();
+        debug::out << "Received " << dec(buffer.size()) << " of " << dec(header.length) << " protocol " << dec(header.protocol)
+            << " type " << dec(header.packetType);
+        if (header.protocol == ETHER_TYPE)
+            debug::out << " (test frame)";
+        debug::out << '\n';
+    }
+}
+
+int main() {
+    debug::out << "PacketSocketTest\n";
+
+    // small rings for testing
+    PacketSocket_Linux::Config config;
+    config.blockCount = 4;
+    config.blockSize = 1 << 16;
+    config.frameCount = 16;
+    if (!drivers.socket.open(if_nametoindex("lo"), config)) {
+        debug::out << "Open failed (needs CAP_NET_RAW)\n";
+        return 1;
+    }
+
+    sender(drivers.loop, drivers.buffer1);
+    receiver(drivers.loop, drivers.buffer2);
+
+    drivers.loop.run();
+}
@@ -2,9 +2,30 @@
 #include <coco/Buffer.hpp>
 #include <coco/BufferReader.hpp>
 #include <coco/BufferWriter.hpp>
+#include <coco/AccessList.hpp>
 #include <coco/ArrayConcept.hpp>
 #include <coco/StreamOperators.hpp>
+#include <coco/BufferPool.hpp>
+#include <coco/BufferChain.hpp>
+#include <coco/dns.hpp>
+#include <coco/EndpointMap.hpp>
 #include <coco/ip.hpp>
+#include <coco/packet.hpp>
+#include <coco/SocketStatistics.hpp>
+#include <coco/UdpSocket.hpp>
+#include <cstring>
+#ifdef __linux__
+#include <coco/platform/BufferChannel_Linux.hpp>
+#include <coco/platform/IpSocket_IoUring.hpp>
+#include <coco/platform/UdpSocket_IoUring.hpp>
+#include <coco/platform/UdpSocket_Linux.hpp>
+#include <coco/Resolver.hpp>
+#include <memory>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <thread>
+#endif
 
 
 using namespace coco;
@@ -70,6 +91,1151 @@ TEST(cocoTest, ipEndpoint) {
     EXPECT_EQ(ep.protocolId, 0);
 }
 
+TEST(cocoTest, ipV4Mapped) {
+    auto ep4 = *ip::Endpoint::fromString("192.168.1.2:80");
+    auto ep6 = ep4.mapV4();
+    EXPECT_EQ(ep6.protocolId, ip::v6::PROTOCOL_ID);
+    EXPECT_TRUE(ep6.v6.address.v4Mapped());
+    EXPECT_EQ(ep6, *ip::Endpoint::fromString("[::ffff:192.168.1.2]:80"));
+    EXPECT_EQ(ep6.unmapV4(), ep4);
+
+    // other endpoints stay unchanged
+    auto ep = *ip::Endpoint::fromString("[::1]:80");
+    EXPECT_FALSE(ep.v6.address.v4Mapped());
+    EXPECT_EQ(ep.mapV4(), ep);
+    EXPECT_EQ(ep.unmapV4(), ep);
+    EXPECT_EQ(ep4.unmapV4(), ep4);
+}
+
+TEST(cocoTest, ipv4Parse) {
+    EXPECT_TRUE(ip::v4::Address::fromString("0.0.0.0"));
+    EXPECT_TRUE(ip::v4::Address::fromString("255.255.255.255"));
+    EXPECT_FALSE(ip::v4::Address::fromString(""));
+    EXPECT_FALSE(ip::v4::Address::fromString("1.2.3"));
+    EXPECT_FALSE(ip::v4::Address::fromString("1.2.3.4.5"));
+    EXPECT_FALSE(ip::v4::Address::fromString("1.2.3.256"));
+    EXPECT_FALSE(ip::v4::Address::fromString("01.2.3.4"));
+    EXPECT_FALSE(ip::v4::Address::fromString("1..3.4"));
+
+    auto ep = *ip::v4::Endpoint::fromString("192.168.1.2:8080");
+    EXPECT_EQ(ep.address.u32[0], 0xc0a80102);
+    EXPECT_EQ(ep.port, 8080);
+    EXPECT_EQ(ip::v4::Endpoint::fromString("192.168.1.2", 53)->port, 53);
+    EXPECT_FALSE(ip::v4::Endpoint::fromString("192.168.1.2:65536"));
+    EXPECT_FALSE(ip::v4::Endpoint::fromString("192.168.1.2:"));
+}
+
+TEST(cocoTest, ipv6Parse) {
+    auto a6 = *ip::v6::Address::fromString("2001:db8::ff00:42:8329");
+    EXPECT_EQ(a6.u16[0], 0x2001);
+    EXPECT_EQ(a6.u16[1], 0x0db8);
+    EXPECT_EQ(a6.u16[2], 0);
+    EXPECT_EQ(a6.u16[4], 0);
+    EXPECT_EQ(a6.u16[5], 0xff00);
+    EXPECT_EQ(a6.u16[7], 0x8329);
+
+    a6 = *ip::v6::Address::fromString("::ffff:192.168.1.2");
+    EXPECT_EQ(a6.u16[5], 0xffff);
+    EXPECT_EQ(a6.u32[3], 0xc0a80102);
+
+    EXPECT_TRUE(ip::v6::Address::fromString("::"));
+    EXPECT_TRUE(ip::v6::Address::fromString("1::"));
+    EXPECT_TRUE(ip::v6::Address::fromString("1:2:3:4:5:6:7::"));
+    EXPECT_TRUE(ip::v6::Address::fromString("1:2:3:4:5:6:7:8"));
+    EXPECT_FALSE(ip::v6::Address::fromString(""));
+    EXPECT_FALSE(ip::v6::Address::fromString(":"));
+    EXPECT_FALSE(ip::v6::Address::fromString("1:2:3:4:5:6:7"));
+    EXPECT_FALSE(ip::v6::Address::fromString("1:2:3:4:5:6:7:8:9"));
+    EXPECT_FALSE(ip::v6::Address::fromString("1:2:3:4:5:6:7:8::"));
+    EXPECT_FALSE(ip::v6::Address::fromString("1::2::3"));
+    EXPECT_FALSE(ip::v6::Address::fromString("12345::"));
+    EXPECT_FALSE(ip::v6::Address::fromString("::1:"));
+
+    auto ep = *ip::v6::Endpoint::fromString("[fe80::1%3]:443");
+    EXPECT_TRUE(ep.address.linkLocal());
+    EXPECT_EQ(ep.scopeId, 3);
+    EXPECT_EQ(ep.port, 443);
+    EXPECT_EQ(ip::v6::Endpoint::fromString("::1", 53)->port, 53);
+    EXPECT_EQ(ip::v6::Endpoint::fromString("[::1]", 53)->port, 53);
+    EXPECT_FALSE(ip::v6::Endpoint::fromString("[::1"));
+    EXPECT_FALSE(ip::v6::Endpoint::fromString("::1]:80"));
+    EXPECT_FALSE(ip::v6::Endpoint::fromString("[fe80::1%]:443"));
+    EXPECT_FALSE(ip::v6::Endpoint::fromString("[fe80::1%4294967296]:443"));
+    EXPECT_EQ(ip::v6::Endpoint::fromString("[fe80::1%4294967295]:443")->scopeId, 4294967295u);
+    EXPECT_FALSE(ip::v6::Endpoint::fromString("[::1]:"));
+
+    EXPECT_EQ(ip::Endpoint::fromString("127.0.0.1:80")->protocolId, ip::v4::PROTOCOL_ID);
+    EXPECT_EQ(ip::Endpoint::fromString("[::1]:80")->protocolId, ip::v6::PROTOCOL_ID);
+    EXPECT_FALSE(ip::Endpoint::fromString("localhost:80"));
+}
+
+TEST(cocoTest, ipToString) {
+    char buffer[ip::Endpoint::MAX_STRING_LENGTH];
+
+    EXPECT_EQ(ip::v4::Address::fromString("10.0.255.1")->toString(buffer), "10.0.255.1");
+    EXPECT_EQ(ip::v4::Endpoint::fromString("10.0.255.1:65535")->toString(buffer), "10.0.255.1:65535");
+
+    // RFC 5952: lower case, no leading zeros, longest (first) run of zeros is compressed
+    EXPECT_EQ(ip::v6::Address::fromString("2001:0DB8:0:0:1:0:0:1")->toString(buffer), "2001:db8::1:0:0:1");
+    EXPECT_EQ(ip::v6::Address::fromString("2001:db8:0:1:0:0:0:1")->toString(buffer), "2001:db8:0:1::1");
+    EXPECT_EQ(ip::v6::Address::fromString("2001:db8:0:1:1:1:1:1")->toString(buffer), "2001:db8:0:1:1:1:1:1");
+    EXPECT_EQ(ip::v6::Address::fromString("::")->toString(buffer), "::");
+    EXPECT_EQ(ip::v6::Address::fromString("1::")->toString(buffer), "1::");
+    EXPECT_EQ(ip::v6::Address::fromString("::ffff:1.2.3.4")->toString(buffer), "::ffff:1.2.3.4");
+    EXPECT_EQ(ip::v6::Endpoint::fromString("[fe80::1%3]:443")->toString(buffer), "[fe80::1%3]:443");
+    EXPECT_EQ(ip::Endpoint::fromString("[::1]:80")->toString(buffer), "[::1]:80");
+}
+
+TEST(cocoTest, ipLiteral) {
+    using namespace ip::literals;
+
+    // parsed at compile time
+    constexpr ip::Endpoint ep4 = "127.0.0.1:80"_ep;
+    constexpr ip::Endpoint ep6 = "[::1]:80"_ep;
+    static_assert(ep4.v4.protocolId == ip::v4::PROTOCOL_ID);
+    static_assert(ep6.v6.port == 80);
+
+    EXPECT_EQ(ep4.v4.address.u32[0], 0x7f000001);
+    EXPECT_EQ(ep6.v6.address.u8[15], 1);
+}
+
+TEST(cocoTest, ipEndpointHash) {
+    using namespace ip::literals;
+
+    // v4 address comparison
+    EXPECT_TRUE(*ip::v4::Address::fromString("1.2.3.4") == *ip::v4::Address::fromString("1.2.3.4"));
+    EXPECT_FALSE(*ip::v4::Address::fromString("1.2.3.4") == *ip::v4::Address::fromString("1.2.3.5"));
+
+    // padding is ignored
+    ip::Endpoint a = "1.2.3.4:80"_ep;
+    ip::Endpoint b = a;
+    b.v4.zero[3] = 0x55;
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_FALSE(a == "1.2.3.4:81"_ep);
+    EXPECT_NE(a.hash(), ("1.2.3.4:81"_ep).hash());
+
+    // flow info is ignored, scope id is not
+    ip::Endpoint c = "[fe80::1%2]:80"_ep;
+    ip::Endpoint d = c;
+    d.v6.flowInfo = 1234;
+    EXPECT_TRUE(c == d);
+    EXPECT_EQ(c.hash(), d.hash());
+    d.v6.scopeId = 3;
+    EXPECT_FALSE(c == d);
+
+    // different protocols
+    EXPECT_FALSE(a == c);
+}
+
+TEST(cocoTest, EndpointMap) {
+    EndpointMap<int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(*ip::Endpoint::fromString("1.2.3.4:80")), nullptr);
+
+    // insert enough endpoints so that the map has to grow several times
+    auto endpoint = [](int i) {
+        return i % 2 == 0
+            ? ip::Endpoint{.v4 = {.port = uint16_t(i), .address = {.u8 = {10, 0, uint8_t(i >> 8), uint8_t(i)}}}}
+            : ip::Endpoint{.v6 = {.port = 443, .address = {.u8 = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, uint8_t(i >> 8), uint8_t(i)}}}};
+    };
+    for (int i = 0; i < 1000; ++i) {
+        auto [value, inserted] = map.emplace(endpoint(i), i);
+        EXPECT_TRUE(inserted);
+    }
+    EXPECT_EQ(map.size(), 1000);
+    EXPECT_FALSE(map.emplace(endpoint(5), 0).second);
+    for (int i = 0; i < 1000; ++i) {
+        auto value = map.find(endpoint(i));
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, i);
+    }
+
+    // erase every other endpoint
+    for (int i = 0; i < 1000; i += 2)
+        EXPECT_TRUE(map.erase(endpoint(i)));
+    EXPECT_FALSE(map.erase(endpoint(0)));
+    EXPECT_EQ(map.size(), 500);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(map.contains(endpoint(i)), i % 2 == 1);
+
+    // iterate and erase while iterating
+    int count = 0;
+    for (auto it = map.begin(); it != map.end();) {
+        EXPECT_EQ(it->value % 2, 1);
+        ++count;
+        it = it->value < 500 ? map.erase(it) : ++it;
+    }
+    EXPECT_EQ(count, 500);
+    EXPECT_EQ(map.size(), 250);
+
+    // operator [] inserts a default constructed value
+    map[endpoint(2)] += 7;
+    EXPECT_EQ(*map.find(endpoint(2)), 7);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(cocoTest, ipPrefix) {
+    char buffer[ip::v6::Prefix::MAX_STRING_LENGTH];
+
+    // host bits are cleared
+    auto p4 = *ip::v4::Prefix::fromString("10.1.2.3/8");
+    EXPECT_EQ(p4.address.u32[0], 0x0a000000);
+    EXPECT_EQ(p4.length, 8);
+    EXPECT_EQ(p4.toString(buffer), "10.0.0.0/8");
+    EXPECT_EQ(ip::v4::Prefix::fromString("1.2.3.4")->length, 32);
+    EXPECT_EQ(ip::v4::Prefix::fromString("0.0.0.0/0")->length, 0);
+    EXPECT_FALSE(ip::v4::Prefix::fromString("1.2.3.4/33"));
+    EXPECT_FALSE(ip::v4::Prefix::fromString("1.2.3.4/"));
+    EXPECT_TRUE(p4.contains(*ip::v4::Address::fromString("10.255.0.1")));
+    EXPECT_FALSE(p4.contains(*ip::v4::Address::fromString("11.0.0.1")));
+
+    auto p6 = *ip::v6::Prefix::fromString("2001:db8:ffff::/33");
+    EXPECT_EQ(p6.toString(buffer), "2001:db8:8000::/33");
+    EXPECT_EQ(ip::v6::Prefix::fromString("::1")->length, 128);
+    EXPECT_FALSE(ip::v6::Prefix::fromString("::/129"));
+    EXPECT_FALSE(ip::v6::Prefix::fromString("::/"));
+    EXPECT_TRUE(p6.contains(*ip::v6::Address::fromString("2001:db8:8000::1")));
+    EXPECT_FALSE(p6.contains(*ip::v6::Address::fromString("2001:db8::1")));
+}
+
+TEST(cocoTest, PrefixTable) {
+    ip::v4::PrefixTable table4;
+    EXPECT_EQ(table4.lookup(*ip::v4::Address::fromString("10.0.0.1")), 0);
+    ip::v4::PrefixTable::Entry entries4[] = {
+        {*ip::v4::Prefix::fromString("10.0.0.0/8"), 1},
+        {*ip::v4::Prefix::fromString("10.1.2.128/25"), 3},
+        {*ip::v4::Prefix::fromString("10.1.0.0/16"), 2},
+        {*ip::v4::Prefix::fromString("10.1.2.3/32"), 4},
+    };
+    table4.build(entries4);
+    EXPECT_EQ(table4.lookup(*ip::v4::Address::fromString("9.0.0.1")), 0);
+    EXPECT_EQ(table4.lookup(*ip::v4::Address::fromString("10.0.0.1")), 1);
+    EXPECT_EQ(table4.lookup(*ip::v4::Address::fromString("10.1.0.1")), 2);
+    EXPECT_EQ(table4.lookup(*ip::v4::Address::fromString("10.1.2.2")), 2);
+    EXPECT_EQ(table4.lookup(*ip::v4::Address::fromString("10.1.2.3")), 4);
+    EXPECT_EQ(table4.lookup(*ip::v4::Address::fromString("10.1.2.200")), 3);
+
+    ip::v6::PrefixTable table6;
+    ip::v6::PrefixTable::Entry entries6[] = {
+        {*ip::v6::Prefix::fromString("2001:db8::/32"), 1},
+        {*ip::v6::Prefix::fromString("2001:db8:1::/48"), 2},
+        {*ip::v6::Prefix::fromString("2001:db8:1::1"), 3},
+        {*ip::v6::Prefix::fromString("2000::/3"), 4},
+    };
+    table6.build(entries6);
+    ip::v6::Address addresses[] = {
+        *ip::v6::Address::fromString("2001:db8:2::1"),
+        *ip::v6::Address::fromString("2001:db8:1::2"),
+        *ip::v6::Address::fromString("2001:db8:1::1"),
+        *ip::v6::Address::fromString("3fff::1"),
+        *ip::v6::Address::fromString("fe80::1"),
+    };
+    ip::PrefixValue values[5];
+    table6.lookup(addresses, values);
+    for (int i = 0; i < 5; ++i)
+        EXPECT_EQ(values[i], table6.lookup(addresses[i]));
+    EXPECT_EQ(values[0], 1);
+    EXPECT_EQ(values[1], 2);
+    EXPECT_EQ(values[2], 3);
+    EXPECT_EQ(values[3], 4);
+    EXPECT_EQ(values[4], 0);
+}
+
+TEST(cocoTest, AccessList) {
+    using namespace ip::literals;
+
+    // deny a network but allow a subnet
+    ip::AccessList list;
+    list.deny(*ip::v4::Prefix::fromString("10.0.0.0/8"));
+    list.allow(*ip::v4::Prefix::fromString("10.1.0.0/16"));
+    list.deny(*ip::v6::Prefix::fromString("2001:db8::/32"));
+    list.build();
+    EXPECT_TRUE(list.allowed("192.168.0.1:80"_ep));
+    EXPECT_FALSE(list.allowed("10.2.0.1:80"_ep));
+    EXPECT_TRUE(list.allowed("10.1.0.1:80"_ep));
+    EXPECT_FALSE(list.allowed("[2001:db8::1]:80"_ep));
+    EXPECT_TRUE(list.allowed("[2001:db9::1]:80"_ep));
+
+    // IPv4-mapped address is checked against the IPv4 prefixes
+    EXPECT_FALSE(list.allowed("[::ffff:10.2.0.1]:80"_ep));
+
+    // deny by default
+    ip::AccessList allowList(ip::AccessList::Action::DENY);
+    allowList.allow(*ip::v6::Prefix::fromString("fe80::/10"));
+    allowList.build();
+    ip::Endpoint endpoints[] = {"[fe80::1]:1"_ep, "[2001:db8::1]:1"_ep, "10.1.0.1:1"_ep};
+    const ip::Endpoint *senders[] = {&endpoints[0], &endpoints[1], &endpoints[2]};
+    bool results[3];
+    allowList.allowed(senders, results);
+    EXPECT_TRUE(results[0]);
+    EXPECT_FALSE(results[1]);
+    EXPECT_FALSE(results[2]);
+}
+
+TEST(cocoTest, checksum) {
+    // IPv4 header with known checksum 0xb861
+    alignas(4) uint8_t data[] = {0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11, 0x00, 0x00,
+        0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7};
+    auto header = ip::view<ip::v4::Header>(data, sizeof(data));
+    ASSERT_NE(header, nullptr);
+    EXPECT_EQ(header->version(), 4);
+    EXPECT_EQ(header->headerLength(), 20);
+    EXPECT_EQ(header->protocol, ip::udp::PROTOCOL);
+    EXPECT_FALSE(header->valid(sizeof(data)));
+    header->updateChecksum();
+    EXPECT_EQ(header->checksum, 0xb861);
+    EXPECT_TRUE(header->valid(sizeof(data)));
+    EXPECT_EQ(ip::view<ip::v4::Header>(data, 19), nullptr);
+
+    // incremental update when decrementing the time to live
+    uint16_t checksum = ip::checksumUpdate(uint16_t(header->checksum), uint16_t(0x4011), uint16_t(0x3f11));
+    header->timeToLive = 0x3f;
+    header->updateChecksum();
+    EXPECT_EQ(header->checksum, checksum);
+
+    // incremental update when translating the source address
+    checksum = ip::checksumUpdate(uint16_t(header->checksum), uint32_t(header->source.u32[0]), uint32_t(0x0a000001));
+    header->source.u32[0] = 0x0a000001;
+    header->updateChecksum();
+    EXPECT_EQ(header->checksum, checksum);
+
+    // all sizes and odd split points against the scalar definition of RFC 1071
+    uint8_t buffer[1100];
+    for (int i = 0; i < int(sizeof(buffer)); ++i)
+        buffer[i] = i * 131 + (i >> 3);
+    for (int size = 0; size <= 1024; ++size) {
+        uint32_t sum = 0;
+        for (int i = 0; i < size; ++i)
+            sum += (i & 1) == 0 ? buffer[i + 1] << 8 : buffer[i + 1];
+        while (sum >> 16)
+            sum = (sum & 0xffff) + (sum >> 16);
+        EXPECT_EQ(ip::checksum(buffer + 1, size), uint16_t(~sum)) << "size " << size;
+
+        int split = (size / 3) & ~1;
+        EXPECT_EQ(ip::checksumFinish(ip::checksumAdd(buffer + 1 + split, size - split,
+            ip::checksumAdd(buffer + 1, split))), uint16_t(~sum));
+    }
+
+    // UDP over IPv6, verification of the datagram including pseudo header results in 0
+    alignas(4) uint8_t packet[40 + 8 + 5] = {};
+    auto ip6 = ip::view<ip::v6::Header>(packet, sizeof(packet));
+    ip6->setVersionClassFlow(0, 12345);
+    ip6->payloadLength = 8 + 5;
+    ip6->nextHeader = ip::udp::PROTOCOL;
+    ip6->source = *ip::v6::Address::fromString("2001:db8::1");
+    ip6->destination = *ip::v6::Address::fromString("2001:db8::2");
+    EXPECT_TRUE(ip6->valid(sizeof(packet)));
+    EXPECT_EQ(ip6->flowLabel(), 12345u);
+    auto udp = ip::view<ip::udp::Header>(packet + 40, sizeof(packet) - 40);
+    udp->sourcePort = 1000;
+    udp->destinationPort = 2000;
+    udp->length = 8 + 5;
+    std::memcpy(packet + 48, "hello", 5);
+    uint32_t pseudo = ip::v6::pseudoHeaderSum(*ip6, ip::udp::PROTOCOL, 13);
+    udp->updateChecksum(pseudo, 13);
+    EXPECT_NE(udp->checksum, 0);
+    EXPECT_EQ(ip::checksumFinish(ip::checksumAdd(udp, 13, pseudo)), 0);
+
+    // bulk byte order conversion
+    uint32_t values[9];
+    for (int i = 0; i < 9; ++i)
+        values[i] = 0x01020304 * (i + 1);
+    ip::Net32 net[9];
+    ip::hostToNetwork(net, values, 9);
+    uint32_t back[9];
+    ip::networkToHost(back, net, 9);
+    for (int i = 0; i < 9; ++i) {
+        EXPECT_EQ(net[i], values[i]);
+        EXPECT_EQ(back[i], values[i]);
+    }
+}
+
+// buffer with UDP socket header for testing
+class UdpTestBuffer : public Buffer {
+public:
+    UdpTestBuffer(int size) : Buffer(&header_, sizeof(header_), 0, data_, std::size(data_), State::READY) {
+        setReady(size);
+    }
+    bool start(Op op) override {return false;}
+    bool cancel() override {return false;}
+
+    UdpSocket::Header header_ = {};
+    uint8_t data_[1024];
+};
+
+TEST(cocoTest, udpDatagrams) {
+    UdpTestBuffer buffer(1050);
+
+    // one datagram
+    int count = 0;
+    for (auto datagram : UdpSocket::Datagrams(buffer)) {
+        EXPECT_EQ(datagram.size(), 1050);
+        ++count;
+    }
+    EXPECT_EQ(count, 1);
+
+    // coalesced datagrams, last one is shorter
+    buffer.header<UdpSocket::Header>().segmentSize = 100;
+    count = 0;
+    for (auto datagram : UdpSocket::Datagrams(buffer)) {
+        EXPECT_EQ(datagram.data(), buffer.data() + count * 100);
+        EXPECT_EQ(datagram.size(), count < 10 ? 100 : 50);
+        ++count;
+    }
+    EXPECT_EQ(count, 11);
+
+    // empty datagram
+    UdpTestBuffer empty(0);
+    count = 0;
+    for (auto datagram : UdpSocket::Datagrams(empty)) {
+        EXPECT_EQ(datagram.size(), 0);
+        ++count;
+    }
+    EXPECT_EQ(count, 1);
+}
+
+TEST(cocoTest, BufferPool) {
+    BufferPool pool(1000, 4);
+
+    // block size is rounded up to cache lines
+    EXPECT_EQ(pool.blockSize(), 1024);
+    EXPECT_EQ(pool.blockCount(), 4);
+
+    // allocate all blocks
+    uint8_t *blocks[4];
+    for (auto &block : blocks) {
+        block = pool.allocate();
+        ASSERT_NE(block, nullptr);
+        EXPECT_EQ(uintptr_t(block) % BufferPool::CACHE_LINE_SIZE, 0);
+    }
+    EXPECT_EQ(pool.freeCount(), 0);
+    EXPECT_EQ(pool.allocate(), nullptr);
+
+    // free and allocate again
+    pool.free(blocks[2]);
+    EXPECT_EQ(pool.freeCount(), 1);
+    EXPECT_EQ(pool.allocate(), blocks[2]);
+}
+
+TEST(cocoTest, BufferPoolMemory) {
+    // caller-provided memory that is not aligned
+    alignas(64) static uint8_t memory[64 * 10 + 1];
+    BufferPool pool(memory + 1, sizeof(memory) - 1, 100);
+
+    EXPECT_EQ(pool.blockSize(), 128);
+    EXPECT_EQ(pool.blockCount(), 4);
+    auto block = pool.allocate();
+    EXPECT_EQ(block, memory + 64);
+}
+
+#ifdef __linux__
+TEST(cocoTest, BufferPoolLazy) {
+    // blocks of one page each
+    int pageSize = int(sysconf(_SC_PAGESIZE));
+    BufferPool pool(pageSize, 64, pageSize);
+    auto first = pool.allocate();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(pool.freeCount(), 63);
+
+    // the pages of blocks that were not allocated yet are not resident
+    unsigned char resident[64];
+    ASSERT_EQ(mincore(first, size_t(pageSize) * 64, resident), 0);
+    for (int i = 1; i < 64; ++i)
+        EXPECT_EQ(resident[i] & 1, 0);
+
+    // the remaining blocks are handed out in ascending order, freed blocks first
+    auto second = pool.allocate();
+    EXPECT_EQ(second, first + pageSize);
+    pool.free(first);
+    EXPECT_EQ(pool.allocate(), first);
+    for (int i = 2; i < 64; ++i)
+        EXPECT_EQ(pool.allocate(), first + i * pageSize);
+    EXPECT_EQ(pool.allocate(), nullptr);
+    EXPECT_EQ(pool.freeCount(), 0);
+}
+#endif
+
+TEST(cocoTest, Histogram) {
+    using Histogram = SocketStatistics::Histogram;
+
+    // small values have their own bucket
+    EXPECT_EQ(Histogram::index(0), 0);
+    EXPECT_EQ(Histogram::index(15), 15);
+    EXPECT_EQ(Histogram::index(16), 16);
+
+    // each value lies within its bucket
+    for (uint64_t value : {17ull, 100ull, 1000ull, 123456ull, 1000000000ull}) {
+        int index = Histogram::index(value);
+        EXPECT_LE(Histogram::lowerBound(index), value);
+        EXPECT_GT(Histogram::lowerBound(index + 1), value);
+        EXPECT_LT(Histogram::lowerBound(index + 1) - Histogram::lowerBound(index), value / 16 + 1);
+    }
+
+    // large values go into the last bucket
+    EXPECT_EQ(Histogram::index(~uint64_t(0)), Histogram::BUCKET_COUNT - 1);
+
+    // percentiles of 1..100
+    Histogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0);
+    for (int i = 1; i <= 100; ++i)
+        histogram.record(i);
+    EXPECT_EQ(histogram.count(), 100);
+    uint64_t p50 = histogram.percentile(50);
+    uint64_t p99 = histogram.percentile(99);
+    EXPECT_GE(p50, 50);
+    EXPECT_LE(p50, 53);
+    EXPECT_GE(p99, 99);
+    EXPECT_LE(p99, 103);
+    EXPECT_EQ(histogram.percentile(0), 1);
+}
+
+TEST(cocoTest, SocketStatistics) {
+    EXPECT_EQ(SocketStatistics::classify(ECONNREFUSED), SocketStatistics::Error::UNREACHABLE);
+    EXPECT_EQ(SocketStatistics::classify(EPIPE), SocketStatistics::Error::RESET);
+    EXPECT_EQ(SocketStatistics::classify(ENOBUFS), SocketStatistics::Error::NO_BUFFERS);
+    EXPECT_EQ(SocketStatistics::classify(EMSGSIZE), SocketStatistics::Error::MESSAGE_SIZE);
+    EXPECT_EQ(SocketStatistics::classify(EINVAL), SocketStatistics::Error::OTHER);
+
+    SocketStatistics statistics;
+
+    // two datagrams received with GRO, one sent, one failed
+    auto started = statistics.start();
+    statistics.received(2, 200, started);
+    started = statistics.start();
+    statistics.sent(1, 50, started);
+    statistics.start();
+    statistics.failed(SocketStatistics::Error::UNREACHABLE);
+    statistics.finished();
+    statistics.start();
+    statistics.dropped(3);
+
+    auto snapshot = statistics.snapshot();
+    EXPECT_EQ(snapshot.received.packets, 2);
+    EXPECT_EQ(snapshot.received.bytes, 200);
+    EXPECT_EQ(snapshot.sent.packets, 1);
+    EXPECT_EQ(snapshot.sent.bytes, 50);
+    EXPECT_EQ(snapshot.errors[int(SocketStatistics::Error::UNREACHABLE)], 1);
+    EXPECT_EQ(snapshot.errors[int(SocketStatistics::Error::OTHER)], 0);
+    EXPECT_EQ(snapshot.drops, 3);
+    EXPECT_EQ(snapshot.inFlight, 1);
+    EXPECT_EQ(snapshot.latency.count(), 2);
+}
+
+// exposes the protected methods that the sockets use
+struct TestChain : public BufferChain {
+    using BufferChain::getChainCapacity;
+    using BufferChain::getVectors;
+    using BufferChain::split;
+};
+
+TEST(cocoTest, BufferChain) {
+    uint8_t header[8];
+    uint8_t payload1[100];
+    uint8_t payload2[50];
+    std::span<uint8_t> chain[] = {payload1, payload2};
+    TestChain buffer;
+    buffer.setChain(chain);
+    EXPECT_EQ(buffer.chain().size(), 2);
+    EXPECT_EQ(buffer.getChainCapacity(), 150);
+
+    struct Vector {
+        uint8_t *data;
+        int size;
+    };
+    auto vector = [](uint8_t *data, int size) {return Vector{data, size};};
+    Vector vectors[BufferChain::MAX_COUNT + 1];
+
+    // all data
+    EXPECT_EQ(buffer.getVectors(vectors, header, 8, 0, vector), 3);
+    EXPECT_EQ(vectors[0].data, header);
+    EXPECT_EQ(vectors[0].size, 8);
+    EXPECT_EQ(vectors[1].data, payload1);
+    EXPECT_EQ(vectors[1].size, 100);
+    EXPECT_EQ(vectors[2].data, payload2);
+    EXPECT_EQ(vectors[2].size, 50);
+
+    // continue after a partial send that ended in the first span of the chain
+    EXPECT_EQ(buffer.getVectors(vectors, header, 8, 18, vector), 2);
+    EXPECT_EQ(vectors[0].data, payload1 + 10);
+    EXPECT_EQ(vectors[0].size, 90);
+    EXPECT_EQ(vectors[1].data, payload2);
+
+    // split a receive into the buffer and the chain
+    EXPECT_EQ(buffer.split(5, 8), 5);
+    EXPECT_EQ(buffer.chainSize(), 0);
+    EXPECT_EQ(buffer.split(58, 8), 8);
+    EXPECT_EQ(buffer.chainSize(), 50);
+
+    // no chain
+    buffer.setChain({});
+    EXPECT_EQ(buffer.getVectors(vectors, header, 8, 0, vector), 1);
+    EXPECT_EQ(buffer.getChainCapacity(), 0);
+}
+
+TEST(cocoTest, dnsName) {
+    EXPECT_TRUE(ip::dns::valid("example.com"));
+    EXPECT_TRUE(ip::dns::valid("example.com."));
+    EXPECT_FALSE(ip::dns::valid(""));
+    EXPECT_FALSE(ip::dns::valid("."));
+    EXPECT_FALSE(ip::dns::valid("example..com"));
+    EXPECT_FALSE(ip::dns::valid(".example.com"));
+    EXPECT_TRUE(ip::dns::equal("Example.COM.", "example.com"));
+    EXPECT_FALSE(ip::dns::equal("example.com", "example.org"));
+}
+
+TEST(cocoTest, dnsQuery) {
+    uint8_t data[ip::dns::MAX_MESSAGE_SIZE];
+    int size = ip::dns::encodeQuery(data, sizeof(data), 0x1234, "www.example.com", ip::dns::Type::AAAA);
+
+    // header, question and OPT record
+    const uint8_t expected[] = {
+        0x12, 0x34, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 1,
+        3, 'w', 'w', 'w', 7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0, 0, 28, 0, 1,
+        0, 0, 41, 0x04, 0xd0, 0, 0, 0, 0, 0, 0};
+    ASSERT_EQ(size, sizeof(expected));
+    EXPECT_EQ(std::memcmp(data, expected, size), 0);
+    EXPECT_EQ(ip::dns::getId(data, size), 0x1234);
+
+    // buffer too small or invalid name
+    EXPECT_EQ(ip::dns::encodeQuery(data, size - 1, 0x1234, "www.example.com", ip::dns::Type::AAAA), 0);
+    EXPECT_EQ(ip::dns::encodeQuery(data, sizeof(data), 0x1234, "www..com", ip::dns::Type::A), 0);
+}
+
+TEST(cocoTest, dnsResponse) {
+    // www.example.com is an alias of example.com with two addresses, the names are compressed
+    const uint8_t response[] = {
+        0x12, 0x34, 0x81, 0x80, 0, 1, 0, 3, 0, 0, 0, 0,
+        3, 'w', 'w', 'w', 7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0, 0, 1, 0, 1,
+        0xc0, 12, 0, 5, 0, 1, 0, 0, 0x0e, 0x10, 0, 2, 0xc0, 16,
+        0xc0, 16, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 93, 184, 215, 14,
+        0xc0, 16, 0, 1, 0, 1, 0, 0, 0, 30, 0, 4, 93, 184, 215, 15};
+    ip::dns::Response r;
+    ASSERT_TRUE(ip::dns::parseResponse(response, sizeof(response), "WWW.example.com.", ip::dns::Type::A, r));
+    EXPECT_EQ(r.id, 0x1234);
+    EXPECT_EQ(r.code, ip::dns::ResponseCode::NO_ERROR);
+    EXPECT_FALSE(r.truncated);
+    ASSERT_EQ(r.addresses.size(), 2);
+    EXPECT_EQ(r.addresses[0], ip::Endpoint::fromString("93.184.215.14").value());
+    EXPECT_EQ(r.addresses[1], ip::Endpoint::fromString("93.184.215.15").value());
+    EXPECT_EQ(r.ttl, 30);
+
+    // question does not match
+    EXPECT_FALSE(ip::dns::parseResponse(response, sizeof(response), "example.com", ip::dns::Type::A, r));
+    EXPECT_FALSE(ip::dns::parseResponse(response, sizeof(response), "www.example.com", ip::dns::Type::AAAA, r));
+
+    // truncated message
+    EXPECT_FALSE(ip::dns::parseResponse(response, sizeof(response) - 1, "www.example.com", ip::dns::Type::A, r));
+}
+
+TEST(cocoTest, dnsNegativeResponse) {
+    // name error with SOA record in the authority section, minimum TTL is 300
+    const uint8_t response[] = {
+        0xab, 0xcd, 0x81, 0x83, 0, 1, 0, 0, 0, 1, 0, 0,
+        1, 'x', 7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0, 0, 1, 0, 1,
+        0xc0, 14, 0, 6, 0, 1, 0, 0, 0x0e, 0x10, 0, 27,
+        2, 'n', 's', 0xc0, 14, 0xc0, 14,
+        0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4, 0, 0, 0x01, 0x2c};
+    ip::dns::Response r;
+    ASSERT_TRUE(ip::dns::parseResponse(response, sizeof(response), "x.example", ip::dns::Type::A, r));
+    EXPECT_EQ(r.code, ip::dns::ResponseCode::NAME_ERROR);
+    EXPECT_TRUE(r.addresses.empty());
+    EXPECT_EQ(r.ttl, 300);
+
+    // compression pointer loop
+    uint8_t loop[] = {0, 1, 0x81, 0x80, 0, 1, 0, 0, 0, 0, 0, 0, 0xc0, 12, 0, 1, 0, 1};
+    EXPECT_FALSE(ip::dns::parseResponse(loop, sizeof(loop), "x", ip::dns::Type::A, r));
+}
+
+#ifdef __linux__
+Coroutine readAndCancel(Buffer &buffer, Buffer &sibling) {
+    co_await buffer.read();
+
+    // cancel a buffer that has received its datagram in the same batch
+    sibling.cancel();
+}
+
+Coroutine readAndExit(Loop &loop, Buffer &buffer) {
+    co_await buffer.read();
+    loop.exit();
+}
+
+Coroutine timeout(Loop &loop) {
+    co_await loop.sleep(1s);
+    loop.exit();
+}
+
+TEST(cocoTest, UdpSocketCancelInBatch) {
+    Loop_Linux loop;
+    UdpSocket_Linux socket(loop);
+    UdpSocket_Linux::Buffer buffer1(socket, 16);
+    UdpSocket_Linux::Buffer buffer2(socket, 16);
+    UdpSocket_Linux::Buffer buffer3(socket, 16);
+    uint16_t port = 15601;
+    ASSERT_TRUE(socket.open(ip::v4::PROTOCOL_ID, port));
+
+    // queue three datagrams so that they get received in one batch
+    int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr = {htonl(INADDR_LOOPBACK)}};
+    for (const char *data : {"1", "22", "333"})
+        sendto(sender, data, strlen(data), 0, (sockaddr *)&address, sizeof(address));
+    ::close(sender);
+
+    readAndCancel(buffer1, buffer2);
+    buffer2.start(Buffer::Op::READ);
+    readAndExit(loop, buffer3);
+    timeout(loop);
+    loop.run();
+
+    // the cancelled buffer completes with its datagram instead of losing it
+    EXPECT_EQ(buffer1.size(), 1);
+    EXPECT_TRUE(buffer2.ready());
+    EXPECT_EQ(buffer2.size(), 2);
+    EXPECT_EQ(buffer3.size(), 3);
+    EXPECT_EQ(std::memcmp(buffer3.data(), "333", 3), 0);
+}
+
+Coroutine writeAndCancel(Buffer &buffer, int size, Buffer &sibling) {
+    co_await buffer.write(size);
+
+    // cancel a buffer that was sent in the same batch
+    sibling.cancel();
+}
+
+Coroutine writeBuffer(Buffer &buffer, int size) {
+    co_await buffer.write(size);
+}
+
+Coroutine writeAndExit(Loop &loop, Buffer &buffer, int size) {
+    co_await buffer.write(size);
+    loop.exit();
+}
+
+TEST(cocoTest, UdpSocketCancelSendInBatch) {
+    Loop_Linux loop;
+    UdpSocket_Linux socket(loop);
+    UdpSocket_Linux::Buffer buffer1(socket, 16);
+    UdpSocket_Linux::Buffer buffer2(socket, 16);
+    UdpSocket_Linux::Buffer buffer3(socket, 16);
+    uint16_t port = 15603;
+    ASSERT_TRUE(socket.open(ip::v4::PROTOCOL_ID, 15602));
+
+    int receiver = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr = {htonl(INADDR_LOOPBACK)}};
+    ASSERT_EQ(bind(receiver, (sockaddr *)&address, sizeof(address)), 0);
+
+    // start three writes so that they get sent in one batch
+    auto endpoint = *ip::Endpoint::fromString("127.0.0.1:15603");
+    for (auto buffer : {&buffer1, &buffer2, &buffer3}) {
+        buffer->header<UdpSocket::Header>().endpoint = endpoint;
+        std::fill(buffer->data(), buffer->data() + 3, 'x');
+    }
+    writeAndCancel(buffer1, 1, buffer2);
+    writeBuffer(buffer2, 2);
+    writeAndExit(loop, buffer3, 3);
+    timeout(loop);
+    loop.run();
+
+    // the cancelled buffer completes with the size of its sent datagram
+    EXPECT_EQ(buffer1.size(), 1);
+    EXPECT_TRUE(buffer2.ready());
+    EXPECT_EQ(buffer2.size(), 2);
+    EXPECT_EQ(buffer3.size(), 3);
+
+    // all datagrams arrived
+    char data[16];
+    for (int size : {1, 2, 3})
+        EXPECT_EQ(recv(receiver, data, sizeof(data), MSG_DONTWAIT), size);
+    ::close(receiver);
+}
+
+// socket that splits buffers with segment size in user space as if segmentation offload was not supported
+class UdpSocketWithoutGso : public UdpSocket_Linux {
+public:
+    using UdpSocket_Linux::UdpSocket_Linux;
+    void disableGso() {gso_ = false;}
+};
+
+TEST(cocoTest, UdpSocketSegmentSize) {
+    Loop_Linux loop;
+    int receiver = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(15605), .sin_addr = {htonl(INADDR_LOOPBACK)}};
+    ASSERT_EQ(bind(receiver, (sockaddr *)&address, sizeof(address)), 0);
+
+    for (bool gso : {true, false}) {
+        UdpSocketWithoutGso socket(loop);
+        UdpSocket_Linux::Buffer buffer(socket, 256);
+        ASSERT_TRUE(socket.open(ip::v4::PROTOCOL_ID, 15604));
+        if (!gso)
+            socket.disableGso();
+
+        // send 250 bytes as datagrams of 100 bytes
+        buffer.header<UdpSocket::Header>().endpoint = *ip::Endpoint::fromString("127.0.0.1:15605");
+        buffer.header<UdpSocket::Header>().segmentSize = 100;
+        for (int i = 0; i < 250; ++i)
+            buffer.data()[i] = uint8_t(i);
+        writeAndExit(loop, buffer, 250);
+        timeout(loop);
+        loop.run();
+        EXPECT_EQ(buffer.size(), 250);
+
+        // the receiver gets three datagrams, the last one is shorter
+        uint8_t data[256];
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_EQ(recv(receiver, data, sizeof(data), MSG_DONTWAIT), i < 2 ? 100 : 50);
+            EXPECT_EQ(data[0], uint8_t(i * 100));
+        }
+        EXPECT_EQ(recv(receiver, data, sizeof(data), MSG_DONTWAIT), -1);
+    }
+    ::close(receiver);
+}
+
+// pop buffers until the given number was received, counts the buffers per producer
+Coroutine popBuffers(Loop &loop, BufferChannel_Linux &channel, Buffer **buffers, int *counts, int total) {
+    int count = 0;
+    while (count < total) {
+        co_await channel.untilNotEmpty();
+        while (auto buffer = channel.pop()) {
+            for (int i = 0; buffers[i] != nullptr; ++i) {
+                if (buffer == buffers[i])
+                    ++counts[i];
+            }
+            ++count;
+        }
+    }
+    loop.exit();
+}
+
+TEST(cocoTest, BufferChannel) {
+    constexpr int PRODUCER_COUNT = 4;
+    constexpr int PUSH_COUNT = 1000;
+    Loop_Linux loop;
+    UdpSocket_Linux socket(loop);
+    UdpSocket_Linux::Buffer buffer1(socket, 16);
+    UdpSocket_Linux::Buffer buffer2(socket, 16);
+    UdpSocket_Linux::Buffer buffer3(socket, 16);
+    UdpSocket_Linux::Buffer buffer4(socket, 16);
+    Buffer *buffers[] = {&buffer1, &buffer2, &buffer3, &buffer4, nullptr};
+
+    // capacity gets rounded up to a power of two
+    BufferChannel_Linux channel(loop, 5);
+    ASSERT_TRUE(channel.valid());
+    EXPECT_EQ(channel.capacity(), 8);
+
+    // push returns false when the ring is full
+    EXPECT_TRUE(channel.empty());
+    for (int i = 0; i < 8; ++i)
+        EXPECT_TRUE(channel.push(*buffers[i & 3]));
+    EXPECT_FALSE(channel.push(buffer1));
+    for (int i = 0; i < 8; ++i)
+        EXPECT_EQ(channel.pop(), buffers[i & 3]);
+    EXPECT_EQ(channel.pop(), nullptr);
+    EXPECT_TRUE(channel.empty());
+
+    // multiple producers push more buffers than fit into the ring and wake up the consumer
+    int counts[PRODUCER_COUNT] = {};
+    popBuffers(loop, channel, buffers, counts, PRODUCER_COUNT * PUSH_COUNT);
+    timeout(loop);
+    std::thread producers[PRODUCER_COUNT];
+    for (int i = 0; i < PRODUCER_COUNT; ++i) {
+        producers[i] = std::thread([&channel, buffer = buffers[i]] {
+            for (int j = 0; j < PUSH_COUNT; ++j) {
+                while (!channel.push(*buffer)) {
+                    channel.flush();
+                    std::this_thread::yield();
+                }
+            }
+            channel.flush();
+        });
+    }
+    loop.run();
+    for (auto &producer : producers)
+        producer.join();
+
+    // each buffer arrived once per push
+    for (int count : counts)
+        EXPECT_EQ(count, PUSH_COUNT);
+    EXPECT_TRUE(channel.empty());
+}
+
+// stub DNS server that answers each query with 192.0.2.1 or drops it
+Coroutine dnsServer(Buffer &buffer, bool answer, int &queryCount) {
+    while (true) {
+        co_await buffer.read();
+        if (!buffer.ready())
+            co_return;
+        ++queryCount;
+        if (!answer)
+            continue;
+
+        // response flags, the question without the OPT record of the query followed by one answer record with a
+        // pointer to the name of the question, type A, class IN, TTL 300
+        int size = buffer.size() - 11;
+        uint8_t *data = buffer.data();
+        data[2] = 0x81;
+        data[3] = 0x80;
+        data[7] = 1;
+        data[11] = 0;
+        const uint8_t record[] = {0xc0, 12, 0, 1, 0, 1, 0, 0, 1, 0x2c, 0, 4, 192, 0, 2, 1};
+        std::copy(std::begin(record), std::end(record), data + size);
+
+        // send back to the resolver
+        co_await buffer.write(size + int(sizeof(record)));
+    }
+}
+
+Coroutine resolveAndExit(Loop &loop, ip::Resolver &resolver, String name, ip::Resolver::Result &result) {
+    co_await resolver.resolve(name, 80, result, ip::Resolver::Family::V4);
+    loop.exit();
+}
+
+Coroutine resolveAndCount(ip::Resolver &resolver, String name, ip::Resolver::Result &result, int &count) {
+    co_await resolver.resolve(name, 80, result, ip::Resolver::Family::V4);
+    ++count;
+}
+
+Coroutine sleepAndExit(Loop &loop, Duration duration) {
+    co_await loop.sleep(duration);
+    loop.exit();
+}
+
+TEST(cocoTest, Resolver) {
+    Loop_Linux loop;
+    uint16_t serverPort = 15611;
+    auto server = *ip::Endpoint::fromString("127.0.0.1:15611");
+
+    // stub server
+    UdpSocket_Linux serverSocket(loop);
+    UdpSocket_Linux::Buffer serverBuffer(serverSocket, ip::dns::MAX_MESSAGE_SIZE);
+    ASSERT_TRUE(serverSocket.open(ip::v4::PROTOCOL_ID, serverPort));
+    int queryCount = 0;
+    dnsServer(serverBuffer, true, queryCount);
+
+    // resolver
+    UdpSocket_Linux socket(loop);
+    UdpSocket_Linux::Buffer sendBuffer(socket, 512);
+    UdpSocket_Linux::Buffer receiveBuffer(socket, ip::dns::MAX_MESSAGE_SIZE);
+    ASSERT_TRUE(socket.open(ip::v4::PROTOCOL_ID, 15612));
+    {
+        ip::Resolver resolver(loop, sendBuffer, receiveBuffer, server, 10ms, 2);
+
+        // resolve using the server
+        ip::Resolver::Result result;
+        resolveAndExit(loop, resolver, "example.com", result);
+        timeout(loop);
+        loop.run();
+        EXPECT_EQ(result.status, ip::Resolver::Status::OK);
+        ASSERT_EQ(result.endpoints.size(), 1);
+        EXPECT_EQ(result.endpoints[0], *ip::Endpoint::fromString("192.0.2.1:80"));
+        EXPECT_EQ(queryCount, 1);
+
+        // resolve from the cache
+        resolveAndExit(loop, resolver, "EXAMPLE.com.", result);
+        EXPECT_EQ(result.status, ip::Resolver::Status::OK);
+        EXPECT_EQ(result.endpoints.size(), 1);
+        EXPECT_EQ(queryCount, 1);
+    }
+    serverSocket.close();
+
+    // server that does not answer: the query is sent again and then times out
+    ASSERT_TRUE(serverSocket.open(ip::v4::PROTOCOL_ID, serverPort));
+    queryCount = 0;
+    dnsServer(serverBuffer, false, queryCount);
+    {
+        ip::Resolver resolver(loop, sendBuffer, receiveBuffer, server, 10ms, 2);
+        ip::Resolver::Result result;
+        resolveAndExit(loop, resolver, "example.com", result);
+        timeout(loop);
+        loop.run();
+        EXPECT_EQ(result.status, ip::Resolver::Status::TIMEOUT);
+        EXPECT_EQ(queryCount, 2);
+    }
+
+    // destroying the resolver completes outstanding resolutions with failure
+    auto resolver = std::make_unique<ip::Resolver>(loop, sendBuffer, receiveBuffer, server, 10ms, 2);
+    ip::Resolver::Result result1;
+    ip::Resolver::Result result2;
+    int count = 0;
+    resolveAndCount(*resolver, "a.example", result1, count);
+    resolveAndCount(*resolver, "b.example", result2, count);
+    sleepAndExit(loop, 5ms);
+    loop.run();
+    EXPECT_EQ(count, 0);
+    resolver.reset();
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(result1.status, ip::Resolver::Status::FAILED);
+    EXPECT_EQ(result2.status, ip::Resolver::Status::FAILED);
+
+    // the coroutines of the resolver that sleep return when their timer expires
+    sleepAndExit(loop, 20ms);
+    loop.run();
+    socket.close();
+    serverSocket.close();
+}
+
+TEST(cocoTest, UdpSocketIoUring) {
+    Loop_Linux loop;
+    IoUring_Linux ring(loop);
+    if (!ring.valid())
+        GTEST_SKIP() << "io_uring is not available";
+    UdpSocket_IoUring socket(ring);
+    UdpSocket_IoUring::Buffer receiveBuffer(socket, 16);
+    UdpSocket_IoUring sender(ring);
+    UdpSocket_IoUring::Buffer sendBuffer(sender, 16);
+    ASSERT_TRUE(socket.open(ip::v4::PROTOCOL_ID, 15606));
+    ASSERT_TRUE(sender.open(ip::v4::PROTOCOL_ID, 15607));
+    sendBuffer.header<UdpSocket::Header>().endpoint = *ip::Endpoint::fromString("127.0.0.1:15606");
+    std::copy_n("abc", 3, sendBuffer.data());
+
+    // send and receive
+    readAndExit(loop, receiveBuffer);
+    writeBuffer(sendBuffer, 3);
+    timeout(loop);
+    loop.run();
+    EXPECT_EQ(sendBuffer.size(), 3);
+    EXPECT_EQ(receiveBuffer.size(), 3);
+    EXPECT_EQ(std::memcmp(receiveBuffer.data(), "abc", 3), 0);
+
+    // cancel a pending read, it completes with zero size
+    receiveBuffer.start(Buffer::Op::READ);
+    sleepAndExit(loop, 10ms);
+    loop.run();
+    EXPECT_TRUE(receiveBuffer.busy());
+    receiveBuffer.cancel();
+    sleepAndExit(loop, 10ms);
+    loop.run();
+    EXPECT_TRUE(receiveBuffer.ready());
+    EXPECT_EQ(receiveBuffer.size(), 0);
+
+    // close with a read in flight and open again, the cancelled read must not take the next datagram
+    receiveBuffer.start(Buffer::Op::READ);
+    sleepAndExit(loop, 10ms);
+    loop.run();
+    socket.close();
+    EXPECT_FALSE(receiveBuffer.busy());
+    ASSERT_TRUE(socket.open(ip::v4::PROTOCOL_ID, 15606));
+    readAndExit(loop, receiveBuffer);
+    writeBuffer(sendBuffer, 3);
+    timeout(loop);
+    loop.run();
+    EXPECT_EQ(receiveBuffer.size(), 3);
+
+    // destroy a buffer and a socket with a read in flight, after closing and without closing (the completions have to
+    // arrive before, otherwise the sanitizers report a use after free)
+    for (bool close : {true, false}) {
+        auto other = std::make_unique<UdpSocket_IoUring>(ring);
+        auto otherBuffer = std::make_unique<UdpSocket_IoUring::Buffer>(*other, 16);
+        ASSERT_TRUE(other->open(ip::v4::PROTOCOL_ID, 15608));
+        otherBuffer->start(Buffer::Op::READ);
+        sleepAndExit(loop, 10ms);
+        loop.run();
+        if (close)
+            other->close();
+        otherBuffer.reset();
+        other.reset();
+    }
+
+    // the ring still works
+    readAndExit(loop, receiveBuffer);
+    writeBuffer(sendBuffer, 3);
+    timeout(loop);
+    loop.run();
+    EXPECT_EQ(receiveBuffer.size(), 3);
+}
+
+// create a TCP server socket on the loopback interface
+static int listenTcp(uint16_t port) {
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr = {htonl(INADDR_LOOPBACK)}};
+    if (bind(listener, (sockaddr *)&address, sizeof(address)) == -1 || listen(listener, 4) == -1) {
+        ::close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+TEST(cocoTest, IpSocketIoUring) {
+    Loop_Linux loop;
+    IoUring_Linux ring(loop);
+    if (!ring.valid())
+        GTEST_SKIP() << "io_uring is not available";
+    int listener1 = listenTcp(15609);
+    int listener2 = listenTcp(15610);
+    ASSERT_NE(listener1, -1);
+    ASSERT_NE(listener2, -1);
+    ip::v4::Endpoint server1 = {.port = 15609, .address = {.u8 = {127, 0, 0, 1}}};
+    ip::v4::Endpoint server2 = {.port = 15610, .address = {.u8 = {127, 0, 0, 1}}};
+    IpSocket_IoUring socket(ring);
+    IpSocket_IoUring::Buffer buffer(socket, 16);
+
+    // close while connecting and connect again immediately, the completion of the cancelled connect must not close
+    // the new connection
+    ASSERT_TRUE(socket.connect(server1));
+    socket.close();
+    ASSERT_TRUE(socket.connect(server2));
+
+    // send, the write waits until the connection is established
+    std::copy_n("abc", 3, buffer.data());
+    writeAndExit(loop, buffer, 3);
+    timeout(loop);
+    loop.run();
+    EXPECT_EQ(buffer.size(), 3);
+    int peer = accept(listener2, nullptr, nullptr);
+    ASSERT_NE(peer, -1);
+    char data[16];
+    EXPECT_EQ(recv(peer, data, sizeof(data), 0), 3);
+
+    // receive
+    send(peer, "hello", 5, 0);
+    readAndExit(loop, buffer);
+    timeout(loop);
+    loop.run();
+    EXPECT_EQ(buffer.size(), 5);
+    EXPECT_EQ(std::memcmp(buffer.data(), "hello", 5), 0);
+
+    // cancel a pending read, it completes with zero size
+    buffer.start(Buffer::Op::READ);
+    sleepAndExit(loop, 10ms);
+    loop.run();
+    EXPECT_TRUE(buffer.busy());
+    buffer.cancel();
+    sleepAndExit(loop, 10ms);
+    loop.run();
+    EXPECT_TRUE(buffer.ready());
+    EXPECT_EQ(buffer.size(), 0);
+
+    // close with a read in flight
+    buffer.start(Buffer::Op::READ);
+    sleepAndExit(loop, 10ms);
+    loop.run();
+    socket.close();
+    EXPECT_FALSE(buffer.busy());
+    ::close(peer);
+
+    // destroy a buffer and a socket with a read in flight, after closing and without closing
+    for (bool close : {true, false}) {
+        auto other = std::make_unique<IpSocket_IoUring>(ring);
+        auto otherBuffer = std::make_unique<IpSocket_IoUring::Buffer>(*other, 16);
+        ASSERT_TRUE(other->connect(server2));
+        otherBuffer->start(Buffer::Op::READ);
+        sleepAndExit(loop, 10ms);
+        loop.run();
+        if (close)
+            other->close();
+        otherBuffer.reset();
+        other.reset();
+    }
+    ::close(listener1);
+    ::close(listener2);
+}
+#endif
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     int success = RUN_ALL_TESTS();
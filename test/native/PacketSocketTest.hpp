@@ -0,0 +1,16 @@
+#pragma once
+
+#include <coco/platform/PacketSocket_Linux.hpp>
+
+
+using namespace coco;
+
+// drivers for PacketSocketTest
+struct Drivers {
+    Loop_native loop;
+    PacketSocket_Linux socket{loop};
+    PacketSocket_Linux::Buffer buffer1{socket, 128};
+    PacketSocket_Linux::Buffer buffer2{socket};
+};
+
+Drivers drivers;